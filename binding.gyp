@@ -6,7 +6,21 @@
 				"src/addon.cc",
 				"src/fanny.cc",
 				"src/utils.cc",
-				"src/training-data.cc"
+				"src/training-data.cc",
+				"src/train-state.cc",
+				"src/quantized.cc",
+				"src/ensemble.cc",
+				"src/parallel-cascade.cc",
+				"src/sparse.cc",
+				"src/csr-net.cc",
+				"src/shortcut-net.cc",
+				"src/training-data-builder.cc",
+				"src/text-data-parser.cc",
+				"src/train-data-blocks.cc",
+				"src/data-stats.cc",
+				"src/weight-init.cc",
+				"src/shared-ann.cc",
+				"src/model-file.cc"
 			],
 			"libraries": [
 				"../fann/lib/libfloatfann.a"
@@ -23,7 +37,21 @@
 				"src/addon.cc",
 				"src/fanny.cc",
 				"src/utils.cc",
-				"src/training-data.cc"
+				"src/training-data.cc",
+				"src/train-state.cc",
+				"src/quantized.cc",
+				"src/ensemble.cc",
+				"src/parallel-cascade.cc",
+				"src/sparse.cc",
+				"src/csr-net.cc",
+				"src/shortcut-net.cc",
+				"src/training-data-builder.cc",
+				"src/text-data-parser.cc",
+				"src/train-data-blocks.cc",
+				"src/data-stats.cc",
+				"src/weight-init.cc",
+				"src/shared-ann.cc",
+				"src/model-file.cc"
 			],
 			"libraries": [
 				"../fann/lib/libdoublefann.a"
@@ -40,7 +68,21 @@
 				"src/addon.cc",
 				"src/fanny.cc",
 				"src/utils.cc",
-				"src/training-data.cc"
+				"src/training-data.cc",
+				"src/train-state.cc",
+				"src/quantized.cc",
+				"src/ensemble.cc",
+				"src/parallel-cascade.cc",
+				"src/sparse.cc",
+				"src/csr-net.cc",
+				"src/shortcut-net.cc",
+				"src/training-data-builder.cc",
+				"src/text-data-parser.cc",
+				"src/train-data-blocks.cc",
+				"src/data-stats.cc",
+				"src/weight-init.cc",
+				"src/shared-ann.cc",
+				"src/model-file.cc"
 			],
 			"libraries": [
 				"../fann/lib/libfixedfann.a"
@@ -7,6 +7,11 @@ var FieldError = require('common-schema').FieldError;
 var XError = require('xerror');
 var utils = require('./utils');
 var createTrainingData = require('./training-data').createTrainingData;
+var SparseTrainingData = require('./training-data').SparseTrainingData;
+var QuantizedANN = require('./quantized-ann').QuantizedANN;
+var loadQuantizedANN = require('./quantized-ann').loadQuantizedANN;
+var SharedANN = require('./shared-ann').SharedANN;
+var ScoringStream = require('./scoring-stream').ScoringStream;
 var pasync = require('pasync');
 var ACTIVATION_FUNCTIONS = [
 	'LINEAR', 'THRESHOLD', 'THRESHOLD_SYMMETRIC', 'SIGMOID', 'SIGMOID_STEPWISE',
@@ -44,6 +49,10 @@ var annConfigSchema = createSchema({
 			default: 'float',
 			enum: [ 'float', 'double', 'fixed' ]
 		},
+		seed: {
+			type: Number,
+			min: 0
+		},
 		activationFunctions: {
 			type: 'map',
 			values: {
@@ -189,7 +198,7 @@ function validateNeuronConfigKey(val) {
 function wrapThrows(fn) {
 	return function() {
 		try {
-			return fn.apply(this, Array.prototype.slice.call(arguments, 0));
+			return fn.apply(this, arguments);
 		} catch (ex) {
 			if (!XError.isXError(ex)) {
 				throw new XError(ex);
@@ -200,58 +209,81 @@ function wrapThrows(fn) {
 	};
 }
 
-function nextQueueOp(ann) {
+// Runs a queued operation, and starts the next one when it finishes.  Returns a promise that settles
+// with the operation's result.
+function startQueueOp(ann, op, args) {
+	ann._currentlyRunning = true;
+	var result;
+	try {
+		result = op.fn.apply(ann, args);
+	} catch (ex) {
+		finishQueueOp(ann, op);
+		return Promise.reject(ex);
+	}
+	if (!result || typeof result.then !== 'function') {
+		finishQueueOp(ann, op);
+		return Promise.resolve(result);
+	}
+	return result.then(function(res) {
+		finishQueueOp(ann, op);
+		return res;
+	}, function(err) {
+		finishQueueOp(ann, op);
+		throw err;
+	});
+}
+
+function finishQueueOp(ann, op) {
+	if (!op.readOnly) ann._exclusiveOps--;
 	if (ann._opQueue.length) {
-		ann._currentlyRunning = true;
-		var op = ann._opQueue.shift();
-		var promise;
-		try {
-			promise = op.fn.apply(ann, op.args);
-		} catch (ex) {
-			op.waiter.reject(ex);
-			nextQueueOp(ann);
-			return;
-		}
-		if (!promise || typeof promise.then !== 'function') {
-			op.waiter.resolve(promise);
-			nextQueueOp(ann);
-			return;
-		}
-		promise.then(function(res) {
-			op.waiter.resolve(res);
-			nextQueueOp(ann);
-		}, function(err) {
-			op.waiter.reject(err);
-			nextQueueOp(ann);
-		}).catch(pasync.abort);
+		var queued = ann._opQueue.shift();
+		startQueueOp(ann, queued.op, queued.args).then(queued.waiter.resolve, queued.waiter.reject);
 	} else {
 		ann._currentlyRunning = false;
 	}
 }
 
-function asyncOpQueue(fn) {
-	fn = wrapThrows(fn);
+// Wraps fn as an operation on the ANN's queue.  Operations run one at a time in the order they're
+// called, and an operation called on an idle ANN starts immediately.  readOnly marks operations that
+// only run the network; run() and runBatch() can proceed while nothing else is queued (see
+// allowDuringRuns()).
+function asyncOpQueue(fn, readOnly) {
+	var op = { fn: wrapThrows(fn), readOnly: !!readOnly };
 	return function() {
-		var self = this;
+		// Coalesced runs can't join a group queued before this op (see ANN#setRunCoalescing())
+		this._runGroup = null;
+		if (!op.readOnly) this._exclusiveOps++;
+		if (!this._currentlyRunning) return startQueueOp(this, op, arguments);
 		var waiter = pasync.waiter();
-		self._opQueue.push({
-			fn: fn,
+		this._opQueue.push({
+			op: op,
 			args: Array.prototype.slice.call(arguments, 0),
 			waiter: waiter
 		});
-		if (!self._currentlyRunning) nextQueueOp(self);
 		return waiter.promise;
 	};
-};
+}
 
 function blockOnAsync(fn) {
 	return function() {
 		if (this._currentlyRunning) {
 			throw new XError(XError.INTERNAL_ERROR, 'Cannot execute this operation while training or running ann');
 		}
-		return fn.apply(this, Array.prototype.slice.call(arguments, 0));
+		return fn.apply(this, arguments);
 	};
-};
+}
+
+// Like blockOnAsync(), but lets synchronous runs go ahead while the queue only holds runs.  fn is
+// called with this._currentlyRunning set in that case, and must run the network with an engine that
+// doesn't disturb a run in progress on a worker thread (see FANNY::getConcurrentEngine()).
+function allowDuringRuns(fn) {
+	return function() {
+		if (this._currentlyRunning && (this._exclusiveOps || !this._fanny.canRunConcurrently())) {
+			throw new XError(XError.INTERNAL_ERROR, 'Cannot execute this operation while training or running ann');
+		}
+		return fn.apply(this, arguments);
+	};
+}
 
 function ANN(fanny, datatype) {
 	this.userData = {};
@@ -260,6 +292,10 @@ function ANN(fanny, datatype) {
 	this._recalculateInfo();
 	this._opQueue = [];
 	this._currentlyRunning = false;
+	// Number of queued or running operations that do more than run the network
+	this._exclusiveOps = 0;
+	this._runCoalescing = null;
+	this._runGroup = null;
 	var userDataString = this.getOption('userDataString');
 	if (userDataString && userDataString[0] === '{') {
 		this.userData = JSON.parse(userDataString);
@@ -573,6 +609,18 @@ ANN.prototype.clone = blockOnAsync(function() {
 	return new ANN(fanny, this._datatype);
 });
 
+// Same as clone(), but makes the copy on a worker thread.  Resolves with the new ANN.
+ANN.prototype.cloneAsync = asyncOpQueue(function() {
+	var self = this;
+	var addon = utils.getAddon(this._datatype);
+	return new Promise(function(resolve, reject) {
+		addon.FANNY.createAsync(self._fanny, function(err, fanny) {
+			if (err) return reject(new XError(err));
+			resolve(new ANN(fanny, self._datatype));
+		});
+	});
+});
+
 ANN.prototype._recalculateInfo = function() {
 	this.info = {};
 	var fns = {
@@ -593,25 +641,83 @@ ANN.prototype._recalculateInfo = function() {
 	}
 };
 
-ANN.prototype.save = asyncOpQueue(function(filename, toFixed) {
+// The second argument can be boolean true to save in fixed point, or an options object containing:
+// - toFixed - Save in fixed point
+// - trainState - Also save the training state (RPROP/Quickprop slopes and steps) to a sidecar file,
+//   so training can later be resumed without losing its progress.  See loadANN().
+// - mmap - Save as a binary model file that loadANN() can memory-map instead of parsing.  Model files
+//   are specific to the datatype and byte order they were saved with.
+ANN.prototype.save = asyncOpQueue(function(filename, options) {
 	var self = this;
+	if (typeof options !== 'object' || !options) options = { toFixed: !!options };
+	var toFixed = options.toFixed;
+	if (toFixed && options.trainState) {
+		throw new XError(XError.INVALID_ARGUMENT, 'Training state cannot be saved with fixed point networks');
+	}
+	if (options.mmap && (toFixed || options.trainState)) {
+		throw new XError(XError.INVALID_ARGUMENT, 'Model files cannot be saved in fixed point or with training state');
+	}
 	return new Promise(function(resolve, reject) {
 		var cb = function(err) {
 			if (err) return reject(err);
 			resolve();
 		};
-		var curUserDataString = self.getOption('userDataString');
-		if (!curUserDataString || curUserDataString[0] === '{') {
-			self._fanny.setUserDataString(JSON.stringify(self.userData));
-		}
+		self._syncUserDataString();
 		if (toFixed) {
 			self._fanny.saveToFixed(filename, cb);
+		} else if (options.mmap) {
+			self._fanny.saveModelFile(filename, cb);
+		} else if (options.trainState) {
+			self._fanny.save(filename, true, cb);
 		} else {
 			self._fanny.save(filename, cb);
 		}
 	});
 });
 
+ANN.prototype._syncUserDataString = function() {
+	var curUserDataString = this.getOption('userDataString');
+	if (!curUserDataString || curUserDataString[0] === '{') {
+		this._fanny.setUserDataString(JSON.stringify(this.userData));
+	}
+};
+
+// Serializes the network to a Buffer in FANN's network file format.  Pass true to serialize as fixed point.
+ANN.prototype.toBuffer = asyncOpQueue(function(toFixed) {
+	var self = this;
+	return new Promise(function(resolve, reject) {
+		self._syncUserDataString();
+		self._fanny.exportBuffer(!!toFixed, function(err, buffer) {
+			if (err) return reject(new XError(err));
+			resolve(buffer);
+		});
+	});
+});
+
+// Converts the network to another datatype ('float', 'double' or 'fixed') in memory, for example to
+// train in double precision and deploy in float.  Resolves with a new ANN.  Each datatype is a separate
+// native addon linked against its own FANN build, so the network is passed between them in FANN's
+// network format without going through a file.  Fixed point networks can't be converted back.
+ANN.prototype.toDatatype = asyncOpQueue(function(datatype) {
+	var self = this;
+	if (!datatype) datatype = 'float';
+	var addon = utils.getAddon(datatype);
+	if (datatype === self._datatype) return new ANN(new addon.FANNY(self._fanny), datatype);
+	if (self._datatype === 'fixed') {
+		throw new XError(XError.INVALID_ARGUMENT, 'Fixed point networks cannot be converted to other datatypes');
+	}
+	return new Promise(function(resolve, reject) {
+		self._syncUserDataString();
+		self._fanny.exportBuffer(datatype === 'fixed', function(err, buffer) {
+			if (err) return reject(new XError(err));
+			addon.FANNY.loadBuffer(buffer, function(err, fanny) {
+				if (err) return reject(new XError(err));
+				resolve(new ANN(fanny, datatype));
+			});
+		});
+	});
+});
+
 // data can either be a TrainingData class or a filename
 // options can include: maxEpochs, progressInterval (in epochs), desiredError, cascade (boolean true for cascade training),
 //   maxNeurons (for cascade training), stopFunction (either "MSE" or "BIT").  Without supplying an options object, this
@@ -623,11 +729,16 @@ ANN.prototype.save = asyncOpQueue(function(filename, toFixed) {
 //   this progress function returns false or -1, training is cancelled on the next iteration.
 //   Instead of a function, you can instead pass the special value "default", to enable the default libfann
 //   behavior of printing out progress information.
+// options.checkpoint enables periodic snapshots of the network and its training state during multi-epoch
+//   training.  It's an object containing "epochs" and/or "seconds" (the checkpoint interval), and either
+//   "filename" (checkpoints are written there by a background thread) or "ringSize" (the number of most
+//   recent checkpoints kept in memory, default 1).  Intervals are checked every progressInterval epochs.
 ANN.prototype.train = asyncOpQueue(function(data, options, progress) {
 	if (Array.isArray(data) && Array.isArray(options)) return this.trainOne(data, options);
 	var self = this;
 	var filename;
 	var addonTrainingData;
+	if (data instanceof SparseTrainingData) return this._trainSparse(data, options);
 	if (Array.isArray(data)) data = createTrainingData(data);
 	if (data && typeof data === 'object' && typeof data.setTrainData === 'function') {
 		addonTrainingData = data;
@@ -655,6 +766,29 @@ ANN.prototype.train = asyncOpQueue(function(data, options, progress) {
 	if (options.stopFunction) {
 		self._fanny.setTrainStopFunction('STOPFUNC_' + options.stopFunction);
 	}
+	if (options.cascade) {
+		var cascadeThreads = options.cascadeThreads || 0;
+		if (typeof cascadeThreads !== 'number' || cascadeThreads < 0) {
+			throw new XError(XError.INVALID_ARGUMENT, 'cascadeThreads must be a non-negative number');
+		}
+		self._fanny.setCascadeThreads(cascadeThreads);
+	}
+	if (options.checkpoint) {
+		var checkpoint = options.checkpoint;
+		if (!checkpoint.epochs && !checkpoint.seconds) {
+			throw new XError(XError.INVALID_ARGUMENT, 'checkpoint requires epochs or seconds');
+		}
+		// Checkpoints are taken from the native training callback, which replaces FANN's default reporting
+		if (progress === 'default') progress = printProgress;
+		self._fanny.setCheckpoint({
+			epochs: checkpoint.epochs || 0,
+			seconds: checkpoint.seconds || 0,
+			filename: checkpoint.filename || '',
+			ringSize: checkpoint.ringSize || 1
+		});
+	} else {
+		self._fanny.setCheckpoint();
+	}
 	if (progress === 'default') {
 		self._fanny.setCallback();
 	} else if (typeof progress === 'function') {
@@ -698,18 +832,243 @@ ANN.prototype.train = asyncOpQueue(function(data, options, progress) {
 	});
 });
 
-ANN.prototype.run = blockOnAsync(function(inputs) {
-	return this._fanny.run(inputs);
+// Trains on SparseTrainingData.  Only maxEpochs, desiredError and stopFunction apply; the training
+// is incremental backpropagation with the network's learning rate, and momentum isn't used.
+ANN.prototype._trainSparse = function(data, options) {
+	var self = this;
+	if (!options) options = { maxEpochs: 1 };
+	if (!options.maxEpochs && typeof options.desiredError !== 'number') options.desiredError = 0.01;
+	if (!options.maxEpochs) options.maxEpochs = 2000000000;
+	if (typeof options.desiredError !== 'number') options.desiredError = 0;
+	if (options.stopFunction) {
+		self._fanny.setTrainStopFunction('STOPFUNC_' + options.stopFunction);
+	}
+	return new Promise(function(resolve, reject) {
+		self._fanny.trainSparse(data._fannySparseTrainingData, options.maxEpochs, options.desiredError, function(err, res) {
+			if (err) return reject(new XError(err));
+			resolve(res);
+		});
+	});
+};
+
+function printProgress(info) {
+	console.log('Epochs ' + info.epochs + '. Current error: ' + info.mse + '. Bit fail ' + info.bitfail + '.');
+}
+
+// Returns an array of { epochs, mse } describing the checkpoints in the in-memory ring, oldest first.
+// This can be called while training is in progress.
+ANN.prototype.getCheckpoints = function() {
+	return this._fanny.getCheckpoints();
+};
+
+// Returns a new ANN restored from an in-memory checkpoint, including its training state, so training
+// can be resumed from it.  idx indexes into getCheckpoints(); defaults to the most recent.
+ANN.prototype.getCheckpoint = function(idx) {
+	if (idx === undefined || idx === null) idx = this._fanny.getCheckpoints().length - 1;
+	if (typeof idx !== 'number' || idx < 0) throw new XError(XError.NOT_FOUND, 'No such checkpoint');
+	var fanny = this._fanny.getCheckpoint(idx);
+	return new ANN(fanny, this._datatype);
+};
+
+// Returns a Buffer containing FANN's internal training state: the RPROP step sizes, slopes and
+// previous weight deltas.  Restoring it with setTrainState() lets training resume at the same rate
+// instead of restarting from rpropDeltaZero.  The format is native-endian and datatype specific.
+ANN.prototype.getTrainState = blockOnAsync(function() {
+	return this._fanny.getTrainState();
+});
+
+ANN.prototype.setTrainState = blockOnAsync(function(buffer) {
+	if (!Buffer.isBuffer(buffer)) throw new XError(XError.INVALID_ARGUMENT, 'Training state must be a Buffer');
+	this._fanny.setTrainState(buffer);
 });
 
-ANN.prototype.runAsync = asyncOpQueue(function(inputs) {
+// Sparse inputs are objects containing "indices" and "values" (arrays or typed arrays), listing the
+// non-zero inputs; batches of them are CSR objects that also contain "rowOffsets"
+function isSparseInput(inputs) {
+	return !!inputs && typeof inputs === 'object' && !Array.isArray(inputs) && !ArrayBuffer.isView(inputs) &&
+		!!inputs.indices && !!inputs.values;
+}
+
+function checkSparseOptions(options) {
+	if (options && options.scale) throw new XError(XError.INVALID_ARGUMENT, 'Sparse inputs cannot be scaled');
+}
+
+// inputs can be an array of inputs or a sparse input: { indices: [ ... ], values: [ ... ] }.  Sparse
+// inputs only visit the connections of their non-zero inputs.
+// options can include:
+// - scale - If true, the network's scaling parameters (see setScalingParams()) are applied to the
+//   inputs and outputs natively, in the same call.  Not supported for sparse inputs.
+//
+// run() can be called while the only queued operations are runs (runAsync(), runBatchAsync() and
+// scoring streams).  It then runs on the current thread with an engine that doesn't share state with
+// the run in progress.  It still throws while anything else is queued, and on fixed point networks.
+ANN.prototype.run = allowDuringRuns(wrapThrows(function(inputs, options) {
+	if (isSparseInput(inputs)) {
+		checkSparseOptions(options);
+		return this._fanny.runSparse(inputs.indices, inputs.values);
+	}
+	return this._fanny.run(inputs, !!(options && options.scale), this._currentlyRunning);
+}));
+
+var runAsyncQueued = asyncOpQueue(function(inputs, options) {
 	var self = this;
+	if (isSparseInput(inputs)) {
+		checkSparseOptions(options);
+		return new Promise(function(resolve, reject) {
+			var rowOffsets = [ 0, inputs.indices.length ];
+			self._fanny.runSparseBatchAsync(rowOffsets, inputs.indices, inputs.values, function(err, res) {
+				if (err) return reject(new XError(err));
+				resolve(Array.prototype.slice.call(res));
+			});
+		});
+	}
 	return new Promise(function(resolve, reject) {
-		self._fanny.runAsync(inputs, function(err, res) {
+		var cb = function(err, res) {
 			if (err) return reject(new XError(err));
 			resolve(res);
+		};
+		if (options && options.scale) {
+			self._fanny.runAsync(inputs, true, cb);
+		} else {
+			self._fanny.runAsync(inputs, cb);
+		}
+	});
+}, true);
+
+ANN.prototype.runAsync = function(inputs, options) {
+	var coalescing = this._runCoalescing;
+	if (
+		coalescing && (Array.isArray(inputs) || ArrayBuffer.isView(inputs)) &&
+		inputs.length === this.info.numInput
+	) {
+		return this._coalesceRun(inputs, !!(options && options.scale));
+	}
+	return runAsyncQueued.call(this, inputs, options);
+};
+
+/**
+ * Enables or disables coalescing of concurrent runAsync() calls.  When enabled, dense runAsync() calls made
+ * within `windowMs` of each other are run as one native batch of up to `maxBatch` rows, and each call's
+ * Promise resolves with its own outputs.  Calls keep their order relative to other operations on the ANN:
+ * a call never joins a batch queued before another operation.  Each batch waits up to windowMs for
+ * more calls, so this trades a little latency for throughput when many callers run the network at once.
+ *
+ * @method setRunCoalescing
+ * @param {Object|Boolean} options - false to disable, or true or an object to enable
+ *   @param {Number} [options.windowMs=1] - How long a batch collects calls
+ *   @param {Number} [options.maxBatch=64] - Maximum calls per batch; a full batch is run immediately
+ */
+ANN.prototype.setRunCoalescing = function(options) {
+	if (!options) {
+		this._runCoalescing = null;
+		this._runGroup = null;
+		return;
+	}
+	if (options === true) options = {};
+	var windowMs = (typeof options.windowMs === 'number') ? options.windowMs : 1;
+	var maxBatch = (typeof options.maxBatch === 'number') ? options.maxBatch : 64;
+	if (windowMs < 0) throw new XError(XError.INVALID_ARGUMENT, 'windowMs must not be negative');
+	if (maxBatch < 1) throw new XError(XError.INVALID_ARGUMENT, 'maxBatch must be at least 1');
+	this._runCoalescing = { windowMs: windowMs, maxBatch: maxBatch };
+};
+
+// Adds a row to the open group of coalesced runs, or queues a new group
+ANN.prototype._coalesceRun = function(inputs, scale) {
+	var coalescing = this._runCoalescing;
+	var group = this._runGroup;
+	if (!group || group.scale !== scale) {
+		group = {
+			scale: scale,
+			rows: [],
+			waiters: [],
+			closed: pasync.waiter(),
+			timer: null
+		};
+		this._runCoalescedGroup(group);
+		this._runGroup = group;
+		var self = this;
+		group.timer = setTimeout(function() {
+			self._closeRunGroup(group);
+		}, coalescing.windowMs);
+	}
+	var waiter = pasync.waiter();
+	group.rows.push(inputs);
+	group.waiters.push(waiter);
+	if (group.rows.length >= coalescing.maxBatch) this._closeRunGroup(group);
+	return waiter.promise;
+};
+
+ANN.prototype._closeRunGroup = function(group) {
+	if (this._runGroup === group) this._runGroup = null;
+	clearTimeout(group.timer);
+	group.closed.resolve();
+};
+
+// Queued op for a group of coalesced runs.  Waits for the group to close, then runs its rows as one batch.
+ANN.prototype._runCoalescedGroup = asyncOpQueue(function(group) {
+	var self = this;
+	return group.closed.promise.then(function() {
+		var numInput = self.info.numInput;
+		var numOutput = self.info.numOutput;
+		var inputs = new Float64Array(group.rows.length * numInput);
+		for (var row = 0; row < group.rows.length; row++) inputs.set(group.rows[row], row * numInput);
+		return new Promise(function(resolve) {
+			self._fanny.runBatchAsync(inputs, group.scale, function(err, outputs) {
+				for (var row = 0; row < group.waiters.length; row++) {
+					if (err) {
+						group.waiters[row].reject(new XError(err));
+					} else {
+						group.waiters[row].resolve(Array.prototype.slice.call(outputs, row * numOutput, (row + 1) * numOutput));
+					}
+				}
+				resolve();
+			});
 		});
 	});
+}, true);
+
+// Runs the network on a batch of inputs in one native call.  inputs can be an array of input arrays,
+// which returns an array of output arrays, or a typed array with the input rows laid end to end, which
+// returns a typed array of output rows.  Sparse inputs can be given in CSR form, as an object containing
+// "rowOffsets", "indices" and "values": the non-zero inputs of row r are indices/values[rowOffsets[r]
+// ... rowOffsets[r + 1]).  These also return a typed array of output rows.  Takes the same options as run(),
+// and like run() can be called while other runs are queued.
+ANN.prototype.runBatch = allowDuringRuns(wrapThrows(function(inputs, options) {
+	if (isSparseInput(inputs)) {
+		checkSparseOptions(options);
+		return this._fanny.runSparseBatch(inputs.rowOffsets, inputs.indices, inputs.values);
+	}
+	return this._fanny.runBatch(inputs, !!(options && options.scale), this._currentlyRunning);
+}));
+
+ANN.prototype.runBatchAsync = asyncOpQueue(function(inputs, options) {
+	var self = this;
+	return new Promise(function(resolve, reject) {
+		var cb = function(err, res) {
+			if (err) return reject(new XError(err));
+			resolve(res);
+		};
+		if (isSparseInput(inputs)) {
+			checkSparseOptions(options);
+			return self._fanny.runSparseBatchAsync(inputs.rowOffsets, inputs.indices, inputs.values, cb);
+		}
+		self._fanny.runBatchAsync(inputs, !!(options && options.scale), cb);
+	});
+}, true);
+
+// Returns a Transform stream that runs the network on the input rows written to it (in object mode) and
+// emits the output rows in order, batching rows into native calls.  See ScoringStream for the options
+// (batchSize, maxLatencyMs, concurrency and scale).
+ANN.prototype.createScoringStream = function(options) {
+	return new ScoringStream(this, options);
+};
+
+// Occupies this ANN's operation queue until the returned promise resolves.  Calls acquired() once
+// all previously queued operations have finished.  Used to run networks from outside the ANN
+// (eg. in an Ensemble) without racing its own training or running.
+ANN.prototype._holdOpQueue = asyncOpQueue(function(acquired, releasePromise) {
+	acquired();
+	return releasePromise;
 });
 
 ANN.prototype.randomizeWeights = blockOnAsync(wrapThrows(function(min, max) {
@@ -725,6 +1084,44 @@ ANN.prototype.initWeights = blockOnAsync(wrapThrows(function(data) {
 	return this._fanny.initWeights(data._fannyTrainingData);
 }));
 
+/**
+ * Seeds the network's random stream, which randomizeWeights() and initWeights() (and their async versions)
+ * draw from.  Each network has its own stream, seeded from the system unless this is called, so networks
+ * can be initialized reproducibly and in parallel.
+ *
+ * @method setSeed
+ * @param {Number} seed - Non-negative integer
+ */
+ANN.prototype.setSeed = wrapThrows(function(seed) {
+	if (typeof seed !== 'number') throw new XError(XError.INVALID_ARGUMENT, 'seed must be a number');
+	return this._fanny.setSeed(seed);
+});
+
+ANN.prototype.randomizeWeightsAsync = asyncOpQueue(function(min, max) {
+	var self = this;
+	if (typeof min !== 'number' || Number.isNaN(min)) throw new XError(XError.INVALID_ARGUMENT, 'min must be a number');
+	if (typeof max !== 'number' || Number.isNaN(max)) throw new XError(XError.INVALID_ARGUMENT, 'max must be a number');
+	return new Promise(function(resolve, reject) {
+		self._fanny.randomizeWeightsAsync(min, max, function(err) {
+			if (err) return reject(new XError(err));
+			resolve();
+		});
+	});
+});
+
+ANN.prototype.initWeightsAsync = asyncOpQueue(function(data) {
+	var self = this;
+	if (!data || !data._fannyTrainingData) {
+		throw new XError(XError.INVALID_ARGUMENT, 'data must be an instanceof TrainingData');
+	}
+	return new Promise(function(resolve, reject) {
+		self._fanny.initWeightsAsync(data._fannyTrainingData, function(err) {
+			if (err) return reject(new XError(err));
+			resolve();
+		});
+	});
+});
+
 ANN.prototype.printConnections = function() {
 	return this._fanny.printConnections();
 };
@@ -966,6 +1363,46 @@ ANN.prototype.setWeight = blockOnAsync(wrapThrows(function(fromNeuron, toNeuron,
 	return this._fanny.setWeight(fromNeuron, toNeuron, weight);
 }));
 
+/**
+ * Returns a copy of all connection weights as a typed array (Float32Array for float networks,
+ * Float64Array for double, Int32Array for fixed), in the same order as getConnectionArray().
+ *
+ * @method getWeights
+ * @return {TypedArray}
+ */
+ANN.prototype.getWeights = blockOnAsync(function() {
+	return this._fanny.getWeights();
+});
+
+/**
+ * Replaces all connection weights from a typed array with one entry per connection, in the same
+ * order as getConnectionArray().  Float32Array, Float64Array and Int32Array are accepted.
+ *
+ * @method setWeights
+ * @param {TypedArray} weights
+ */
+ANN.prototype.setWeights = blockOnAsync(wrapThrows(function(weights) {
+	if (!ArrayBuffer.isView(weights)) {
+		throw new XError(XError.INVALID_ARGUMENT, 'weights must be a typed array');
+	}
+	if (weights.length !== this._fanny.getTotalConnections()) {
+		throw new XError(XError.INVALID_ARGUMENT, 'weights must have one entry per connection');
+	}
+	return this._fanny.setWeights(weights);
+}));
+
+/**
+ * Returns a typed array backed directly by the network's weight storage, without copying.  Writes
+ * to it change the network, and it reflects training as it happens.  Cascade training reallocates
+ * the weights, which detaches the view (its length becomes 0); call this again afterwards.
+ *
+ * @method getWeightsView
+ * @return {TypedArray}
+ */
+ANN.prototype.getWeightsView = function() {
+	return this._fanny.getWeightsView();
+};
+
 ANN.prototype.trainOne = blockOnAsync(wrapThrows(function(input, output) {
 	if (!Array.isArray(input) || !Array.isArray(output)) {
 		throw new XError(XError.INVALID_ARGUMENT, 'Both input and output should be arrays');
@@ -999,16 +1436,74 @@ ANN.prototype.testData = asyncOpQueue(function(data) {
 	});
 });
 
+// Builds an integer-quantized copy of this network for fast inference on hardware without a good FPU.
+// Only quantizing the inputs and dequantizing the outputs use floating point.
+// data is a TrainingData (or array of training pairs) used to calibrate activation ranges and to
+// measure the accuracy of the quantized network.  options can include:
+// - bits - 8 (default) or 16
+// Resolves with a QuantizedANN.  Its "report" property contains floatMSE, quantizedMSE, maxAbsDiff,
+// meanAbsDiff, argmaxAgreement, floatBytes and quantizedBytes.
+ANN.prototype.quantize = asyncOpQueue(function(data, options) {
+	var self = this;
+	if (!options) options = {};
+	if (Array.isArray(data)) data = createTrainingData(data, this._datatype);
+	if (!data || !data._fannyTrainingData) {
+		throw new XError(XError.INVALID_ARGUMENT, 'data must be an instanceof TrainingData');
+	}
+	var bits = options.bits || 8;
+	if (bits !== 8 && bits !== 16) throw new XError(XError.INVALID_ARGUMENT, 'bits must be 8 or 16');
+	return new Promise(function(resolve, reject) {
+		self._fanny.quantize(data._fannyTrainingData, bits, function(err, fannyQuantized, report) {
+			if (err) return reject(new XError(err));
+			resolve(new QuantizedANN(fannyQuantized, report));
+		});
+	});
+});
+
+// Copies the network into memory that can be shared between worker threads, and returns a SharedANN
+// for running it.  Pass the SharedANN's "handle" to other threads with postMessage(), and construct a
+// SharedANN from it there; every thread runs the same copy.  Later changes to this ANN don't affect it.
+ANN.prototype.share = blockOnAsync(function() {
+	return new SharedANN({ datatype: this._datatype, buffer: this._fanny.share() });
+});
+
+// Replaces the network with one loaded from a file (as loadANN(), which is passed options) or from a
+// Buffer created by toBuffer(), without interrupting traffic.  The new network is loaded on a worker
+// thread while this ANN keeps serving operations, and must have the same numbers of inputs and outputs.
+// It's then swapped in at the end of the operation queue: operations called before that point finish
+// on the old network, and later ones use the new one.  The old network is freed once the operations
+// using it are done and it's garbage collected.  Resolves once the new network is in place.
+ANN.prototype.reloadFrom = function(source, options) {
+	var self = this;
+	var loading;
+	if (Buffer.isBuffer(source)) {
+		loading = loadANNFromBuffer(source, this._datatype);
+	} else if (typeof source === 'string') {
+		loading = loadANN(source, this._datatype, options);
+	} else {
+		throw new XError(XError.INVALID_ARGUMENT, 'source must be a filename or a Buffer');
+	}
+	return loading.then(function(loaded) {
+		if (loaded.info.numInput !== self.info.numInput || loaded.info.numOutput !== self.info.numOutput) {
+			throw new XError(XError.INVALID_ARGUMENT, 'Reloaded network must have the same number of inputs and outputs');
+		}
+		return self._swapNetwork(loaded);
+	});
+};
+
+// Only replaces the network between queued runs, so it can wait behind them without blocking run()
+ANN.prototype._swapNetwork = asyncOpQueue(function(loaded) {
+	this._fanny.swapNetwork(loaded._fanny);
+	this._recalculateInfo();
+	this.userData = loaded.userData;
+}, true);
+
 for (var key in ANN.prototype) {
 	ANN.prototype[key] = wrapThrows(ANN.prototype[key]);
 }
 
-function createANN(config, options) {
-	if (!config) throw new XError(XError.INVALID_ARGUMENT, 'config is required');
-	if (Array.isArray(config)) config = { layers: config };
-	annConfigSchema.normalize(config);
-	var addon = utils.getAddon(config.datatype);
-	var fanny = new addon.FANNY(config);
+// Applies the activation function and steepness settings from the config to a new addon FANNY
+function configureFanny(fanny, config) {
 	if (config.activationFunctions) {
 		for (var key in config.activationFunctions) {
 			var value = config.activationFunctions[key];
@@ -1043,6 +1538,15 @@ function createANN(config, options) {
 			}
 		}
 	}
+}
+
+function createANN(config, options) {
+	if (!config) throw new XError(XError.INVALID_ARGUMENT, 'config is required');
+	if (Array.isArray(config)) config = { layers: config };
+	annConfigSchema.normalize(config);
+	var addon = utils.getAddon(config.datatype);
+	var fanny = new addon.FANNY(config);
+	configureFanny(fanny, config);
 	var ann = new ANN(fanny, config.datatype);
 	// FANN seeds the libc PRNG every time a neural net is created.  We want to disable this after the
 	// first time it's seeded.
@@ -1051,14 +1555,84 @@ function createANN(config, options) {
 	return ann;
 }
 
-function loadANN(filename, datatype) {
+// Same as createANN(), but allocates and initializes the network on a worker thread.  Resolves with the ANN.
+function createANNAsync(config, options) {
+	if (!config) return Promise.reject(new XError(XError.INVALID_ARGUMENT, 'config is required'));
+	if (Array.isArray(config)) config = { layers: config };
+	var addon;
+	try {
+		annConfigSchema.normalize(config);
+		addon = utils.getAddon(config.datatype);
+	} catch (ex) {
+		return Promise.reject(XError.isXError(ex) ? ex : new XError(ex));
+	}
+	return new Promise(function(resolve, reject) {
+		addon.FANNY.createAsync(config, function(err, fanny) {
+			if (err) return reject(new XError(err));
+			try {
+				configureFanny(fanny, config);
+				var ann = new ANN(fanny, config.datatype);
+				addon.FANNY.disableSeedRand();
+				if (options) ann.setOptions(options);
+				resolve(ann);
+			} catch (ex) {
+				reject(XError.isXError(ex) ? ex : new XError(ex));
+			}
+		});
+	});
+}
+
+// Options can contain:
+// - trainState - Also load the training state saved with the network, if any
+// - mmap - Load a model file saved with the mmap save() option.  Its weights are used in place from a
+//   private memory map of the file, so processes loading the same file share one copy of them.
+function loadANN(filename, datatype, options) {
+	if (!filename) throw new XError(XError.INVALID_ARGUMENT, 'filename is required');
+	if (!datatype) datatype = 'float';
+	if (!options) options = {};
+	if (options.mmap && options.trainState) {
+		throw new XError(XError.INVALID_ARGUMENT, 'Model files do not contain training state');
+	}
+	var addon = utils.getAddon(datatype);
+	return new Promise(function(resolve, reject) {
+		var cb = function(err, fanny) {
+			if (err) return reject(new XError(err));
+			var ann = new ANN(fanny, datatype);
+			resolve(ann);
+		};
+		if (options.mmap) {
+			addon.FANNY.loadModelFile(filename, cb);
+		} else {
+			addon.FANNY.loadFile(filename, !!options.trainState, cb);
+		}
+	});
+}
+
+// Loads a network from a Buffer created by toBuffer()
+function loadANNFromBuffer(buffer, datatype) {
+	if (!Buffer.isBuffer(buffer)) throw new XError(XError.INVALID_ARGUMENT, 'buffer must be a Buffer');
+	if (!datatype) datatype = 'float';
+	var addon = utils.getAddon(datatype);
+	return new Promise(function(resolve, reject) {
+		addon.FANNY.loadBuffer(buffer, function(err, fanny) {
+			if (err) return reject(new XError(err));
+			resolve(new ANN(fanny, datatype));
+		});
+	});
+}
+
+// Loads a checkpoint file written during training (see the train() checkpoint option), along with its
+// training state.  The resulting ANN has a "checkpoint" property containing the epochs and mse at
+// the time of the checkpoint.
+function loadCheckpoint(filename, datatype) {
 	if (!filename) throw new XError(XError.INVALID_ARGUMENT, 'filename is required');
 	if (!datatype) datatype = 'float';
 	var addon = utils.getAddon(datatype);
 	return new Promise(function(resolve, reject) {
-		addon.FANNY.loadFile(filename, function(err, fanny) {
+		addon.FANNY.loadFile(filename, true, function(err, fanny, stateInfo) {
 			if (err) return reject(new XError(err));
 			var ann = new ANN(fanny, datatype);
+			ann.checkpoint = stateInfo;
 			resolve(ann);
 		});
 	});
@@ -1066,7 +1640,15 @@ function loadANN(filename, datatype) {
 
 module.exports = {
 	createANN: createANN,
+	createANNAsync: createANNAsync,
 	loadANN: loadANN,
+	loadCheckpoint: loadCheckpoint,
+	loadANNFromBuffer: loadANNFromBuffer,
 	annConfigSchema: annConfigSchema,
-	annOptionsSchema: annOptionsSchema
+	annOptionsSchema: annOptionsSchema,
+	ScoringStream: ScoringStream,
+	SharedANN: SharedANN,
+	QuantizedANN: QuantizedANN,
+	loadQuantizedANN: loadQuantizedANN,
+	ANN: ANN
 };
@@ -0,0 +1,94 @@
+// Copyright 2016 Zipscene, LLC
+// Licensed under the Apache License, Version 2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+
+var XError = require('xerror');
+var pasync = require('pasync');
+var utils = require('./utils');
+var ANN = require('./ann').ANN;
+
+// Several ANNs with the same inputs and outputs, run natively on one input with their outputs
+// combined.  options can include:
+// - mode - 'mean' (default), 'weighted' or 'vote'.  With 'vote', each network votes for its highest
+//   output, and each result is the (weighted) fraction of votes for that output.
+// - weights - Array with one number per ANN; required for 'weighted', optional for 'vote', and not
+//   allowed for 'mean'
+function Ensemble(anns, options) {
+	if (!Array.isArray(anns) || !anns.length) throw new XError(XError.INVALID_ARGUMENT, 'anns must be a non-empty array');
+	if (!options) options = {};
+	var datatype = anns[0]._datatype;
+	anns.forEach(function(ann) {
+		if (!(ann instanceof ANN)) throw new XError(XError.INVALID_ARGUMENT, 'Ensemble members must be ANNs');
+		if (ann._datatype !== datatype) throw new XError(XError.INVALID_ARGUMENT, 'Ensemble members must have the same datatype');
+	});
+	if (options.weights !== undefined && options.mode !== 'weighted' && options.mode !== 'vote') {
+		throw new XError(XError.INVALID_ARGUMENT, 'weights are only used by the weighted and vote modes');
+	}
+	var addon = utils.getAddon(datatype);
+	try {
+		this._fannyEnsemble = new addon.Ensemble(anns.map(function(ann) { return ann._fanny; }), {
+			mode: options.mode,
+			weights: options.weights
+		});
+	} catch (ex) {
+		throw new XError(XError.INVALID_ARGUMENT, ex.message);
+	}
+	this.members = anns.slice(0);
+	this.info = {
+		numMembers: this._fannyEnsemble.getNumMembers(),
+		numInput: this._fannyEnsemble.getNumInput(),
+		numOutput: this._fannyEnsemble.getNumOutput()
+	};
+}
+
+// Runs every member on the inputs (an array or typed array) on the current thread, and returns the combined outputs
+Ensemble.prototype.run = function(inputs) {
+	this.members.forEach(function(ann) {
+		if (ann._currentlyRunning) {
+			throw new XError(XError.INTERNAL_ERROR, 'Cannot execute this operation while training or running ann');
+		}
+	});
+	try {
+		return this._fannyEnsemble.run(inputs);
+	} catch (ex) {
+		throw new XError(XError.INVALID_ARGUMENT, ex.message);
+	}
+};
+
+// Runs the members in parallel on worker threads.  Waits for queued operations on every member
+// to finish first, and holds their queues until done.  Resolves with the combined outputs.
+Ensemble.prototype.runAsync = function(inputs) {
+	var self = this;
+	var uniqueMembers = self.members.filter(function(ann, idx) {
+		return self.members.indexOf(ann) === idx;
+	});
+	var release = pasync.waiter();
+	var numAcquired = 0;
+	return new Promise(function(resolve, reject) {
+		function memberAcquired() {
+			if (++numAcquired < uniqueMembers.length) return;
+			try {
+				self._fannyEnsemble.runAsync(inputs, function(err, res) {
+					release.resolve();
+					if (err) return reject(new XError(err));
+					resolve(res);
+				});
+			} catch (ex) {
+				release.resolve();
+				reject(new XError(XError.INVALID_ARGUMENT, ex.message));
+			}
+		}
+		uniqueMembers.forEach(function(ann) {
+			ann._holdOpQueue(memberAcquired, release.promise);
+		});
+	});
+};
+
+function createEnsemble(anns, options) {
+	return new Ensemble(anns, options);
+}
+
+module.exports = {
+	Ensemble: Ensemble,
+	createEnsemble: createEnsemble
+};
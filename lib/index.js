@@ -4,7 +4,9 @@
 
 var td = require('./training-data');
 var ann = require('./ann');
+var ensemble = require('./ensemble');
 for (var key in td) module.exports[key] = td[key];
 for (var key in ann) module.exports[key] = ann[key];
+for (var key in ensemble) module.exports[key] = ensemble[key];
 module.exports.getAddon = require('./utils').getAddon;
 
@@ -0,0 +1,53 @@
+// Copyright 2016 Zipscene, LLC
+// Licensed under the Apache License, Version 2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+
+var XError = require('xerror');
+var utils = require('./utils');
+
+// Integer-quantized copy of a trained ANN, used for inference only.  Created with ANN quantize() or
+// loadQuantizedANN().  The "report" property compares its accuracy against the float network on the
+// calibration data; it's null for a loaded network.
+function QuantizedANN(fannyQuantized, report) {
+	this._fannyQuantized = fannyQuantized;
+	this.report = report || null;
+	this.info = {
+		numInput: fannyQuantized.getNumInput(),
+		numOutput: fannyQuantized.getNumOutput(),
+		bits: fannyQuantized.getBits(),
+		memoryUsage: fannyQuantized.getMemoryUsage()
+	};
+}
+
+QuantizedANN.prototype.run = function(inputs) {
+	if (!Array.isArray(inputs)) throw new XError(XError.INVALID_ARGUMENT, 'inputs must be an array');
+	try {
+		return this._fannyQuantized.run(inputs);
+	} catch (ex) {
+		throw new XError(XError.INVALID_ARGUMENT, ex);
+	}
+};
+
+// Serializes the quantized network to a Buffer, which loadQuantizedANN() can load on another machine
+// with the same byte order
+QuantizedANN.prototype.toBuffer = function() {
+	return this._fannyQuantized.toBuffer();
+};
+
+// Loads a QuantizedANN from a Buffer created by toBuffer().  The datatype ('float' or 'double') only
+// picks the addon used to run it, and doesn't have to match the network it was quantized from.
+function loadQuantizedANN(buffer, datatype) {
+	if (!Buffer.isBuffer(buffer)) throw new XError(XError.INVALID_ARGUMENT, 'buffer must be a Buffer');
+	if (datatype === 'fixed') throw new XError(XError.INVALID_ARGUMENT, 'Quantized networks are not supported for fixed point');
+	var addon = utils.getAddon(datatype || 'float');
+	try {
+		return new QuantizedANN(addon.QuantizedANN.loadBuffer(buffer));
+	} catch (ex) {
+		throw new XError(XError.INVALID_ARGUMENT, ex.message);
+	}
+}
+
+module.exports = {
+	QuantizedANN: QuantizedANN,
+	loadQuantizedANN: loadQuantizedANN
+};
@@ -0,0 +1,123 @@
+// Copyright 2016 Zipscene, LLC
+// Licensed under the Apache License, Version 2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+
+var XError = require('xerror');
+var stream = require('stream');
+var util = require('util');
+
+// Object mode Transform stream that runs an ANN on each input row written to it, and emits the output rows
+// in the same order.  Rows are collected into batches, each run with one native call (runBatchAsync()).
+// A batch is dispatched when it reaches batchSize rows, or maxLatencyMs after its first row arrived, so a
+// trickle of rows isn't held waiting for a full batch.  Up to `concurrency` batches can be outstanding at
+// once; rows keep being accepted and batched while earlier batches run, and beyond that the stream applies
+// backpressure.  Batches run one at a time in the ANN's operation queue, in order with its other operations.
+// Options:
+// - batchSize - Maximum rows per native call.  Defaults to 64.
+// - maxLatencyMs - Longest time a row waits for its batch to fill.  Defaults to 5.
+// - concurrency - Maximum number of batches outstanding.  Defaults to 2.
+// - scale - Apply the network's scaling parameters, as with run().
+function ScoringStream(ann, options) {
+	if (!options) options = {};
+	stream.Transform.call(this, { objectMode: true });
+	this.ann = ann;
+	this._batchSize = options.batchSize || 64;
+	this._maxLatencyMs = (typeof options.maxLatencyMs === 'number') ? options.maxLatencyMs : 5;
+	this._concurrency = options.concurrency || 2;
+	this._runOptions = { scale: !!options.scale };
+	this._numInput = ann.info.numInput;
+	// Rows of the batch being collected, laid end to end
+	this._pending = new Float64Array(this._batchSize * this._numInput);
+	this._pendingRows = 0;
+	this._timer = null;
+	// Outstanding batches, in order.  Each has "outputs" set once it has run.
+	this._batches = [];
+	// Callback of a write held back for backpressure
+	this._heldCallback = null;
+	this._flushCallback = null;
+	this._failed = false;
+}
+util.inherits(ScoringStream, stream.Transform);
+
+ScoringStream.prototype._transform = function(row, encoding, cb) {
+	if (this._failed) return cb();
+	if (!row || row.length !== this._numInput || (!Array.isArray(row) && !ArrayBuffer.isView(row))) {
+		return cb(new XError(XError.INVALID_ARGUMENT, 'Each row must be an array of ' + this._numInput + ' inputs'));
+	}
+	this._pending.set(row, this._pendingRows * this._numInput);
+	this._pendingRows++;
+	if (this._pendingRows === this._batchSize) {
+		this._dispatch();
+	} else if (!this._timer) {
+		var self = this;
+		this._timer = setTimeout(function() {
+			self._timer = null;
+			self._dispatch();
+		}, this._maxLatencyMs);
+	}
+	if (this._batches.length < this._concurrency) {
+		cb();
+	} else {
+		this._heldCallback = cb;
+	}
+};
+
+ScoringStream.prototype._flush = function(cb) {
+	this._dispatch();
+	this._flushCallback = cb;
+	this._drain();
+};
+
+// Sends the collected rows to the ANN as one batch
+ScoringStream.prototype._dispatch = function() {
+	if (this._timer) {
+		clearTimeout(this._timer);
+		this._timer = null;
+	}
+	if (!this._pendingRows) return;
+	var self = this;
+	var inputs = this._pending.subarray(0, this._pendingRows * this._numInput);
+	var batch = { numRows: this._pendingRows, outputs: null };
+	this._pending = new Float64Array(this._batchSize * this._numInput);
+	this._pendingRows = 0;
+	this._batches.push(batch);
+	this.ann.runBatchAsync(inputs, this._runOptions).then(function(outputs) {
+		batch.outputs = outputs;
+		self._drain();
+	}, function(err) {
+		self._fail(err);
+	});
+};
+
+// Emits the outputs of finished batches at the front of the queue, and releases backpressure
+ScoringStream.prototype._drain = function() {
+	if (this._failed) return;
+	var numOutput = this.ann.info.numOutput;
+	while (this._batches.length && this._batches[0].outputs) {
+		var batch = this._batches.shift();
+		for (var row = 0; row < batch.numRows; row++) {
+			this.push(Array.prototype.slice.call(batch.outputs, row * numOutput, (row + 1) * numOutput));
+		}
+	}
+	if (this._heldCallback && this._batches.length < this._concurrency) {
+		var cb = this._heldCallback;
+		this._heldCallback = null;
+		cb();
+	}
+	if (this._flushCallback && !this._batches.length) {
+		var flushCallback = this._flushCallback;
+		this._flushCallback = null;
+		flushCallback();
+	}
+};
+
+ScoringStream.prototype._fail = function(err) {
+	if (this._failed) return;
+	this._failed = true;
+	if (this._timer) clearTimeout(this._timer);
+	this.destroy(XError.isXError(err) ? err : new XError(err));
+};
+
+module.exports = {
+	ScoringStream: ScoringStream
+};
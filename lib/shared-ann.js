@@ -0,0 +1,46 @@
+// Copyright 2016 Zipscene, LLC
+// Licensed under the Apache License, Version 2.0
+// http://www.apache.org/licenses/LICENSE-2.0
+
+var XError = require('xerror');
+var utils = require('./utils');
+
+// Inference-only view of an immutable network that is shared between worker threads.  Created with
+// ANN share(), or in another thread from the "handle" property of one, which can be sent with
+// postMessage().  The network's memory is shared and freed once no thread holds a handle to it.
+function SharedANN(handle) {
+	if (!handle || !handle.buffer) throw new XError(XError.INVALID_ARGUMENT, 'SharedANN takes the handle of another SharedANN');
+	try {
+		this._fannyShared = new (utils.getAddon(handle.datatype).SharedANN)(handle.buffer);
+	} catch (ex) {
+		throw new XError(XError.INVALID_ARGUMENT, ex.message);
+	}
+	this.handle = { datatype: handle.datatype, buffer: handle.buffer };
+	this.info = {
+		numInput: this._fannyShared.getNumInput(),
+		numOutput: this._fannyShared.getNumOutput()
+	};
+}
+
+// Takes the same arguments as ANN run()
+SharedANN.prototype.run = function(inputs, options) {
+	if (!Array.isArray(inputs)) throw new XError(XError.INVALID_ARGUMENT, 'inputs must be an array');
+	try {
+		return this._fannyShared.run(inputs, !!(options && options.scale));
+	} catch (ex) {
+		throw new XError(XError.INVALID_ARGUMENT, ex.message);
+	}
+};
+
+// Takes the same arguments as ANN runBatch(), except for sparse inputs
+SharedANN.prototype.runBatch = function(inputs, options) {
+	try {
+		return this._fannyShared.runBatch(inputs, !!(options && options.scale));
+	} catch (ex) {
+		throw new XError(XError.INVALID_ARGUMENT, ex.message);
+	}
+};
+
+module.exports = {
+	SharedANN: SharedANN
+};
@@ -4,6 +4,9 @@
 
 var utils = require('./utils');
 var XError = require('xerror');
+var stream = require('stream');
+var util = require('util');
+var os = require('os');
 
 function TrainingData(fannyTrainingData, datatype) {
 	this._fannyTrainingData = fannyTrainingData;
@@ -16,6 +19,23 @@ TrainingData.prototype.clone = function() {
 	return new TrainingData(fannyTrainingData, this._datatype);
 };
 
+// Returns a copy of the data in another datatype ('float' or 'double').  The conversion is done natively.
+TrainingData.prototype.toDatatype = function(datatype) {
+	if (!datatype) datatype = 'float';
+	var addon = utils.getAddon(datatype);
+	if (datatype === this._datatype) return this.clone();
+	if (datatype === 'fixed' || this._datatype === 'fixed') {
+		throw new XError(XError.INVALID_ARGUMENT, 'Fixed point training data cannot be converted');
+	}
+	var fannyTrainingData = new addon.TrainingData();
+	try {
+		fannyTrainingData.importData(this._fannyTrainingData.exportData());
+	} catch (ex) {
+		throw new XError(XError.INVALID_ARGUMENT, ex);
+	}
+	return new TrainingData(fannyTrainingData, datatype);
+};
+
 // Possible invocations:
 // setData(<ArrayOfPairs>)
 // setData(<InputsArrayOfArrays>, <OutputsArrayOfArrays>)
@@ -73,8 +93,42 @@ TrainingData.prototype.save = function(filename, fixedDecimalPoint) {
 	});
 };
 
+// Shuffles the rows with the training data's own random stream (see setSeed()).  Rows are moved whole,
+// into new storage, so this detaches views from getInputBuffer() and getOutputBuffer().  Throws if an
+// async operation (such as training or shuffleAsync()) is using the data.
 TrainingData.prototype.shuffle = function() {
-	this._fannyTrainingData.shuffle();
+	try {
+		this._fannyTrainingData.shuffle();
+	} catch (ex) {
+		throw new XError(ex);
+	}
+};
+
+// Like shuffle(), but on a worker thread.  Returns a Promise.  The data is in use until it resolves, so
+// it can't be shuffled or replaced, and async operations on it are rejected.
+TrainingData.prototype.shuffleAsync = function() {
+	var self = this;
+	return new Promise(function(resolve, reject) {
+		try {
+			self._fannyTrainingData.shuffleAsync(function(err) {
+				if (err) return reject(new XError(err));
+				resolve();
+			});
+		} catch (ex) {
+			reject(new XError(ex));
+		}
+	});
+};
+
+// Seeds the random stream used for shuffling, making shuffles reproducible.  Without a seed, the stream
+// is seeded from the system.  Each training data object has its own stream.
+TrainingData.prototype.setSeed = function(seed) {
+	if (typeof seed !== 'number') throw new XError(XError.INVALID_ARGUMENT, 'seed must be a number');
+	try {
+		this._fannyTrainingData.setSeed(seed);
+	} catch (ex) {
+		throw new XError(XError.INVALID_ARGUMENT, ex);
+	}
 };
 
 TrainingData.prototype.merge = function(data) {
@@ -104,6 +158,19 @@ TrainingData.prototype.getOutputData = function() {
 	return this._fannyTrainingData.getOutput();
 };
 
+// Returns a typed array (Float32Array, Float64Array or Int32Array, by datatype) backed directly by the
+// native input storage, with the rows laid end to end.  Nothing is copied; writes change the data.
+// Operations that replace the storage (merge, subset, setData and loading) detach the view, making its
+// length 0.
+TrainingData.prototype.getInputBuffer = function() {
+	return this._fannyTrainingData.getInputBuffer();
+};
+
+// Like getInputBuffer(), for the outputs
+TrainingData.prototype.getOutputBuffer = function() {
+	return this._fannyTrainingData.getOutputBuffer();
+};
+
 TrainingData.prototype.getOneInputData = function(pos) {
 	if (typeof pos !== 'number') {
 		throw new XError(XError.INVALID_ARGUMENT, 'argument should be a number');
@@ -152,12 +219,107 @@ TrainingData.prototype.scale = function(min, max) {
 	return this._fannyTrainingData.scaleTrainData(min, max);
 };
 
+// Returns the threads option of computeStats() and normalize(), defaulting to the number of CPUs
+function getThreadsOption(options) {
+	if (options.threads === undefined) return os.cpus().length;
+	if (typeof options.threads !== 'number' || options.threads < 1 || Math.floor(options.threads) !== options.threads) {
+		throw new XError(XError.INVALID_ARGUMENT, 'threads must be a positive integer');
+	}
+	return options.threads;
+}
+
+// Computes per-column statistics of the inputs and outputs natively, in one multi-threaded pass over each.
+// Returns { input: <stats>, output: <stats> }, where each contains Float64Arrays with one entry per column:
+// min, max, mean, variance (population variance) and nanCount.  NaN values are counted and otherwise ignored.
+// Options:
+// - threads - Number of threads.  Defaults to the number of CPUs.
+TrainingData.prototype.computeStats = function(options) {
+	if (!options) options = {};
+	var threads = getThreadsOption(options);
+	return {
+		input: this._fannyTrainingData.computeStats(false, threads),
+		output: this._fannyTrainingData.computeStats(true, threads)
+	};
+};
+
+// Normalizes each column in place, natively.  Returns the statistics used, as from computeStats(), so the
+// same transform can be applied to other data (such as a test set) by passing them as options.stats.
+// Options:
+// - method - 'zscore' (the default) to give each column mean 0 and variance 1, or 'minmax' to map each
+//   column's range onto [ min, max ].  Constant columns are only shifted by 'zscore', and set to min by
+//   'minmax'.
+// - min, max - Target range for 'minmax'.  Default to 0 and 1.
+// - inputs - Whether to normalize the inputs.  Defaults to true.
+// - outputs - Whether to normalize the outputs.  Defaults to false.
+// - stats - Statistics to normalize with, instead of computing them from this data.
+// - threads - Number of threads.  Defaults to the number of CPUs.
+TrainingData.prototype.normalize = function(options) {
+	if (!options) options = {};
+	var method = options.method || 'zscore';
+	if (method !== 'zscore' && method !== 'minmax') {
+		throw new XError(XError.INVALID_ARGUMENT, 'method must be zscore or minmax');
+	}
+	var newMin = (typeof options.min === 'number') ? options.min : 0;
+	var newMax = (typeof options.max === 'number') ? options.max : 1;
+	var threads = getThreadsOption(options);
+	var stats = options.stats || this.computeStats({ threads: threads });
+	var self = this;
+	function normalizeSide(isOutput, columnStats) {
+		if (!columnStats || columnStats.mean.length !== (isOutput ? self.getNumOutputs() : self.getNumInputs())) {
+			throw new XError(XError.INVALID_ARGUMENT, 'stats do not match the training data');
+		}
+		var numColumns = columnStats.mean.length;
+		var offset = new Float64Array(numColumns);
+		var scale = new Float64Array(numColumns);
+		var base = new Float64Array(numColumns);
+		for (var col = 0; col < numColumns; col++) {
+			if (method === 'zscore') {
+				var stdDev = Math.sqrt(columnStats.variance[col]);
+				offset[col] = isNaN(columnStats.mean[col]) ? 0 : columnStats.mean[col];
+				scale[col] = (stdDev > 0) ? 1 / stdDev : 1;
+			} else {
+				var range = columnStats.max[col] - columnStats.min[col];
+				offset[col] = isNaN(columnStats.min[col]) ? 0 : columnStats.min[col];
+				scale[col] = (range > 0) ? (newMax - newMin) / range : isNaN(range) ? 1 : 0;
+				base[col] = isNaN(range) ? 0 : newMin;
+			}
+		}
+		try {
+			self._fannyTrainingData.normalizeColumns(isOutput, offset, scale, base, threads);
+		} catch (ex) {
+			throw new XError(XError.INVALID_ARGUMENT, ex);
+		}
+	}
+	if (options.inputs !== false) normalizeSide(false, stats.input);
+	if (options.outputs) normalizeSide(true, stats.output);
+	return stats;
+};
+
 TrainingData.prototype.subset = function(startPos, length) {
 	if (typeof startPos !== 'number') throw new XError(XError.INVALID_ARGUMENT, 'startPos must be a number');
 	if (typeof length !== 'number') throw new XError(XError.INVALID_ARGUMENT, 'length must be a number');
 	return this._fannyTrainingData.subsetTrainData(startPos, length);
 };
 
+// Training data with sparse inputs, for one-hot or bag-of-words features where most inputs are 0.
+// It can only be used with ANN#train(), which trains it natively without expanding the inputs.
+function SparseTrainingData(fannySparseTrainingData, datatype) {
+	this._fannySparseTrainingData = fannySparseTrainingData;
+	this._datatype = datatype;
+}
+
+SparseTrainingData.prototype.getLength = function() {
+	return this._fannySparseTrainingData.length();
+};
+
+SparseTrainingData.prototype.getNumInputs = function() {
+	return this._fannySparseTrainingData.numInput();
+};
+
+SparseTrainingData.prototype.getNumOutputs = function() {
+	return this._fannySparseTrainingData.numOutput();
+};
+
 function createTrainingData(arg1, arg2, datatype) {
 	if (typeof arg2 === 'string') {
 		datatype = arg2;
@@ -171,13 +333,25 @@ function createTrainingData(arg1, arg2, datatype) {
 	return td;
 }
 
-function loadTrainingData(filename, datatype) {
+// Options:
+// - threads - Number of threads to parse the file on natively.  Defaults to 0, which reads the file with
+//   FANN's own reader.
+function loadTrainingData(filename, datatype, options) {
 	if (!filename) throw new XError(XError.INVALID_ARGUMENT, 'filename is required');
+	if (datatype && typeof datatype === 'object') {
+		options = datatype;
+		datatype = null;
+	}
 	if (!datatype) datatype = 'float';
+	if (!options) options = {};
+	var threads = options.threads || 0;
+	if (typeof threads !== 'number' || threads < 0 || Math.floor(threads) !== threads) {
+		throw new XError(XError.INVALID_ARGUMENT, 'threads must be a non-negative integer');
+	}
 	var addon = utils.getAddon(datatype);
 	return new Promise(function(resolve, reject) {
 		var fannyTrainingData = new addon.TrainingData();
-		fannyTrainingData.readTrainFromFile(filename, function(err) {
+		fannyTrainingData.readTrainFromFile(filename, threads, function(err) {
 			if (err) return reject(new XError(err));
 			var td = new TrainingData(fannyTrainingData, datatype);
 			resolve(td);
@@ -185,8 +359,134 @@ function loadTrainingData(filename, datatype) {
 	});
 }
 
+// Possible invocations:
+// createSparseTrainingData(<ArrayOfPairs>, numInput, [datatype])
+// createSparseTrainingData({ rowOffsets, indices, values, outputs }, numInput, [datatype])
+// In ArrayOfPairs, each entry is an object with "input" and "output" keys.  "input" is an object containing
+// "indices" and "values" arrays for the non-zero inputs, and "output" is a dense array.  The second form
+// is CSR: the inputs of row r are indices/values[rowOffsets[r] ... rowOffsets[r + 1]), and outputs
+// contains the output rows laid end to end.  Arrays can be typed arrays.
+function createSparseTrainingData(data, numInput, datatype) {
+	if (typeof numInput !== 'number') throw new XError(XError.INVALID_ARGUMENT, 'numInput must be a number');
+	if (!datatype) datatype = 'float';
+	var addon = utils.getAddon(datatype);
+	var csr = data;
+	if (Array.isArray(data)) {
+		csr = { rowOffsets: [ 0 ], indices: [], values: [], outputs: [] };
+		for (var i = 0; i < data.length; ++i) {
+			var entry = data[i];
+			if (!entry || !entry.input || !Array.isArray(entry.output)) throw new XError(XError.INVALID_ARGUMENT);
+			var indices = entry.input.indices;
+			var values = entry.input.values;
+			if (!indices || !values || indices.length !== values.length) throw new XError(XError.INVALID_ARGUMENT);
+			for (var j = 0; j < indices.length; ++j) {
+				csr.indices.push(indices[j]);
+				csr.values.push(values[j]);
+			}
+			csr.rowOffsets.push(csr.indices.length);
+			csr.outputs.push.apply(csr.outputs, entry.output);
+		}
+	}
+	if (!csr || typeof csr !== 'object') throw new XError(XError.INVALID_ARGUMENT);
+	var numOutput = csr.outputs.length / (csr.rowOffsets.length - 1);
+	var fannySparseTrainingData;
+	try {
+		fannySparseTrainingData = new addon.SparseTrainingData(
+			numInput,
+			numOutput,
+			csr.rowOffsets,
+			csr.indices,
+			csr.values,
+			csr.outputs
+		);
+	} catch (ex) {
+		throw new XError(XError.INVALID_ARGUMENT, ex);
+	}
+	return new SparseTrainingData(fannySparseTrainingData, datatype);
+}
+
+// A writable object stream that builds training data from rows as they arrive, without materializing
+// them as Javascript arrays.  Rows are appended natively to contiguous storage, and when the stream
+// finishes the resulting TrainingData is available as the "trainingData" property.  Each chunk can be:
+// - { inputs, outputs } - A batch of rows.  Each is an array or typed array of rows laid end to end.
+// - { input, output } or [ input, output ] - A single row.
+function TrainingDataWriter(numInput, numOutput, datatype) {
+	stream.Writable.call(this, { objectMode: true });
+	if (typeof numInput !== 'number' || typeof numOutput !== 'number') {
+		throw new XError(XError.INVALID_ARGUMENT, 'numInput and numOutput must be numbers');
+	}
+	if (!datatype) datatype = 'float';
+	var addon = utils.getAddon(datatype);
+	this._datatype = datatype;
+	this._builder = new addon.TrainingDataBuilder(numInput, numOutput);
+	this.trainingData = null;
+}
+util.inherits(TrainingDataWriter, stream.Writable);
+
+TrainingDataWriter.prototype._write = function(chunk, encoding, cb) {
+	var inputs, outputs;
+	if (Array.isArray(chunk) && chunk.length === 2) {
+		inputs = chunk[0];
+		outputs = chunk[1];
+	} else if (chunk && chunk.inputs && chunk.outputs) {
+		inputs = chunk.inputs;
+		outputs = chunk.outputs;
+	} else if (chunk && chunk.input && chunk.output) {
+		inputs = chunk.input;
+		outputs = chunk.output;
+	} else {
+		return cb(new XError(XError.INVALID_ARGUMENT, 'Invalid training data chunk'));
+	}
+	try {
+		this._builder.append(inputs, outputs);
+	} catch (ex) {
+		return cb(new XError(XError.INVALID_ARGUMENT, ex));
+	}
+	cb();
+};
+
+TrainingDataWriter.prototype._final = function(cb) {
+	var addon = utils.getAddon(this._datatype);
+	var fannyTrainingData = new addon.TrainingData();
+	try {
+		this._builder.finish(fannyTrainingData);
+	} catch (ex) {
+		return cb(new XError(XError.INVALID_ARGUMENT, ex));
+	}
+	this.trainingData = new TrainingData(fannyTrainingData, this._datatype);
+	cb();
+};
+
+// Returns the number of rows written so far
+TrainingDataWriter.prototype.getLength = function() {
+	return this.trainingData ? this.trainingData.getLength() : this._builder.length();
+};
+
+function createTrainingDataWriter(numInput, numOutput, datatype) {
+	return new TrainingDataWriter(numInput, numOutput, datatype);
+}
+
+// Pipes a readable object stream (of the chunks accepted by TrainingDataWriter) into new training data.
+// Returns a Promise resolving with the TrainingData.
+function loadTrainingDataFromStream(readable, numInput, numOutput, datatype) {
+	var writer = createTrainingDataWriter(numInput, numOutput, datatype);
+	return new Promise(function(resolve, reject) {
+		readable.on('error', reject);
+		writer.on('error', reject);
+		writer.on('finish', function() {
+			resolve(writer.trainingData);
+		});
+		readable.pipe(writer);
+	});
+}
+
 module.exports = {
+	SparseTrainingData: SparseTrainingData,
 	createTrainingData: createTrainingData,
+	createSparseTrainingData: createSparseTrainingData,
+	TrainingDataWriter: TrainingDataWriter,
+	createTrainingDataWriter: createTrainingDataWriter,
+	loadTrainingDataFromStream: loadTrainingDataFromStream,
 	loadTrainingData: loadTrainingData
 };
 
@@ -0,0 +1,133 @@
+#ifndef FANNY_ACTIVATION_H
+#define FANNY_ACTIVATION_H
+
+#include "fann-includes.h"
+#include <cmath>
+
+namespace fanny {
+
+// Versions of FANN's activation functions for native code paths that evaluate networks without going
+// through fann_run().  T is float or double.
+
+// FANN's piecewise linear approximation of the sigmoids (fann_stepwise() in fann_activation.h)
+template<typename T>
+inline T activationStepwise(const T *v, const T *r, T min, T max, T sum) {
+	if (sum < v[0]) return min;
+	if (sum >= v[5]) return max;
+	int step = (sum < v[1]) ? 0 : (sum < v[2]) ? 1 : (sum < v[3]) ? 2 : (sum < v[4]) ? 3 : 4;
+	return (r[step + 1] - r[step]) * (sum - v[step]) / (v[step + 1] - v[step]) + r[step];
+}
+
+// Applies the steepness to a neuron sum and clamps it as fann_run() does (to keep exp() in range).
+// This is the value FANN stores in fann_neuron::sum.
+template<typename T>
+inline T activationSum(T steepness, T sum) {
+	sum *= steepness;
+	T maxSum = (T)150 / steepness;
+	if (sum > maxSum) return maxSum;
+	if (sum < -maxSum) return -maxSum;
+	return sum;
+}
+
+// Activation of a sum that has already been through activationSum()
+template<typename T>
+inline T activationOfSum(enum fann_activationfunc_enum fn, T sum) {
+	switch (fn) {
+		case FANN_LINEAR:
+			return sum;
+		case FANN_LINEAR_PIECE:
+			return (sum < 0) ? 0 : (sum > 1) ? 1 : sum;
+		case FANN_LINEAR_PIECE_SYMMETRIC:
+			return (sum < -1) ? -1 : (sum > 1) ? 1 : sum;
+		case FANN_SIGMOID:
+			return (T)1 / ((T)1 + std::exp((T)-2 * sum));
+		case FANN_SIGMOID_STEPWISE: {
+			static const T v[] = { (T)-2.64665246009826660156e+00, (T)-1.47221946716308593750e+00, (T)-5.49306154251098632812e-01,
+				(T)5.49306154251098632812e-01, (T)1.47221934795379638672e+00, (T)2.64665293693542480469e+00 };
+			static const T r[] = { (T)4.99999988824129104614e-03, (T)5.00000007450580596924e-02, (T)2.50000000000000000000e-01,
+				(T)7.50000000000000000000e-01, (T)9.49999988079071044922e-01, (T)9.95000004768371582031e-01 };
+			return activationStepwise(v, r, (T)0, (T)1, sum);
+		}
+		case FANN_SIGMOID_SYMMETRIC:
+			return (T)2 / ((T)1 + std::exp((T)-2 * sum)) - (T)1;
+		case FANN_SIGMOID_SYMMETRIC_STEPWISE: {
+			static const T v[] = { (T)-2.64665293693542480469e+00, (T)-1.47221934795379638672e+00, (T)-5.49306154251098632812e-01,
+				(T)5.49306154251098632812e-01, (T)1.47221934795379638672e+00, (T)2.64665293693542480469e+00 };
+			static const T r[] = { (T)-9.90000009536743164062e-01, (T)-8.99999976158142089844e-01, (T)-5.00000000000000000000e-01,
+				(T)5.00000000000000000000e-01, (T)8.99999976158142089844e-01, (T)9.90000009536743164062e-01 };
+			return activationStepwise(v, r, (T)-1, (T)1, sum);
+		}
+		case FANN_THRESHOLD:
+			return (sum < 0) ? 0 : 1;
+		case FANN_THRESHOLD_SYMMETRIC:
+			return (sum < 0) ? -1 : 1;
+		case FANN_GAUSSIAN:
+			return std::exp(-sum * sum);
+		case FANN_GAUSSIAN_SYMMETRIC:
+			return std::exp(-sum * sum) * (T)2 - (T)1;
+		case FANN_ELLIOT:
+			return (sum / (T)2) / ((T)1 + std::fabs(sum)) + (T)0.5;
+		case FANN_ELLIOT_SYMMETRIC:
+			return sum / ((T)1 + std::fabs(sum));
+		case FANN_SIN_SYMMETRIC:
+			return std::sin(sum);
+		case FANN_COS_SYMMETRIC:
+			return std::cos(sum);
+		case FANN_SIN:
+			return std::sin(sum) / (T)2 + (T)0.5;
+		case FANN_COS:
+			return std::cos(sum) / (T)2 + (T)0.5;
+		default:
+			// FANN_GAUSSIAN_STEPWISE is not supported by fann_run() either
+			return 0;
+	}
+}
+
+// The input is the neuron sum before steepness is applied
+template<typename T>
+inline T activationFunction(enum fann_activationfunc_enum fn, T steepness, T sum) {
+	return activationOfSum(fn, activationSum(steepness, sum));
+}
+
+// Derivative of the activation function, as computed by FANN's fann_activation_derived().  value is
+// the neuron's output and sum its sum from activationSum().  The threshold functions can't be trained,
+// and return 0.
+template<typename T>
+inline T activationDerived(enum fann_activationfunc_enum fn, T steepness, T value, T sum) {
+	switch (fn) {
+		case FANN_LINEAR:
+		case FANN_LINEAR_PIECE:
+		case FANN_LINEAR_PIECE_SYMMETRIC:
+			return steepness;
+		case FANN_SIGMOID:
+		case FANN_SIGMOID_STEPWISE:
+			value = (value < (T)0.01) ? (T)0.01 : (value > (T)0.99) ? (T)0.99 : value;
+			return (T)2 * steepness * value * ((T)1 - value);
+		case FANN_SIGMOID_SYMMETRIC:
+		case FANN_SIGMOID_SYMMETRIC_STEPWISE:
+			value = (value < (T)-0.98) ? (T)-0.98 : (value > (T)0.98) ? (T)0.98 : value;
+			return steepness * ((T)1 - value * value);
+		case FANN_GAUSSIAN:
+			return (T)-2 * sum * value * steepness * steepness;
+		case FANN_GAUSSIAN_SYMMETRIC:
+			return (T)-2 * sum * (value + (T)1) * steepness * steepness;
+		case FANN_ELLIOT:
+			return steepness / ((T)2 * ((T)1 + std::fabs(sum)) * ((T)1 + std::fabs(sum)));
+		case FANN_ELLIOT_SYMMETRIC:
+			return steepness / (((T)1 + std::fabs(sum)) * ((T)1 + std::fabs(sum)));
+		case FANN_SIN_SYMMETRIC:
+			return steepness * std::cos(steepness * sum);
+		case FANN_COS_SYMMETRIC:
+			return steepness * -std::sin(steepness * sum);
+		case FANN_SIN:
+			return steepness * std::cos(steepness * sum) / (T)2;
+		case FANN_COS:
+			return steepness * -std::sin(steepness * sum) / (T)2;
+		default:
+			return 0;
+	}
+}
+
+}
+
+#endif
@@ -1,11 +1,39 @@
 #include <nan.h>
+#include <node.h>
 #include "fanny.h"
 #include "training-data.h"
+#include "quantized.h"
+#include "ensemble.h"
+#include "sparse.h"
+#include "training-data-builder.h"
+#include "shared-ann.h"
+
+// The addon is loaded once per isolate (the main thread and each worker thread).  The constructor
+// handles are thread_local, and belong to the isolate running on that thread.  They're released when
+// its environment is torn down, since the isolate is disposed before the thread's storage is.
+static void cleanup(void *arg) {
+	fanny::FANNY::constructorFunctionTpl.Reset();
+	fanny::FANNY::constructorFunction.Reset();
+	fanny::TrainingData::constructorFunctionTpl.Reset();
+	fanny::QuantizedANN::constructorFunctionTpl.Reset();
+	fanny::QuantizedANN::constructorFunction.Reset();
+	fanny::Ensemble::constructorFunctionTpl.Reset();
+	fanny::Ensemble::constructorFunction.Reset();
+	fanny::SparseTrainingData::constructorFunctionTpl.Reset();
+	fanny::TrainingDataBuilder::constructorFunctionTpl.Reset();
+	fanny::SharedANN::constructorFunctionTpl.Reset();
+	fanny::SharedANN::constructorFunction.Reset();
+}
 
 NAN_MODULE_INIT(init) {
 	fanny::FANNY::Init(target);
 	fanny::TrainingData::Init(target);
+	fanny::QuantizedANN::Init(target);
+	fanny::Ensemble::Init(target);
+	fanny::SparseTrainingData::Init(target);
+	fanny::TrainingDataBuilder::Init(target);
+	fanny::SharedANN::Init(target);
+	node::AddEnvironmentCleanupHook(v8::Isolate::GetCurrent(), cleanup, NULL);
 }
 
-NODE_MODULE(fanny, init);
-
+NAN_MODULE_WORKER_ENABLED(fanny, init)
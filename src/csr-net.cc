@@ -0,0 +1,251 @@
+#include "csr-net.h"
+#include "fann-internals.h"
+#include "activation.h"
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+namespace fanny {
+
+CsrNet::CsrNet(struct fann *_ann) :
+	ann(_ann), weights(_ann->weights), totalConnections(_ann->total_connections), totalNeurons(_ann->total_neurons),
+	numInput(_ann->num_input), numOutput(_ann->num_output)
+{
+	struct fann_neuron *firstNeuron = ann->first_layer->first_neuron;
+	firstOutputNeuron = (unsigned int)((ann->last_layer - 1)->first_neuron - firstNeuron);
+	sources.resize(totalConnections);
+	for (unsigned int con = 0; con < totalConnections; ++con) {
+		sources[con] = (unsigned int)(ann->connections[con] - firstNeuron);
+	}
+	for (struct fann_layer *layer = ann->first_layer + 1; layer != ann->last_layer; ++layer) {
+		layerBegins.push_back((unsigned int)(layer->first_neuron - firstNeuron));
+		layerEnds.push_back((unsigned int)(layer->last_neuron - firstNeuron));
+	}
+}
+
+bool CsrNet::isCurrent(struct fann *_ann) const {
+	return ann == _ann && weights == _ann->weights && totalConnections == _ann->total_connections && totalNeurons == _ann->total_neurons;
+}
+
+bool CsrNet::handles(struct fann *ann) {
+	#ifndef FANNY_FIXED
+	// Fully connected networks already take FANN's contiguous fast paths
+	return ann->connection_rate < 1 && ann->network_type == FANN_NETTYPE_LAYER;
+	#else
+	return false;
+	#endif
+}
+
+void CsrNet::forward(const fann_type *input, fann_type *neuronValues, fann_type *neuronSums) const {
+	const fann_type *w = ann->weights;
+	struct fann_neuron *firstNeuron = ann->first_layer->first_neuron;
+	std::copy(input, input + numInput, neuronValues);
+	// The input layer's bias neuron
+	neuronValues[numInput] = 1;
+	for (size_t layerIdx = 0; layerIdx < layerBegins.size(); ++layerIdx) {
+		for (unsigned int neuronIdx = layerBegins[layerIdx]; neuronIdx < layerEnds[layerIdx]; ++neuronIdx) {
+			struct fann_neuron &neuron = firstNeuron[neuronIdx];
+			if (neuron.first_con == neuron.last_con) {
+				// Bias neuron
+				neuronValues[neuronIdx] = 1;
+				continue;
+			}
+			fann_type sum = 0;
+			for (unsigned int con = neuron.first_con; con < neuron.last_con; ++con) {
+				sum += w[con] * neuronValues[sources[con]];
+			}
+			sum = activationSum(neuron.activation_steepness, sum);
+			neuronSums[neuronIdx] = sum;
+			neuronValues[neuronIdx] = activationOfSum(neuron.activation_function, sum);
+		}
+	}
+}
+
+void CsrNet::run(const fann_type *input, fann_type *output, std::vector<fann_type> &scratch) const {
+	scratch.resize((size_t)totalNeurons * 2);
+	fann_type *neuronValues = &scratch[0];
+	forward(input, neuronValues, neuronValues + totalNeurons);
+	std::copy(neuronValues + firstOutputNeuron, neuronValues + firstOutputNeuron + numOutput, output);
+}
+
+#ifndef FANNY_FIXED
+
+void CsrNet::computeErrors(const fann_type *desired, const fann_type *neuronValues, const fann_type *neuronSums, fann_type *errors) {
+	struct fann_neuron *firstNeuron = ann->first_layer->first_neuron;
+	std::fill(errors, errors + totalNeurons, (fann_type)0);
+	for (unsigned int outputIdx = 0; outputIdx < numOutput; ++outputIdx) {
+		unsigned int neuronIdx = firstOutputNeuron + outputIdx;
+		struct fann_neuron &neuron = firstNeuron[neuronIdx];
+		fann_type diff = desired[outputIdx] - neuronValues[neuronIdx];
+		switch (neuron.activation_function) {
+			case FANN_LINEAR_PIECE_SYMMETRIC:
+			case FANN_THRESHOLD_SYMMETRIC:
+			case FANN_SIGMOID_SYMMETRIC:
+			case FANN_SIGMOID_SYMMETRIC_STEPWISE:
+			case FANN_ELLIOT_SYMMETRIC:
+			case FANN_GAUSSIAN_SYMMETRIC:
+			case FANN_SIN_SYMMETRIC:
+			case FANN_COS_SYMMETRIC:
+				diff /= 2;
+				break;
+			default:
+				break;
+		}
+		ann->MSE_value += (float)(diff * diff);
+		if (fabs(diff) >= ann->bit_fail_limit) ann->num_bit_fail++;
+		if (ann->train_error_function == FANN_ERRORFUNC_TANH) {
+			if (diff < -.9999999) diff = -17;
+			else if (diff > .9999999) diff = 17;
+			else diff = (fann_type)log((1.0 + diff) / (1.0 - diff));
+		}
+		errors[neuronIdx] = activationDerived(neuron.activation_function, neuron.activation_steepness, neuronValues[neuronIdx], neuronSums[neuronIdx]) * diff;
+		ann->num_MSE++;
+	}
+}
+
+void CsrNet::backpropagate(const fann_type *neuronValues, const fann_type *neuronSums, fann_type *errors) {
+	const fann_type *w = ann->weights;
+	struct fann_neuron *firstNeuron = ann->first_layer->first_neuron;
+	// No errors are propagated into the input layer
+	for (size_t layerIdx = layerBegins.size() - 1; layerIdx > 0; --layerIdx) {
+		for (unsigned int neuronIdx = layerBegins[layerIdx]; neuronIdx < layerEnds[layerIdx]; ++neuronIdx) {
+			struct fann_neuron &neuron = firstNeuron[neuronIdx];
+			fann_type error = errors[neuronIdx];
+			for (unsigned int con = neuron.first_con; con < neuron.last_con; ++con) {
+				errors[sources[con]] += error * w[con];
+			}
+		}
+		for (unsigned int neuronIdx = layerBegins[layerIdx - 1]; neuronIdx < layerEnds[layerIdx - 1]; ++neuronIdx) {
+			struct fann_neuron &neuron = firstNeuron[neuronIdx];
+			errors[neuronIdx] *= activationDerived(neuron.activation_function, neuron.activation_steepness, neuronValues[neuronIdx], neuronSums[neuronIdx]);
+		}
+	}
+}
+
+void CsrNet::updateSlopes(const fann_type *neuronValues, const fann_type *errors) {
+	fann_type *slopes = ann->train_slopes;
+	struct fann_neuron *firstNeuron = ann->first_layer->first_neuron;
+	for (size_t layerIdx = 0; layerIdx < layerBegins.size(); ++layerIdx) {
+		for (unsigned int neuronIdx = layerBegins[layerIdx]; neuronIdx < layerEnds[layerIdx]; ++neuronIdx) {
+			struct fann_neuron &neuron = firstNeuron[neuronIdx];
+			fann_type error = errors[neuronIdx];
+			for (unsigned int con = neuron.first_con; con < neuron.last_con; ++con) {
+				slopes[con] += error * neuronValues[sources[con]];
+			}
+		}
+	}
+}
+
+void CsrNet::updateWeights(const fann_type *neuronValues, const fann_type *errors) {
+	fann_type *w = ann->weights;
+	fann_type *deltas = ann->prev_weights_deltas;
+	fann_type learningRate = ann->learning_rate;
+	fann_type momentum = ann->learning_momentum;
+	struct fann_neuron *firstNeuron = ann->first_layer->first_neuron;
+	for (size_t layerIdx = 0; layerIdx < layerBegins.size(); ++layerIdx) {
+		for (unsigned int neuronIdx = layerBegins[layerIdx]; neuronIdx < layerEnds[layerIdx]; ++neuronIdx) {
+			struct fann_neuron &neuron = firstNeuron[neuronIdx];
+			fann_type scaledError = errors[neuronIdx] * learningRate;
+			for (unsigned int con = neuron.first_con; con < neuron.last_con; ++con) {
+				fann_type delta = scaledError * neuronValues[sources[con]] + momentum * deltas[con];
+				w[con] += delta;
+				deltas[con] = delta;
+			}
+		}
+	}
+}
+
+float CsrNet::trainEpoch(struct fann_train_data *data) {
+	std::vector<fann_type> neuronValues(totalNeurons), neuronSums(totalNeurons), errors(totalNeurons);
+	bool incremental = ann->training_algorithm == FANN_TRAIN_INCREMENTAL;
+	if (incremental) {
+		if (ann->prev_weights_deltas == NULL) {
+			ann->prev_weights_deltas = (fann_type *)calloc(ann->total_connections_allocated, sizeof(fann_type));
+			if (ann->prev_weights_deltas == NULL) {
+				fann_error((struct fann_error *)ann, FANN_E_CANT_ALLOCATE_MEM);
+				return 0;
+			}
+		}
+	} else {
+		if (ann->prev_train_slopes == NULL) fann_clear_train_arrays(ann);
+		if (ann->train_slopes == NULL) {
+			fann_error((struct fann_error *)ann, FANN_E_CANT_ALLOCATE_MEM);
+			return 0;
+		}
+	}
+	fann_reset_MSE(ann);
+	for (unsigned int row = 0; row < data->num_data; ++row) {
+		forward(data->input[row], &neuronValues[0], &neuronSums[0]);
+		computeErrors(data->output[row], &neuronValues[0], &neuronSums[0], &errors[0]);
+		backpropagate(&neuronValues[0], &neuronSums[0], &errors[0]);
+		if (incremental) {
+			updateWeights(&neuronValues[0], &errors[0]);
+		} else {
+			updateSlopes(&neuronValues[0], &errors[0]);
+		}
+	}
+	switch (ann->training_algorithm) {
+		case FANN_TRAIN_BATCH:
+			fann_update_weights_batch(ann, data->num_data, 0, ann->total_connections);
+			break;
+		case FANN_TRAIN_RPROP:
+			fann_update_weights_irpropm(ann, 0, ann->total_connections);
+			break;
+		case FANN_TRAIN_QUICKPROP:
+			fann_update_weights_quickprop(ann, data->num_data, 0, ann->total_connections);
+			break;
+		case FANN_TRAIN_SARPROP:
+			fann_update_weights_sarprop(ann, ann->sarprop_epoch, 0, ann->total_connections);
+			++ann->sarprop_epoch;
+			break;
+		default:
+			break;
+	}
+	return fann_get_MSE(ann);
+}
+
+float CsrNet::testData(struct fann_train_data *data) {
+	std::vector<fann_type> neuronValues(totalNeurons), neuronSums(totalNeurons), errors(totalNeurons);
+	fann_reset_MSE(ann);
+	for (unsigned int row = 0; row < data->num_data; ++row) {
+		forward(data->input[row], &neuronValues[0], &neuronSums[0]);
+		computeErrors(data->output[row], &neuronValues[0], &neuronSums[0], &errors[0]);
+	}
+	return fann_get_MSE(ann);
+}
+
+void csrTrainOnData(CsrNet &net, struct fann_train_data *data, unsigned int maxEpochs, unsigned int epochsBetweenReports, float desiredError) {
+	struct fann *ann = net.ann;
+	for (unsigned int epoch = 1; epoch <= maxEpochs; ++epoch) {
+		float error = net.trainEpoch(data);
+		if (fann_get_errno((struct fann_error *)ann)) return;
+		int desiredErrorReached = fann_desired_error_reached(ann, desiredError);
+		if (epochsBetweenReports && (
+			epoch % epochsBetweenReports == 0 || epoch == maxEpochs || epoch == 1 || desiredErrorReached == 0
+		)) {
+			if (ann->callback == NULL) {
+				printf("Epochs     %8d. Current error: %.10f. Bit fail %d.\n", epoch, error, ann->num_bit_fail);
+			} else if ((*ann->callback)(ann, data, maxEpochs, epochsBetweenReports, desiredError, epoch) == -1) {
+				break;
+			}
+		}
+		if (desiredErrorReached == 0) break;
+	}
+}
+
+#else
+
+float CsrNet::trainEpoch(struct fann_train_data *data) {
+	return 0;
+}
+
+float CsrNet::testData(struct fann_train_data *data) {
+	return 0;
+}
+
+void csrTrainOnData(CsrNet &net, struct fann_train_data *data, unsigned int maxEpochs, unsigned int epochsBetweenReports, float desiredError) {}
+
+#endif
+
+}
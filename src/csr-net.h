@@ -0,0 +1,73 @@
+#ifndef FANNY_CSR_NET_H
+#define FANNY_CSR_NET_H
+
+#include "fann-includes.h"
+#include "forward-engine.h"
+#include <vector>
+
+namespace fanny {
+
+// Compressed sparse row engine for partially connected networks (connection rate < 1).  FANN reaches
+// the source of each connection through a pointer to its fann_neuron, which scatters the reads of a
+// sparse network across the neuron structures.  This keeps the neuron values and sums in contiguous
+// arrays and the source of each connection as an index into them.  The connections into a neuron are
+// still weights[first_con .. last_con), so the network's own weights and training arrays are used in
+// place, and results match FANN's.
+//
+// Only connection structure is captured; activation functions, steepnesses, weights and training
+// parameters are read from the network on each call.  The engine must be rebuilt if the network's
+// structure changes (see isCurrent()).
+//
+// Since runs only read the network, the engine is also used (for any layered network) to run on the
+// main thread while fann_run() is in progress on a worker thread.
+class CsrNet : public ForwardEngine {
+public:
+	CsrNet(struct fann *ann);
+	bool isCurrent(struct fann *ann) const;
+	void run(const fann_type *input, fann_type *output, std::vector<fann_type> &scratch) const;
+
+	// Whether the engine should be used for a network
+	static bool handles(struct fann *ann);
+
+	struct fann *ann;
+	fann_type *weights;
+	unsigned int totalConnections;
+	unsigned int totalNeurons;
+	unsigned int numInput;
+	unsigned int numOutput;
+	unsigned int firstOutputNeuron;
+
+	// Source neuron index of each connection
+	std::vector<unsigned int> sources;
+	// Range of neuron indices in each layer after the input layer
+	std::vector<unsigned int> layerBegins;
+	std::vector<unsigned int> layerEnds;
+
+	// Runs the network on one row, as fann_run().  neuronValues and neuronSums must hold totalNeurons
+	// entries; outputs are at neuronValues + firstOutputNeuron.
+	void forward(const fann_type *input, fann_type *neuronValues, fann_type *neuronSums) const;
+
+	// Equivalent of fann_train_epoch() for the network's training algorithm.  Updates the network's MSE.
+	float trainEpoch(struct fann_train_data *data);
+
+	// Equivalent of fann_test_data()
+	float testData(struct fann_train_data *data);
+
+private:
+	// Output errors and MSE for one row, as fann_compute_MSE()
+	void computeErrors(const fann_type *desired, const fann_type *neuronValues, const fann_type *neuronSums, fann_type *errors);
+	// As fann_backpropagate_MSE()
+	void backpropagate(const fann_type *neuronValues, const fann_type *neuronSums, fann_type *errors);
+	// As fann_update_slopes_batch() over every layer
+	void updateSlopes(const fann_type *neuronValues, const fann_type *errors);
+	// As fann_update_weights(), for incremental training
+	void updateWeights(const fann_type *neuronValues, const fann_type *errors);
+};
+
+// Equivalent of fann_train_on_data(), including progress reports through the network's callback,
+// that trains each epoch with the CSR engine
+void csrTrainOnData(CsrNet &net, struct fann_train_data *data, unsigned int maxEpochs, unsigned int epochsBetweenReports, float desiredError);
+
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include "data-stats.h"
+#include <thread>
+#include <cmath>
+#include <limits>
+
+namespace fanny {
+
+// Rows below this count per thread aren't worth starting a thread for
+static const unsigned int MIN_ROWS_PER_THREAD = 4096;
+
+// Number of threads worth using for numRows rows, at most numThreads and at least 1
+static unsigned int clampThreads(unsigned int numRows, unsigned int numThreads) {
+	if (numThreads > numRows / MIN_ROWS_PER_THREAD) numThreads = numRows / MIN_ROWS_PER_THREAD;
+	return (numThreads < 1) ? 1 : numThreads;
+}
+
+// Runs fn(begin, end, threadIdx) over ranges of rows, one per thread.  numThreads must come from
+// clampThreads().
+template<typename Fn>
+static void forEachRowRange(unsigned int numRows, unsigned int numThreads, Fn fn) {
+	std::vector<std::thread> threads;
+	for (unsigned int threadIdx = 1; threadIdx < numThreads; ++threadIdx) {
+		unsigned int begin = (unsigned int)((uint64_t)numRows * threadIdx / numThreads);
+		unsigned int end = (unsigned int)((uint64_t)numRows * (threadIdx + 1) / numThreads);
+		threads.push_back(std::thread(fn, begin, end, threadIdx));
+	}
+	fn(0, (unsigned int)((uint64_t)numRows / numThreads), 0);
+	for (size_t idx = 0; idx < threads.size(); ++idx) {
+		threads[idx].join();
+	}
+}
+
+// Accumulators for one thread's rows
+struct ColumnAccumulators {
+	std::vector<double> min;
+	std::vector<double> max;
+	std::vector<double> sum;
+	std::vector<double> sumSquares;
+	std::vector<double> count;
+	std::vector<double> nanCount;
+
+	void init(unsigned int width) {
+		min.assign(width, std::numeric_limits<double>::infinity());
+		max.assign(width, -std::numeric_limits<double>::infinity());
+		sum.assign(width, 0);
+		sumSquares.assign(width, 0);
+		count.assign(width, 0);
+		nanCount.assign(width, 0);
+	}
+};
+
+void computeColumnStats(fann_type * const *rows, unsigned int numRows, unsigned int width, unsigned int numThreads, ColumnStats &stats) {
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+	// Values are accumulated relative to the first non-NaN value found in row 0 (or 0), which keeps the sums
+	// small for data far from 0
+	std::vector<double> shift(width, 0);
+	if (numRows) {
+		for (unsigned int col = 0; col < width; ++col) {
+			double value = (double)rows[0][col];
+			if (!std::isnan(value)) shift[col] = value;
+		}
+	}
+	numThreads = clampThreads(numRows, numThreads);
+	std::vector<ColumnAccumulators> accumulators(numThreads);
+	const double *shifts = shift.empty() ? NULL : &shift[0];
+	forEachRowRange(numRows, numThreads, [&](unsigned int begin, unsigned int end, unsigned int threadIdx) {
+		ColumnAccumulators &acc = accumulators[threadIdx];
+		acc.init(width);
+		double *minValues = acc.min.data();
+		double *maxValues = acc.max.data();
+		double *sums = acc.sum.data();
+		double *sumSquares = acc.sumSquares.data();
+		double *counts = acc.count.data();
+		double *nanCounts = acc.nanCount.data();
+		for (unsigned int row = begin; row < end; ++row) {
+			const fann_type *values = rows[row];
+			for (unsigned int col = 0; col < width; ++col) {
+				double value = (double)values[col];
+				// Branch free, so the loop vectorizes; NaN compares false everywhere
+				bool isNan = value != value;
+				double diff = isNan ? 0 : value - shifts[col];
+				sums[col] += diff;
+				sumSquares[col] += diff * diff;
+				counts[col] += isNan ? 0 : 1;
+				nanCounts[col] += isNan ? 1 : 0;
+				minValues[col] = (value < minValues[col]) ? value : minValues[col];
+				maxValues[col] = (value > maxValues[col]) ? value : maxValues[col];
+			}
+		}
+	});
+
+	stats.min.assign(width, std::numeric_limits<double>::infinity());
+	stats.max.assign(width, -std::numeric_limits<double>::infinity());
+	stats.mean.assign(width, 0);
+	stats.variance.assign(width, 0);
+	stats.nanCount.assign(width, 0);
+	std::vector<double> sum(width, 0), sumSquares(width, 0), count(width, 0);
+	for (size_t idx = 0; idx < accumulators.size(); ++idx) {
+		ColumnAccumulators &acc = accumulators[idx];
+		for (unsigned int col = 0; col < width; ++col) {
+			if (acc.min[col] < stats.min[col]) stats.min[col] = acc.min[col];
+			if (acc.max[col] > stats.max[col]) stats.max[col] = acc.max[col];
+			sum[col] += acc.sum[col];
+			sumSquares[col] += acc.sumSquares[col];
+			count[col] += acc.count[col];
+			stats.nanCount[col] += acc.nanCount[col];
+		}
+	}
+	for (unsigned int col = 0; col < width; ++col) {
+		if (count[col] == 0) {
+			stats.min[col] = stats.max[col] = stats.mean[col] = stats.variance[col] = nan;
+			continue;
+		}
+		double shiftedMean = sum[col] / count[col];
+		stats.mean[col] = shift[col] + shiftedMean;
+		double variance = sumSquares[col] / count[col] - shiftedMean * shiftedMean;
+		stats.variance[col] = (variance < 0) ? 0 : variance;
+	}
+}
+
+void normalizeColumns(
+	fann_type * const *rows,
+	unsigned int numRows,
+	unsigned int width,
+	const double *offset,
+	const double *scale,
+	const double *base,
+	unsigned int numThreads
+) {
+	// Fold the transform into value * factor + term in the data's own type
+	std::vector<fann_type> factors(width), terms(width);
+	for (unsigned int col = 0; col < width; ++col) {
+		factors[col] = (fann_type)scale[col];
+		terms[col] = (fann_type)(base[col] - offset[col] * scale[col]);
+	}
+	const fann_type *factor = factors.data();
+	const fann_type *term = terms.data();
+	forEachRowRange(numRows, clampThreads(numRows, numThreads), [&](unsigned int begin, unsigned int end, unsigned int threadIdx) {
+		for (unsigned int row = begin; row < end; ++row) {
+			fann_type *values = rows[row];
+			for (unsigned int col = 0; col < width; ++col) {
+				values[col] = values[col] * factor[col] + term[col];
+			}
+		}
+	});
+}
+
+}
@@ -0,0 +1,41 @@
+#ifndef FANNY_DATA_STATS_H
+#define FANNY_DATA_STATS_H
+
+#include "fann-includes.h"
+#include <vector>
+#include <stdint.h>
+
+namespace fanny {
+
+// Per-column statistics of a training data set's inputs or outputs.  NaN values are counted and
+// otherwise ignored; a column with no other values has NaN min, max, mean and variance.
+struct ColumnStats {
+	std::vector<double> min;
+	std::vector<double> max;
+	std::vector<double> mean;
+	// Population variance (divided by the number of values)
+	std::vector<double> variance;
+	std::vector<double> nanCount;
+};
+
+// Computes column statistics of numRows rows of width values in one pass, splitting the rows between up
+// to numThreads threads.  Each thread accumulates over its rows with the columns as the inner loop, so the
+// compiler can vectorize the accumulation.  Sums are kept in double, shifted by the first row's values to
+// keep the variance accurate.
+void computeColumnStats(fann_type * const *rows, unsigned int numRows, unsigned int width, unsigned int numThreads, ColumnStats &stats);
+
+// Normalizes every column in place: value = (value - offset[col]) * scale[col] + base[col].  Rows are split
+// between up to numThreads threads.
+void normalizeColumns(
+	fann_type * const *rows,
+	unsigned int numRows,
+	unsigned int width,
+	const double *offset,
+	const double *scale,
+	const double *base,
+	unsigned int numThreads
+);
+
+}
+
+#endif
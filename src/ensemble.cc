@@ -0,0 +1,310 @@
+#include "ensemble.h"
+#include "fanny.h"
+#include "utils.h"
+#include <thread>
+#include <memory>
+#include <algorithm>
+
+namespace fanny {
+
+// Converts an array or typed array of inputs.  Returns false if it's neither, or the length is wrong.
+static bool v8ToEnsembleInputs(v8::Local<v8::Value> value, unsigned int numInput, std::vector<fann_type> &inputs) {
+	if (value->IsTypedArray()) {
+		inputs.resize(numInput);
+		return typedArrayToFannData(value, &inputs[0], numInput);
+	}
+	if (!value->IsArray()) return false;
+	inputs = v8ArrayToFannData(value);
+	return inputs.size() == numInput;
+}
+
+static v8::Local<v8::Value> ensembleOutputsToV8Array(const std::vector<double> &outputs) {
+	Nan::EscapableHandleScope scope;
+	v8::Local<v8::Array> v8Array = Nan::New<v8::Array>(outputs.size());
+	for (uint32_t idx = 0; idx < outputs.size(); ++idx) {
+		Nan::Set(v8Array, idx, Nan::New<v8::Number>(outputs[idx]));
+	}
+	return scope.Escape(v8Array);
+}
+
+// State shared by the work items of one runAsync() call
+class EnsembleRun {
+public:
+	EnsembleRun(Nan::Callback *_callback, Ensemble *_ensemble, std::vector<fann_type> &_inputs, size_t _numStripes) :
+		callback(_callback),
+		ensemble(_ensemble),
+		inputs(_inputs),
+		engines(_ensemble->getMemberEngines()),
+		uniqueOutputs(_ensemble->uniqueMembers.size() * _ensemble->numOutput),
+		uniqueErrors(_ensemble->uniqueMembers.size()),
+		numStripes(_numStripes),
+		remaining(_numStripes) {}
+	~EnsembleRun() {
+		delete callback;
+	}
+
+	Nan::Callback *callback;
+	Ensemble *ensemble;
+	std::vector<fann_type> inputs;
+	std::vector<ForwardEngine *> engines;
+	// Each stripe writes only its own members' entries
+	std::vector<fann_type> uniqueOutputs;
+	std::vector<std::string> uniqueErrors;
+	size_t numStripes;
+	// Stripes that haven't completed; only touched on the main thread
+	size_t remaining;
+};
+
+// Runs one stripe of an ensemble's members on the libuv thread pool.  The last stripe to complete
+// combines the outputs and calls back.
+class EnsembleStripeWorker : public Nan::AsyncWorker {
+public:
+	EnsembleStripeWorker(std::shared_ptr<EnsembleRun> _run, v8::Local<v8::Object> ensembleHolder, size_t _stripe) :
+		Nan::AsyncWorker(NULL), run(_run), stripe(_stripe)
+	{
+		SaveToPersistent("ensembleHolder", ensembleHolder);
+	}
+
+	void Execute() {
+		run->ensemble->runStripe(&run->inputs[0], run->engines, stripe, run->numStripes, run->uniqueOutputs, run->uniqueErrors);
+	}
+
+	void HandleOKCallback() {
+		if (--run->remaining) return;
+		Nan::HandleScope scope;
+		std::vector<double> outputs;
+		std::string error;
+		if (!run->ensemble->combine(run->uniqueOutputs, run->uniqueErrors, outputs, error)) {
+			v8::Local<v8::Value> args[] = { Nan::Error(error.c_str()) };
+			run->callback->Call(1, args, async_resource);
+		} else {
+			v8::Local<v8::Value> args[] = { Nan::Null(), ensembleOutputsToV8Array(outputs) };
+			run->callback->Call(2, args, async_resource);
+		}
+	}
+
+	std::shared_ptr<EnsembleRun> run;
+	size_t stripe;
+};
+
+
+void Ensemble::Init(v8::Local<v8::Object> target) {
+	v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(New);
+	tpl->SetClassName(Nan::New("Ensemble").ToLocalChecked());
+	tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+	Nan::SetPrototypeMethod(tpl, "run", run);
+	Nan::SetPrototypeMethod(tpl, "runAsync", runAsync);
+	Nan::SetPrototypeMethod(tpl, "getNumMembers", getNumMembers);
+	Nan::SetPrototypeMethod(tpl, "getNumInput", getNumInput);
+	Nan::SetPrototypeMethod(tpl, "getNumOutput", getNumOutput);
+
+	constructorFunctionTpl.Reset(tpl);
+	v8::Local<v8::Function> ctorFunction = Nan::GetFunction(tpl).ToLocalChecked();
+	constructorFunction.Reset(ctorFunction);
+	Nan::Set(target, Nan::New("Ensemble").ToLocalChecked(), ctorFunction);
+}
+
+thread_local Nan::Persistent<v8::FunctionTemplate> Ensemble::constructorFunctionTpl;
+thread_local Nan::Persistent<v8::Function> Ensemble::constructorFunction;
+
+Ensemble::Ensemble() : mode(COMBINE_MEAN), numInput(0), numOutput(0) {}
+
+Ensemble::~Ensemble() {
+	memberHolders.Reset();
+}
+
+std::vector<ForwardEngine *> Ensemble::getMemberEngines() {
+	std::vector<ForwardEngine *> engines;
+	for (size_t uniqueIdx = 0; uniqueIdx < uniqueMembers.size(); ++uniqueIdx) {
+		engines.push_back(uniqueMembers[uniqueIdx]->getRunEngine());
+	}
+	return engines;
+}
+
+void Ensemble::runStripe(
+	const fann_type *inputs,
+	const std::vector<ForwardEngine *> &engines,
+	size_t stripe,
+	size_t numStripes,
+	std::vector<fann_type> &uniqueOutputs,
+	std::vector<std::string> &uniqueErrors
+) {
+	// Each network has its own neuron buffers, so different members can run concurrently
+	std::vector<fann_type> scratch;
+	for (size_t uniqueIdx = stripe; uniqueIdx < uniqueMembers.size(); uniqueIdx += numStripes) {
+		fann_type *memberOutput = &uniqueOutputs[uniqueIdx * numOutput];
+		if (engines[uniqueIdx]) {
+			engines[uniqueIdx]->run(inputs, memberOutput, scratch);
+			continue;
+		}
+		FANN::neural_net *net = uniqueMembers[uniqueIdx]->fann;
+		fann_type *result = net->run(const_cast<fann_type *>(inputs));
+		if (net->get_errno()) {
+			uniqueErrors[uniqueIdx] = net->get_errstr();
+			net->reset_errno();
+			net->reset_errstr();
+			continue;
+		}
+		std::copy(result, result + numOutput, memberOutput);
+	}
+}
+
+bool Ensemble::combine(
+	const std::vector<fann_type> &uniqueOutputs,
+	const std::vector<std::string> &uniqueErrors,
+	std::vector<double> &outputs,
+	std::string &error
+) {
+	for (size_t uniqueIdx = 0; uniqueIdx < uniqueErrors.size(); ++uniqueIdx) {
+		if (!uniqueErrors[uniqueIdx].empty()) {
+			error = uniqueErrors[uniqueIdx];
+			return false;
+		}
+	}
+
+	outputs.assign(numOutput, 0.0);
+	for (size_t memberIdx = 0; memberIdx < members.size(); ++memberIdx) {
+		const fann_type *memberOutput = &uniqueOutputs[uniqueMemberIndices[memberIdx] * numOutput];
+		if (mode == COMBINE_VOTE) {
+			unsigned int best = (unsigned int)(std::max_element(memberOutput, memberOutput + numOutput) - memberOutput);
+			outputs[best] += weights[memberIdx];
+		} else {
+			for (unsigned int outputIdx = 0; outputIdx < numOutput; ++outputIdx) {
+				outputs[outputIdx] += weights[memberIdx] * (double)memberOutput[outputIdx];
+			}
+		}
+	}
+	return true;
+}
+
+NAN_METHOD(Ensemble::New) {
+	#ifndef FANNY_FIXED
+	if (!info.IsConstructCall()) return Nan::ThrowError("Must be called as constructor");
+	if (info.Length() < 1 || !info[0]->IsArray()) return Nan::ThrowTypeError("First argument must be an array of FANNY");
+	v8::Local<v8::Array> memberArray = info[0].As<v8::Array>();
+	uint32_t numMembers = memberArray->Length();
+	if (numMembers == 0) return Nan::ThrowError("Ensemble must have at least one member");
+
+	std::vector<FANNY *> members;
+	v8::Local<v8::Array> holders = Nan::New<v8::Array>(numMembers);
+	v8::Local<v8::FunctionTemplate> fannyTpl = Nan::New(FANNY::constructorFunctionTpl);
+	for (uint32_t idx = 0; idx < numMembers; ++idx) {
+		v8::Local<v8::Value> member = Nan::Get(memberArray, idx).ToLocalChecked();
+		if (!member->IsObject() || !fannyTpl->HasInstance(member)) {
+			return Nan::ThrowTypeError("Ensemble members must be FANNY instances");
+		}
+		FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(member.As<v8::Object>());
+		if (idx > 0 && (
+			fanny->fann->get_num_input() != members[0]->fann->get_num_input() ||
+			fanny->fann->get_num_output() != members[0]->fann->get_num_output()
+		)) {
+			return Nan::ThrowError("Ensemble members must all have the same number of inputs and outputs");
+		}
+		members.push_back(fanny);
+		Nan::Set(holders, idx, member);
+	}
+
+	CombineMode mode = COMBINE_MEAN;
+	bool weightsRequired = false;
+	std::vector<double> weights(numMembers, 1.0);
+	if (info.Length() >= 2 && info[1]->IsObject()) {
+		v8::Local<v8::Object> options = info[1].As<v8::Object>();
+		v8::Local<v8::Value> modeValue = Nan::Get(options, Nan::New("mode").ToLocalChecked()).ToLocalChecked();
+		if (!modeValue->IsUndefined()) {
+			if (!modeValue->IsString()) return Nan::ThrowTypeError("mode must be a string");
+			std::string modeStr(*Nan::Utf8String(modeValue));
+			if (modeStr.compare("mean") == 0) mode = COMBINE_MEAN;
+			else if (modeStr.compare("weighted") == 0) { mode = COMBINE_MEAN; weightsRequired = true; }
+			else if (modeStr.compare("vote") == 0) mode = COMBINE_VOTE;
+			else return Nan::ThrowError("mode must be one of mean, weighted or vote");
+		}
+		v8::Local<v8::Value> weightsValue = Nan::Get(options, Nan::New("weights").ToLocalChecked()).ToLocalChecked();
+		if (!weightsValue->IsUndefined() && !weightsRequired && mode == COMBINE_MEAN) {
+			return Nan::ThrowError("weights are only used by the weighted and vote modes");
+		}
+		if (!weightsValue->IsUndefined()) {
+			if (!weightsValue->IsArray() || weightsValue.As<v8::Array>()->Length() != numMembers) {
+				return Nan::ThrowError("weights must be an array with one number per member");
+			}
+			for (uint32_t idx = 0; idx < numMembers; ++idx) {
+				v8::Local<v8::Value> weight = Nan::Get(weightsValue.As<v8::Array>(), idx).ToLocalChecked();
+				if (!weight->IsNumber()) return Nan::ThrowTypeError("weights must be numbers");
+				weights[idx] = Nan::To<double>(weight).FromJust();
+				if (weights[idx] < 0) return Nan::ThrowError("weights must not be negative");
+			}
+			weightsRequired = false;
+		}
+	}
+	if (weightsRequired) return Nan::ThrowError("weighted mode requires weights");
+	double weightSum = 0;
+	for (uint32_t idx = 0; idx < numMembers; ++idx) weightSum += weights[idx];
+	if (weightSum <= 0) return Nan::ThrowError("weights must not all be zero");
+	for (uint32_t idx = 0; idx < numMembers; ++idx) weights[idx] /= weightSum;
+
+	Ensemble *obj = new Ensemble();
+	obj->members = members;
+	for (uint32_t idx = 0; idx < numMembers; ++idx) {
+		size_t uniqueIdx = std::find(obj->uniqueMembers.begin(), obj->uniqueMembers.end(), members[idx]) - obj->uniqueMembers.begin();
+		if (uniqueIdx == obj->uniqueMembers.size()) obj->uniqueMembers.push_back(members[idx]);
+		obj->uniqueMemberIndices.push_back(uniqueIdx);
+	}
+	obj->weights = weights;
+	obj->mode = mode;
+	obj->numInput = members[0]->fann->get_num_input();
+	obj->numOutput = members[0]->fann->get_num_output();
+	obj->memberHolders.Reset(holders);
+	obj->Wrap(info.This());
+	info.GetReturnValue().Set(info.This());
+	#else
+	Nan::ThrowError("Not supported for fixed FANN");
+	#endif
+}
+
+NAN_METHOD(Ensemble::run) {
+	Ensemble *ensemble = Nan::ObjectWrap::Unwrap<Ensemble>(info.Holder());
+	if (info.Length() != 1) return Nan::ThrowError("Takes one argument");
+	std::vector<fann_type> inputs;
+	if (!v8ToEnsembleInputs(info[0], ensemble->numInput, inputs)) return Nan::ThrowError("Wrong number of inputs");
+	size_t numUnique = ensemble->uniqueMembers.size();
+	std::vector<fann_type> uniqueOutputs(numUnique * ensemble->numOutput);
+	std::vector<std::string> uniqueErrors(numUnique);
+	ensemble->runStripe(&inputs[0], ensemble->getMemberEngines(), 0, 1, uniqueOutputs, uniqueErrors);
+	std::vector<double> outputs;
+	std::string error;
+	if (!ensemble->combine(uniqueOutputs, uniqueErrors, outputs, error)) return Nan::ThrowError(error.c_str());
+	info.GetReturnValue().Set(ensembleOutputsToV8Array(outputs));
+}
+
+NAN_METHOD(Ensemble::runAsync) {
+	Ensemble *ensemble = Nan::ObjectWrap::Unwrap<Ensemble>(info.Holder());
+	if (info.Length() != 2) return Nan::ThrowError("Takes two arguments");
+	if (!info[1]->IsFunction()) return Nan::ThrowError("Second argument must be callback");
+	std::vector<fann_type> inputs;
+	if (!v8ToEnsembleInputs(info[0], ensemble->numInput, inputs)) return Nan::ThrowError("Wrong number of inputs");
+	// One work item per stripe of members, so the thread pool runs them in parallel without the ensemble
+	// starting threads of its own
+	unsigned int maxStripes = std::thread::hardware_concurrency();
+	size_t numStripes = std::max<size_t>(1, std::min<size_t>(maxStripes ? maxStripes : 1, ensemble->uniqueMembers.size()));
+	std::shared_ptr<EnsembleRun> run = std::make_shared<EnsembleRun>(new Nan::Callback(info[1].As<v8::Function>()), ensemble, inputs, numStripes);
+	for (size_t stripe = 0; stripe < numStripes; ++stripe) {
+		Nan::AsyncQueueWorker(new EnsembleStripeWorker(run, info.Holder(), stripe));
+	}
+}
+
+NAN_METHOD(Ensemble::getNumMembers) {
+	Ensemble *ensemble = Nan::ObjectWrap::Unwrap<Ensemble>(info.Holder());
+	info.GetReturnValue().Set((uint32_t)ensemble->members.size());
+}
+
+NAN_METHOD(Ensemble::getNumInput) {
+	Ensemble *ensemble = Nan::ObjectWrap::Unwrap<Ensemble>(info.Holder());
+	info.GetReturnValue().Set(ensemble->numInput);
+}
+
+NAN_METHOD(Ensemble::getNumOutput) {
+	Ensemble *ensemble = Nan::ObjectWrap::Unwrap<Ensemble>(info.Holder());
+	info.GetReturnValue().Set(ensemble->numOutput);
+}
+
+}
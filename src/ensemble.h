@@ -0,0 +1,90 @@
+#ifndef FANNY_ENSEMBLE_H
+#define FANNY_ENSEMBLE_H
+
+#include <nan.h>
+#include "fann-includes.h"
+#include "forward-engine.h"
+#include <vector>
+#include <string>
+
+namespace fanny {
+
+class FANNY;
+
+// Several networks with the same number of inputs and outputs, run together on one input with
+// their outputs combined natively.  Members are referenced, not copied, so they must not be
+// trained or run elsewhere while the ensemble is running them.
+class Ensemble : public Nan::ObjectWrap {
+
+public:
+	static void Init(v8::Local<v8::Object> target);
+
+	static thread_local Nan::Persistent<v8::FunctionTemplate> constructorFunctionTpl;
+	static thread_local Nan::Persistent<v8::Function> constructorFunction;
+
+	enum CombineMode {
+		// Average of the member outputs, weighted if weights were given
+		COMBINE_MEAN,
+		// Each member votes for its highest output; each output is the weighted fraction of votes it got
+		COMBINE_VOTE
+	};
+
+	std::vector<FANNY *> members;
+	// Distinct members, and the index into it of each member.  A network that's in the ensemble more than
+	// once is only run once, since fann_run() can't run the same network on two threads at a time.
+	std::vector<FANNY *> uniqueMembers;
+	std::vector<size_t> uniqueMemberIndices;
+	// Per-member weights, normalized to sum to 1
+	std::vector<double> weights;
+	CombineMode mode;
+	unsigned int numInput;
+	unsigned int numOutput;
+
+	// Each distinct member's forward engine (see FANNY::getRunEngine()), or NULL for members run with
+	// fann_run().  Must be called from the main thread.
+	std::vector<ForwardEngine *> getMemberEngines();
+
+	// Runs every numStripes'th distinct member starting at stripe, using the engines from getMemberEngines().
+	// Writes numOutput outputs per distinct member to uniqueOutputs, or a message to uniqueErrors on failure.
+	void runStripe(
+		const fann_type *inputs,
+		const std::vector<ForwardEngine *> &engines,
+		size_t stripe,
+		size_t numStripes,
+		std::vector<fann_type> &uniqueOutputs,
+		std::vector<std::string> &uniqueErrors
+	);
+
+	// Combines the outputs of the distinct members into outputs (numOutput entries).  Returns false and
+	// sets error if a member failed.
+	bool combine(
+		const std::vector<fann_type> &uniqueOutputs,
+		const std::vector<std::string> &uniqueErrors,
+		std::vector<double> &outputs,
+		std::string &error
+	);
+
+private:
+	// Javascript Constructor.  Takes an array of FANNY instances and an options object with:
+	// - mode (string) - "mean" (default), "weighted" or "vote"
+	// - weights (array of numbers) - One per member; required for "weighted", optional for "vote"
+	static NAN_METHOD(New);
+
+	Ensemble();
+	~Ensemble();
+
+	// Keeps the member FANNY objects alive
+	Nan::Persistent<v8::Array> memberHolders;
+
+	// Runs the ensemble on the calling thread.  Takes an array or typed array of inputs.
+	static NAN_METHOD(run);
+	// Runs the members in parallel, split across libuv work items.  Takes inputs and a callback.
+	static NAN_METHOD(runAsync);
+	static NAN_METHOD(getNumMembers);
+	static NAN_METHOD(getNumInput);
+	static NAN_METHOD(getNumOutput);
+};
+
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef FANNY_FANN_INTERNALS_H
+#define FANNY_FANN_INTERNALS_H
+
+#include "fann-includes.h"
+#include <stdio.h>
+
+// Internal FANN functions (declared in fann_internal.h, which isn't installed), used to read and
+// write the FANN network format from memory streams instead of named files
+extern "C" {
+int fann_save_internal_fd(struct fann *ann, FILE *conf, const char *configuration_file, unsigned int save_as_fixed);
+struct fann *fann_create_from_fd(FILE *conf, const char *configuration_file);
+
+// Steps of fann_cascadetrain_on_data(), used to run the candidate phase on several threads
+int fann_train_outputs(struct fann *ann, struct fann_train_data *data, float desired_error);
+int fann_initialize_candidates(struct fann *ann);
+int fann_train_candidates(struct fann *ann, struct fann_train_data *data);
+void fann_install_candidate(struct fann *ann);
+void fann_set_shortcut_connections(struct fann *ann);
+int fann_desired_error_reached(struct fann *ann, float desired_error);
+
+// Training steps, used by the CSR engine (csr-net.h) to apply FANN's weight updates to slopes it computed
+void fann_clear_train_arrays(struct fann *ann);
+void fann_update_weights_batch(struct fann *ann, unsigned int num_data, unsigned int first_weight, unsigned int past_end);
+void fann_update_weights_irpropm(struct fann *ann, unsigned int first_weight, unsigned int past_end);
+void fann_update_weights_quickprop(struct fann *ann, unsigned int num_data, unsigned int first_weight, unsigned int past_end);
+void fann_update_weights_sarprop(struct fann *ann, unsigned int epoch, unsigned int first_weight, unsigned int past_end);
+void fann_error(struct fann_error *errdat, const enum fann_errno_enum errno_f, ...);
+void fann_init_error_data(struct fann_error *errdat);
+}
+
+namespace fanny {
+
+// The FANN C++ wrapper classes keep their underlying C structures in protected members.
+// These accessors expose them (via a pointer-to-member through a derived class) so that
+// features which need the raw training arrays or data buffers don't require patching FANN.
+class NeuralNetAccessor : public FANN::neural_net {
+public:
+	static struct fann *get(FANN::neural_net &net) {
+		return net.*(&NeuralNetAccessor::ann);
+	}
+	static void set(FANN::neural_net &net, struct fann *ann) {
+		net.*(&NeuralNetAccessor::ann) = ann;
+	}
+};
+
+class TrainingDataAccessor : public FANN::training_data {
+public:
+	static struct fann_train_data *get(FANN::training_data &data) {
+		return data.*(&TrainingDataAccessor::train_data);
+	}
+	static void set(FANN::training_data &data, struct fann_train_data *trainData) {
+		data.*(&TrainingDataAccessor::train_data) = trainData;
+	}
+};
+
+inline struct fann *getFannStruct(FANN::neural_net *net) {
+	return NeuralNetAccessor::get(*net);
+}
+
+// Replaces the network's underlying structure without destroying the old one
+inline void setFannStruct(FANN::neural_net *net, struct fann *ann) {
+	NeuralNetAccessor::set(*net, ann);
+}
+
+inline struct fann_train_data *getFannTrainDataStruct(FANN::training_data *data) {
+	return TrainingDataAccessor::get(*data);
+}
+
+// Replaces the data's underlying structure, destroying the old one
+inline void setFannTrainDataStruct(FANN::training_data *data, struct fann_train_data *trainData) {
+	data->destroy_train();
+	TrainingDataAccessor::set(*data, trainData);
+}
+
+}
+
+#endif
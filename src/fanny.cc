@@ -2,31 +2,51 @@
 #include <nan.h>
 #include "fann-includes.h"
 #include <iostream>
+#include <algorithm>
 #include "utils.h"
 #include "training-data.h"
+#include "fann-internals.h"
+#include "quantized.h"
+#include "shared-ann.h"
+#include "parallel-cascade.h"
+#include "weight-init.h"
 
 namespace fanny {
 
+// Reads the optional "scale" argument of the run methods.  Throws a JS error and returns false if
+// scaling was requested on a fixed point network.
+static bool v8ToRunScale(v8::Local<v8::Value> value, bool &scale) {
+	scale = value->IsTrue();
+	#ifdef FANNY_FIXED
+	if (scale) {
+		Nan::ThrowError("Scaling is not supported for fixed FANN");
+		return false;
+	}
+	#endif
+	return true;
+}
+
 class RunWorker : public Nan::AsyncWorker {
 
 public:
-	RunWorker(Nan::Callback *callback, std::vector<fann_type> & _inputs, v8::Local<v8::Object> fannyHolder) : Nan::AsyncWorker(callback), inputs(_inputs) {
+	RunWorker(
+		Nan::Callback *callback,
+		std::vector<fann_type> & _inputs,
+		unsigned int _numRows,
+		bool _scale,
+		RunResultFormat _format,
+		v8::Local<v8::Object> fannyHolder
+	) : Nan::AsyncWorker(callback), inputs(_inputs), numRows(_numRows), scale(_scale), format(_format) {
 		SaveToPersistent("fannyHolder", fannyHolder);
 		fanny = Nan::ObjectWrap::Unwrap<FANNY>(fannyHolder);
+		engine = fanny->getRunEngine();
 	}
 	~RunWorker() {}
 
 	void Execute() {
-		fann_type *fannOutputs = fanny->fann->run(&inputs[0]);
-		if (fanny->fann->get_errno()) {
-			SetErrorMessage(fanny->fann->get_errstr().c_str());
-			fanny->fann->reset_errno();
-			fanny->fann->reset_errstr();
-			return;
-		}
-		unsigned int numOutputs = fanny->fann->get_num_output();
-		for (unsigned int idx = 0; idx < numOutputs; idx++) {
-			outputs.push_back(fannOutputs[idx]);
+		outputs.resize((size_t)numRows * fanny->fann->get_num_output());
+		if (!runEngineRows(getFannStruct(fanny->fann), engine, &inputs[0], numRows, scale, &outputs[0])) {
+			SetErrorMessage("Network has no scaling parameters");
 		}
 	}
 
@@ -34,26 +54,143 @@ public:
 		Nan::HandleScope scope;
 		v8::Local<v8::Value> args[] = {
 			Nan::Null(),
-			fannDataToV8Array(&outputs[0], outputs.size())
+			runOutputsToV8(outputs, numRows, fanny->fann->get_num_output(), format)
 		};
 		callback->Call(2, args, async_resource);
 	}
 
 	std::vector<fann_type> inputs;
 	std::vector<fann_type> outputs;
+	unsigned int numRows;
+	ForwardEngine *engine;
+	bool scale;
+	RunResultFormat format;
+	FANNY *fanny;
+};
+
+class SparseRunWorker : public Nan::AsyncWorker {
+public:
+	SparseRunWorker(Nan::Callback *callback, v8::Local<v8::Object> fannyHolder, SparseRows &_rows) : Nan::AsyncWorker(callback), rows(_rows) {
+		SaveToPersistent("fannyHolder", fannyHolder);
+		fanny = Nan::ObjectWrap::Unwrap<FANNY>(fannyHolder);
+		plan = fanny->getSparsePlan();
+	}
+
+	void Execute() {
+		unsigned int numRows = rows.numRows();
+		std::vector<fann_type> neuronValues(plan->totalNeurons), neuronSums(plan->totalNeurons);
+		outputs.resize((size_t)numRows * plan->numOutput);
+		for (unsigned int row = 0; row < numRows; ++row) {
+			unsigned int entryBegin = rows.rowOffsets[row];
+			plan->forward(rows.indices.data() + entryBegin, rows.values.data() + entryBegin, rows.rowOffsets[row + 1] - entryBegin, &neuronValues[0], &neuronSums[0]);
+			std::copy(&neuronValues[plan->firstOutputNeuron], &neuronValues[plan->firstOutputNeuron] + plan->numOutput, &outputs[(size_t)row * plan->numOutput]);
+		}
+	}
+
+	void HandleOKCallback() {
+		Nan::HandleScope scope;
+		v8::Local<v8::Value> args[] = { Nan::Null(), fannDataToTypedArray(&outputs[0], outputs.size()) };
+		callback->Call(2, args, async_resource);
+	}
+
+	FANNY *fanny;
+	SparseNetPlan *plan;
+	SparseRows rows;
+	std::vector<fann_type> outputs;
+};
+
+class SparseTrainWorker : public Nan::AsyncWorker {
+public:
+	SparseTrainWorker(
+		Nan::Callback *callback,
+		v8::Local<v8::Object> fannyHolder,
+		v8::Local<v8::Object> dataHolder,
+		unsigned int _maxEpochs,
+		float _desiredError
+	) : Nan::AsyncWorker(callback), maxEpochs(_maxEpochs), desiredError(_desiredError), retVal(-1) {
+		SaveToPersistent("fannyHolder", fannyHolder);
+		SaveToPersistent("sparseDataHolder", dataHolder);
+		fanny = Nan::ObjectWrap::Unwrap<FANNY>(fannyHolder);
+		data = Nan::ObjectWrap::Unwrap<SparseTrainingData>(dataHolder);
+		plan = fanny->getSparsePlan();
+	}
+
+	void Execute() {
+		#ifndef FANNY_FIXED
+		struct fann *ann = getFannStruct(fanny->fann);
+		for (unsigned int epoch = 0; epoch < maxEpochs; ++epoch) {
+			retVal = plan->trainEpoch(data->inputs, &data->outputs[0]);
+			if (fann_desired_error_reached(ann, desiredError) == 0) break;
+		}
+		#endif
+	}
+
+	void HandleOKCallback() {
+		Nan::HandleScope scope;
+		v8::Local<v8::Value> args[] = { Nan::Null(), Nan::New(retVal) };
+		callback->Call(2, args, async_resource);
+	}
+
 	FANNY *fanny;
+	SparseTrainingData *data;
+	SparseNetPlan *plan;
+	unsigned int maxEpochs;
+	float desiredError;
+	float retVal;
 };
 
 class LoadFileWorker : public Nan::AsyncWorker {
 public:
-	LoadFileWorker(Nan::Callback *callback, std::string _filename) : Nan::AsyncWorker(callback), filename(_filename) {}
+	// With mapped set, filename is a model file (see model-file.h) whose weights are used in place
+	LoadFileWorker(Nan::Callback *callback, std::string _filename, bool _loadTrainState, bool _mapped = false) :
+		Nan::AsyncWorker(callback), filename(_filename), loadTrainState(_loadTrainState), mapped(_mapped), bufferData(NULL), bufferLength(0), mapping(NULL) {}
+	// Load from a Buffer containing a FANN network file instead
+	LoadFileWorker(Nan::Callback *callback, v8::Local<v8::Object> buffer) :
+		Nan::AsyncWorker(callback), loadTrainState(false), mapped(false), mapping(NULL)
+	{
+		SaveToPersistent("buffer", buffer);
+		bufferData = node::Buffer::Data(buffer);
+		bufferLength = node::Buffer::Length(buffer);
+	}
 	~LoadFileWorker() {}
 
 	void Execute() {
-		struct fann *ann = fann_create_from_file(filename.c_str());
+		struct fann *ann;
+		if (mapped) {
+			std::string errorMessage;
+			ann = fanny::loadModelFile(filename, mapping, errorMessage);
+			if (!ann) return SetErrorMessage(errorMessage.c_str());
+			// Take the structure as it is, since copying it would copy the weights out of the mapping
+			fann = new FANN::neural_net();
+			setFannStruct(fann, ann);
+			return;
+		}
+		if (bufferData) {
+			FILE *stream = fmemopen(bufferData, bufferLength, "r");
+			if (!stream) return SetErrorMessage("Error reading FANN buffer");
+			ann = fann_create_from_fd(stream, "<buffer>");
+			fclose(stream);
+		} else {
+			ann = fann_create_from_file(filename.c_str());
+		}
 		if (!ann) return SetErrorMessage("Error loading FANN file");
 		fann = new FANN::neural_net(ann);
 		fann_destroy(ann);
+		if (loadTrainState) {
+			std::string errorMessage;
+			if (!trainState.loadFromFile(TrainState::sidecarFilename(filename), errorMessage)) {
+				delete fann;
+				return SetErrorMessage(errorMessage.c_str());
+			}
+			if (!trainState.matches(getFannStruct(fann))) {
+				delete fann;
+				return SetErrorMessage("Training state does not match the network weights");
+			}
+			if (!trainState.apply(getFannStruct(fann), errorMessage)) {
+				delete fann;
+				return SetErrorMessage(errorMessage.c_str());
+			}
+		}
 	}
 
 	void HandleOKCallback() {
@@ -66,22 +203,73 @@ public:
 			v8::Local<v8::Value> externFann = Nan::New<v8::External>(fann);
 			v8::Local<v8::Function> ctor = Nan::New(FANNY::constructorFunction);
 			v8::Local<v8::Value> ctorArgs[] = { externFann };
+			v8::Local<v8::Object> stateInfo = Nan::New<v8::Object>();
+			if (loadTrainState) {
+				Nan::Set(stateInfo, Nan::New("epochs").ToLocalChecked(), Nan::New(trainState.epochs));
+				Nan::Set(stateInfo, Nan::New("mse").ToLocalChecked(), Nan::New(trainState.mse));
+			}
+			v8::Local<v8::Object> instance = Nan::NewInstance(ctor, 1, ctorArgs).ToLocalChecked();
+			// The FANNY owns the mapping now
+			Nan::ObjectWrap::Unwrap<FANNY>(instance)->mappedModel = mapping;
 			v8::Local<v8::Value> cbargs[] = {
 				Nan::Null(),
-				Nan::NewInstance(ctor, 1, ctorArgs).ToLocalChecked()
+				instance,
+				stateInfo
 			};
-			callback->Call(2, cbargs, async_resource);
+			callback->Call(3, cbargs, async_resource);
 		}
 	}
 
 	std::string filename;
+	bool loadTrainState;
+	bool mapped;
+	char *bufferData;
+	size_t bufferLength;
+	TrainState trainState;
 	FANN::neural_net *fann;
+	MappedModel *mapping;
+};
+
+class ExportBufferWorker : public Nan::AsyncWorker {
+public:
+	ExportBufferWorker(Nan::Callback *callback, v8::Local<v8::Object> fannyHolder, bool _asFixed) :
+		Nan::AsyncWorker(callback), asFixed(_asFixed), data(NULL), length(0)
+	{
+		SaveToPersistent("fannyHolder", fannyHolder);
+		fanny = Nan::ObjectWrap::Unwrap<FANNY>(fannyHolder);
+	}
+	~ExportBufferWorker() {
+		if (data) free(data);
+	}
+
+	void Execute() {
+		FILE *stream = open_memstream(&data, &length);
+		if (!stream) return SetErrorMessage("Error allocating FANN buffer");
+		int result = fann_save_internal_fd(getFannStruct(fanny->fann), stream, "<buffer>", asFixed ? 1 : 0);
+		fclose(stream);
+		if (result == -1) SetErrorMessage("Error serializing FANN network");
+	}
+
+	void HandleOKCallback() {
+		Nan::HandleScope scope;
+		// The Buffer takes ownership of the stream's memory
+		v8::Local<v8::Object> buffer = Nan::NewBuffer(data, (uint32_t)length).ToLocalChecked();
+		data = NULL;
+		v8::Local<v8::Value> args[] = { Nan::Null(), buffer };
+		callback->Call(2, args, async_resource);
+	}
+
+	FANNY *fanny;
+	bool asFixed;
+	char *data;
+	size_t length;
 };
 
 class SaveFileWorker : public Nan::AsyncWorker {
 public:
-	SaveFileWorker(Nan::Callback *callback, v8::Local<v8::Object> fannyHolder, std::string _filename, bool _isFixed) :
-		Nan::AsyncWorker(callback), filename(_filename), isFixed(_isFixed)
+	// With asModel set, writes a model file (see model-file.h) instead of FANN's format
+	SaveFileWorker(Nan::Callback *callback, v8::Local<v8::Object> fannyHolder, std::string _filename, bool _isFixed, bool _saveTrainState, bool _asModel = false) :
+		Nan::AsyncWorker(callback), filename(_filename), isFixed(_isFixed), saveTrainState(_saveTrainState), asModel(_asModel)
 	{
 		SaveToPersistent("fannyHolder", fannyHolder);
 		fanny = Nan::ObjectWrap::Unwrap<FANNY>(fannyHolder);
@@ -90,6 +278,12 @@ public:
 
 	void Execute() {
 		bool hasError = false;
+		if (asModel) {
+			std::string errorMessage;
+			if (!fanny::saveModelFile(getFannStruct(fanny->fann), filename, errorMessage)) SetErrorMessage(errorMessage.c_str());
+			decimalPoint = 0;
+			return;
+		}
 		if (isFixed) {
 			decimalPoint = fanny->fann->save_to_fixed(filename);
 		} else {
@@ -102,6 +296,13 @@ public:
 			fanny->fann->reset_errstr();
 		} else if (hasError) {
 			SetErrorMessage("Error saving FANN file");
+		} else if (saveTrainState) {
+			TrainState trainState;
+			trainState.capture(getFannStruct(fanny->fann));
+			std::string errorMessage;
+			if (!trainState.saveToFile(TrainState::sidecarFilename(filename), errorMessage)) {
+				SetErrorMessage(errorMessage.c_str());
+			}
 		}
 	}
 
@@ -114,6 +315,8 @@ public:
 	FANNY *fanny;
 	std::string filename;
 	bool isFixed;
+	bool saveTrainState;
+	bool asModel;
 	int decimalPoint;
 };
 
@@ -130,6 +333,8 @@ public:
 	bool singleEpoch;
 	bool isTest;
 
+	CsrNet *csrNet;
+
 	float retVal;
 	const ExecutionProgress *executionProgress;
 
@@ -145,7 +350,7 @@ public:
 		float _desiredError,
 		bool _singleEpoch,
 		bool _isTest
-	) : Nan::AsyncProgressWorker(callback), trainFromFile(_trainFromFile), filename(_filename),
+	) : Nan::AsyncProgressWorker(callback), trainingData(NULL), trainFromFile(_trainFromFile), filename(_filename),
 	isCascade(_isCascade), maxIterations(_maxIterations), iterationsBetweenReports(_iterationsBetweenReports),
 	desiredError(_desiredError), singleEpoch(_singleEpoch), isTest(_isTest), retVal(-1) {
 		SaveToPersistent("fannyHolder", fannyHolder);
@@ -155,6 +360,7 @@ public:
 			SaveToPersistent("tdHolder", trainingDataHolder);
 			trainingData = Nan::ObjectWrap::Unwrap<TrainingData>(trainingDataHolder);
 		}
+		csrNet = isCascade ? NULL : fanny->getCsrNet();
 	}
 
 	void Execute(const ExecutionProgress &progress) {
@@ -162,7 +368,11 @@ public:
 		fanny->currentTrainWorker = this;
 		fanny->cancelTrainingFlag = false;
 		#ifndef FANNY_FIXED
-		if (isTest) {
+		bool checkpointing = fanny->checkpointer && !singleEpoch && !isTest;
+		if (checkpointing) fanny->checkpointer->start();
+		if (csrNet) {
+			csrTrain();
+		} else if (isTest) {
 			retVal = fanny->fann->test_data(*trainingData->trainingData);
 		} else if (singleEpoch) {
 			retVal = fanny->fann->train_epoch(*trainingData->trainingData);
@@ -170,6 +380,8 @@ public:
 			fanny->fann->train_on_data(*trainingData->trainingData, maxIterations, iterationsBetweenReports, desiredError);
 		} else if (trainFromFile && !isCascade) {
 			fanny->fann->train_on_file(filename, maxIterations, iterationsBetweenReports, desiredError);
+		} else if (isCascade && fanny->cascadeThreads > 1) {
+			parallelCascadeTrain();
 		} else if (!trainFromFile && isCascade) {
 			fanny->fann->cascadetrain_on_data(*trainingData->trainingData, maxIterations, iterationsBetweenReports, desiredError);
 		} else if (trainFromFile && isCascade) {
@@ -182,10 +394,66 @@ public:
 		} else if (!singleEpoch && !isTest) {
 			retVal = fanny->fann->get_MSE();
 		}
+		// Don't report completion until the last checkpoint is on disk
+		std::string checkpointError;
+		if (checkpointing && !fanny->checkpointer->flush(checkpointError) && !ErrorMessage()) {
+			SetErrorMessage(checkpointError.c_str());
+		}
 		#endif
 		fanny->currentTrainWorker = NULL;
 	}
 
+	// Training and testing of partially connected networks with the CSR engine
+	void csrTrain() {
+		#ifndef FANNY_FIXED
+		FANN::training_data fileData;
+		FANN::training_data *data = trainingData ? trainingData->trainingData : NULL;
+		if (trainFromFile) {
+			if (!fileData.read_train_from_file(filename)) return SetErrorMessage("Could not read training data file");
+			data = &fileData;
+		}
+		struct fann_train_data *trainData = getFannTrainDataStruct(data);
+		if (trainData->num_input != csrNet->numInput || trainData->num_output != csrNet->numOutput) {
+			return SetErrorMessage("Training data does not match the network's inputs and outputs");
+		}
+		if (isTest) {
+			retVal = csrNet->testData(trainData);
+		} else if (singleEpoch) {
+			retVal = csrNet->trainEpoch(trainData);
+		} else {
+			csrTrainOnData(*csrNet, trainData, maxIterations, iterationsBetweenReports, desiredError);
+		}
+		#endif
+	}
+
+	void parallelCascadeTrain() {
+		#ifndef FANNY_FIXED
+		FANN::training_data fileData;
+		FANN::training_data *data = trainingData ? trainingData->trainingData : NULL;
+		if (trainFromFile) {
+			if (!fileData.read_train_from_file(filename)) return SetErrorMessage("Could not read training data file");
+			data = &fileData;
+		}
+		std::string error;
+		if (!parallelCascadetrainOnData(
+			fanny->fann,
+			getFannTrainDataStruct(data),
+			maxIterations,
+			iterationsBetweenReports,
+			desiredError,
+			fanny->cascadeThreads,
+			error
+		)) {
+			SetErrorMessage(error.c_str());
+		}
+		#endif
+	}
+
+	void WorkComplete() {
+		if (trainingData) trainingData->release(false);
+		Nan::AsyncProgressWorker::WorkComplete();
+	}
+
 	void HandleOKCallback() {
 		Nan::HandleScope scope;
 		if (fanny->cancelTrainingFlag) {
@@ -215,6 +483,220 @@ public:
 	}
 };
 
+// Network construction parameters, parsed from the JS options object on the main thread
+// so the construction itself can happen on a worker thread
+class CreateOptions {
+public:
+	CreateOptions() : connectionRate(0.5), hasSeed(false), seed(0) {}
+	std::string type;
+	std::vector<unsigned int> layers;
+	float connectionRate;
+	bool hasSeed;
+	uint64_t seed;
+};
+
+// Parses the constructor options object.  Options can include:
+// - type (string) - One of "standard", "sparse", "shortcut"
+// - layers (array of numbers)
+// - connectionRate (number) - For sparse networks
+// - seed (number) - Seeds the network's random stream and draws the initial weights from it
+// Throws a JS error and returns false if the options are invalid.
+static bool parseCreateOptions(v8::Local<v8::Object> optionsObj, CreateOptions &options) {
+	// Get the type option
+	Nan::MaybeLocal<v8::Value> maybeType = Nan::Get(optionsObj, Nan::New("type").ToLocalChecked());
+	if (!maybeType.IsEmpty()) {
+		v8::Local<v8::Value> localType = maybeType.ToLocalChecked();
+		if (localType->IsString()) {
+			options.type = std::string(*(Nan::Utf8String(localType->ToString(Nan::GetCurrentContext()).FromMaybe(v8::Local<v8::String>()))));
+		}
+	}
+
+	// Get the layers option
+	Nan::MaybeLocal<v8::Value> maybeLayers = Nan::Get(optionsObj, Nan::New("layers").ToLocalChecked());
+	if (!maybeLayers.IsEmpty()) {
+		v8::Local<v8::Value> localLayers = maybeLayers.ToLocalChecked();
+		if (localLayers->IsArray()) {
+			v8::Local<v8::Array> arrayLayers = localLayers.As<v8::Array>();
+			uint32_t length = arrayLayers->Length();
+			for (uint32_t idx = 0; idx < length; ++idx) {
+				Nan::MaybeLocal<v8::Value> maybeIdxValue = Nan::Get(arrayLayers, idx);
+				if (!maybeIdxValue.IsEmpty()) {
+					v8::Local<v8::Value> localIdxValue = maybeIdxValue.ToLocalChecked();
+					if (localIdxValue->IsNumber()) {
+						unsigned int idxValue = localIdxValue->Uint32Value(Nan::GetCurrentContext()).FromJust();
+						options.layers.push_back(idxValue);
+					}
+				}
+			}
+		}
+	}
+	if (options.layers.size() < 2) {
+		Nan::ThrowError("layers option is required with at least 2 layers");
+		return false;
+	}
+
+	// Get the connectionRate option
+	Nan::MaybeLocal<v8::Value> maybeConnectionRate = Nan::Get(optionsObj, Nan::New("connectionRate").ToLocalChecked());
+	if (!maybeConnectionRate.IsEmpty()) {
+		v8::Local<v8::Value> localConnectionRate = maybeConnectionRate.ToLocalChecked();
+		if (localConnectionRate->IsNumber()) {
+			options.connectionRate = localConnectionRate->NumberValue(Nan::GetCurrentContext()).FromJust();
+		}
+	}
+
+	// Get the seed option
+	Nan::MaybeLocal<v8::Value> maybeSeed = Nan::Get(optionsObj, Nan::New("seed").ToLocalChecked());
+	if (!maybeSeed.IsEmpty()) {
+		v8::Local<v8::Value> localSeed = maybeSeed.ToLocalChecked();
+		if (localSeed->IsNumber()) {
+			double seed = localSeed->NumberValue(Nan::GetCurrentContext()).FromJust();
+			if (!(seed >= 0) || seed != floor(seed) || seed > 9007199254740992.0) {
+				Nan::ThrowError("Seed must be a non-negative integer");
+				return false;
+			}
+			options.hasSeed = true;
+			options.seed = (uint64_t)seed;
+		}
+	}
+
+	if (!options.type.empty() && options.type != "standard" && options.type != "sparse" && options.type != "shortcut") {
+		Nan::ThrowError("Invalid type option");
+		return false;
+	}
+	return true;
+}
+
+// Range of the initial weights FANN draws from rand() as it creates a network (fann_random_weight())
+static const float CREATE_WEIGHT_RANGE = 0.1f;
+
+// Constructs the neural_net underlying class.  Doesn't touch V8, so it can run on a worker thread.  With a
+// seed, rng is seeded and the initial weights are redrawn from it, over the range FANN uses.
+static FANN::neural_net *createFromOptions(const CreateOptions &options, Rng &rng) {
+	FANN::neural_net *fann;
+	if (options.type == "sparse") {
+		fann = new FANN::neural_net(options.connectionRate, options.layers.size(), &options.layers[0]);
+	} else if (options.type == "shortcut") {
+		fann = new FANN::neural_net(FANN::network_type_enum::SHORTCUT, options.layers.size(), &options.layers[0]);
+	} else {
+		fann = new FANN::neural_net(FANN::network_type_enum::LAYER, (unsigned int)options.layers.size(), (const unsigned int *)&options.layers[0]);
+	}
+	if (options.hasSeed && !fann->get_errno()) {
+		rng.seed(options.seed);
+		// As randomizeWeights() after setSeed()
+		Rng initRng = rng.fork();
+		fanny::randomizeWeights(getFannStruct(fann), (fann_type)-CREATE_WEIGHT_RANGE, (fann_type)CREATE_WEIGHT_RANGE, initRng);
+	}
+	return fann;
+}
+
+// Copies a network, along with its optimizer state so the copy continues training at the same rate
+static FANN::neural_net *copyNetwork(FANN::neural_net *other) {
+	FANN::neural_net *fann = new FANN::neural_net(*other);
+	TrainState trainState;
+	trainState.capture(getFannStruct(other));
+	std::string errorMessage;
+	trainState.apply(getFannStruct(fann), errorMessage);
+	return fann;
+}
+
+// Creates a new network on a worker thread, either from options or as a copy of another FANNY,
+// and calls back with the new FANNY instance
+class CreateWorker : public Nan::AsyncWorker {
+public:
+	CreateWorker(Nan::Callback *callback, const CreateOptions &_options) :
+		Nan::AsyncWorker(callback), options(_options), other(NULL), fann(NULL), rng(Rng::randomSeed()) {}
+	CreateWorker(Nan::Callback *callback, v8::Local<v8::Object> otherHolder) :
+		Nan::AsyncWorker(callback), fann(NULL), rng(Rng::randomSeed())
+	{
+		SaveToPersistent("otherHolder", otherHolder);
+		other = Nan::ObjectWrap::Unwrap<FANNY>(otherHolder);
+	}
+	~CreateWorker() {
+		if (fann) delete fann;
+	}
+
+	void Execute() {
+		if (other) {
+			fann = copyNetwork(other->fann);
+		} else {
+			fann = createFromOptions(options, rng);
+		}
+		if (fann->get_errno()) {
+			SetErrorMessage(fann->get_errstr().c_str());
+		}
+	}
+
+	void HandleOKCallback() {
+		Nan::HandleScope scope;
+		v8::Local<v8::Value> externFann = Nan::New<v8::External>(fann);
+		v8::Local<v8::Function> ctor = Nan::New(FANNY::constructorFunction);
+		v8::Local<v8::Value> ctorArgs[] = { externFann };
+		v8::Local<v8::Object> instance = Nan::NewInstance(ctor, 1, ctorArgs).ToLocalChecked();
+		// The new FANNY owns the network now
+		fann = NULL;
+		if (options.hasSeed) Nan::ObjectWrap::Unwrap<FANNY>(instance)->rng = rng;
+		v8::Local<v8::Value> args[] = { Nan::Null(), instance };
+		callback->Call(2, args, async_resource);
+	}
+
+	CreateOptions options;
+	FANNY *other;
+	FANN::neural_net *fann;
+	// The new network's random stream, when created with a seed
+	Rng rng;
+};
+
+// Randomizes or initializes the weights of a network on a worker thread
+class InitWeightsWorker : public Nan::AsyncWorker {
+public:
+	// Randomize weights between min and max
+	InitWeightsWorker(Nan::Callback *callback, v8::Local<v8::Object> fannyHolder, fann_type _minWeight, fann_type _maxWeight) :
+		Nan::AsyncWorker(callback), trainingData(NULL), minWeight(_minWeight), maxWeight(_maxWeight)
+	{
+		SaveToPersistent("fannyHolder", fannyHolder);
+		fanny = Nan::ObjectWrap::Unwrap<FANNY>(fannyHolder);
+		rng = fanny->rng.fork();
+	}
+	// Initialize weights from training data (Nguyen-Widrow)
+	InitWeightsWorker(Nan::Callback *callback, v8::Local<v8::Object> fannyHolder, v8::Local<v8::Object> tdHolder) :
+		Nan::AsyncWorker(callback), minWeight(0), maxWeight(0)
+	{
+		SaveToPersistent("fannyHolder", fannyHolder);
+		SaveToPersistent("tdHolder", tdHolder);
+		fanny = Nan::ObjectWrap::Unwrap<FANNY>(fannyHolder);
+		trainingData = Nan::ObjectWrap::Unwrap<TrainingData>(tdHolder);
+		rng = fanny->rng.fork();
+	}
+	~InitWeightsWorker() {}
+
+	void Execute() {
+		if (trainingData) {
+			struct fann_train_data *data = getFannTrainDataStruct(trainingData->trainingData);
+			if (!data || !data->num_data) return SetErrorMessage("Training data is empty");
+			fanny::initWeights(getFannStruct(fanny->fann), data, rng);
+		} else {
+			fanny::randomizeWeights(getFannStruct(fanny->fann), minWeight, maxWeight, rng);
+		}
+		if (fanny->fann->get_errno()) {
+			SetErrorMessage(fanny->fann->get_errstr().c_str());
+			fanny->fann->reset_errno();
+			fanny->fann->reset_errstr();
+		}
+	}
+
+	void WorkComplete() {
+		if (trainingData) trainingData->release(false);
+		Nan::AsyncWorker::WorkComplete();
+	}
+
+	FANNY *fanny;
+	TrainingData *trainingData;
+	fann_type minWeight;
+	fann_type maxWeight;
+	// Forked from the network's stream on the main thread
+	Rng rng;
+};
+
 void FANNY::Init(v8::Local<v8::Object> target) {
 	// Create new function template for this JS class constructor
 	v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(New);
@@ -233,7 +715,19 @@ void FANNY::Init(v8::Local<v8::Object> target) {
 
 	Nan::SetPrototypeMethod(tpl, "save", save);
 	Nan::SetPrototypeMethod(tpl, "saveToFixed", saveToFixed);
+	Nan::SetPrototypeMethod(tpl, "saveModelFile", saveModelFile);
 	Nan::SetPrototypeMethod(tpl, "setCallback", setCallback);
+	Nan::SetPrototypeMethod(tpl, "setCheckpoint", setCheckpoint);
+	Nan::SetPrototypeMethod(tpl, "getCheckpoints", getCheckpoints);
+	Nan::SetPrototypeMethod(tpl, "getCheckpoint", getCheckpoint);
+	Nan::SetPrototypeMethod(tpl, "getTrainState", getTrainState);
+	Nan::SetPrototypeMethod(tpl, "setTrainState", setTrainState);
+	Nan::SetPrototypeMethod(tpl, "quantize", quantize);
+	Nan::SetPrototypeMethod(tpl, "share", share);
+	Nan::SetPrototypeMethod(tpl, "swapNetwork", swapNetwork);
+	Nan::SetPrototypeMethod(tpl, "exportBuffer", exportBuffer);
+	Nan::SetPrototypeMethod(tpl, "randomizeWeightsAsync", randomizeWeightsAsync);
+	Nan::SetPrototypeMethod(tpl, "initWeightsAsync", initWeightsAsync);
 	Nan::SetPrototypeMethod(tpl, "trainEpoch", trainEpoch);
 	Nan::SetPrototypeMethod(tpl, "trainOnData", trainOnData);
 	Nan::SetPrototypeMethod(tpl, "trainOnFile", trainOnFile);
@@ -272,7 +766,15 @@ void FANNY::Init(v8::Local<v8::Object> target) {
 	Nan::SetPrototypeMethod(tpl, "getRpropDeltaMin", getRpropDeltaMin);
 	Nan::SetPrototypeMethod(tpl, "getRpropDeltaMax", getRpropDeltaMax);
 	Nan::SetPrototypeMethod(tpl, "runAsync", runAsync);
+	Nan::SetPrototypeMethod(tpl, "runBatch", runBatch);
+	Nan::SetPrototypeMethod(tpl, "runBatchAsync", runBatchAsync);
+	Nan::SetPrototypeMethod(tpl, "canRunConcurrently", canRunConcurrently);
+	Nan::SetPrototypeMethod(tpl, "runSparse", runSparse);
+	Nan::SetPrototypeMethod(tpl, "runSparseBatch", runSparseBatch);
+	Nan::SetPrototypeMethod(tpl, "runSparseBatchAsync", runSparseBatchAsync);
+	Nan::SetPrototypeMethod(tpl, "trainSparse", trainSparse);
 	Nan::SetPrototypeMethod(tpl, "initWeights", initWeights);
+	Nan::SetPrototypeMethod(tpl, "setSeed", setSeed);
 	Nan::SetPrototypeMethod(tpl, "testData", testData);
 	Nan::SetPrototypeMethod(tpl, "getLayerArray", getLayerArray);
 	Nan::SetPrototypeMethod(tpl, "getBiasArray", getBiasArray);
@@ -313,6 +815,8 @@ void FANNY::Init(v8::Local<v8::Object> target) {
 	Nan::SetPrototypeMethod(tpl, "setCascadeMaxOutEpochs", setCascadeMaxOutEpochs);
 	Nan::SetPrototypeMethod(tpl, "setCascadeMaxCandEpochs", setCascadeMaxCandEpochs);
 	Nan::SetPrototypeMethod(tpl, "setCascadeNumCandidateGroups", setCascadeNumCandidateGroups);
+	Nan::SetPrototypeMethod(tpl, "getCascadeThreads", getCascadeThreads);
+	Nan::SetPrototypeMethod(tpl, "setCascadeThreads", setCascadeThreads);
 
 	Nan::SetPrototypeMethod(tpl, "setQuickpropDecay", setQuickpropDecay);
 	Nan::SetPrototypeMethod(tpl, "setQuickpropMu", setQuickpropMu);
@@ -341,6 +845,9 @@ void FANNY::Init(v8::Local<v8::Object> target) {
 
 	Nan::SetPrototypeMethod(tpl, "setWeightArray", setWeightArray);
 	Nan::SetPrototypeMethod(tpl, "setWeight", setWeight);
+	Nan::SetPrototypeMethod(tpl, "getWeights", getWeights);
+	Nan::SetPrototypeMethod(tpl, "setWeights", setWeights);
+	Nan::SetPrototypeMethod(tpl, "getWeightsView", getWeightsView);
 
 	Nan::SetPrototypeMethod(tpl, "getUserDataString", getUserDataString);
 	Nan::SetPrototypeMethod(tpl, "setUserDataString", setUserDataString);
@@ -348,6 +855,12 @@ void FANNY::Init(v8::Local<v8::Object> target) {
 	// Create the loadFile function
 	v8::Local<v8::FunctionTemplate> loadFileTpl = Nan::New<v8::FunctionTemplate>(loadFile);
 	v8::Local<v8::Function> loadFileFunction = Nan::GetFunction(loadFileTpl).ToLocalChecked();
+	v8::Local<v8::FunctionTemplate> createAsyncTpl = Nan::New<v8::FunctionTemplate>(createAsync);
+	v8::Local<v8::Function> createAsyncFunction = Nan::GetFunction(createAsyncTpl).ToLocalChecked();
+	v8::Local<v8::FunctionTemplate> loadBufferTpl = Nan::New<v8::FunctionTemplate>(loadBuffer);
+	v8::Local<v8::Function> loadBufferFunction = Nan::GetFunction(loadBufferTpl).ToLocalChecked();
+	v8::Local<v8::FunctionTemplate> loadModelFileTpl = Nan::New<v8::FunctionTemplate>(loadModelFile);
+	v8::Local<v8::Function> loadModelFileFunction = Nan::GetFunction(loadModelFileTpl).ToLocalChecked();
 
 	v8::Local<v8::FunctionTemplate> disableSeedRandTpl = Nan::New<v8::FunctionTemplate>(disableSeedRand);
 	v8::Local<v8::Function> disableSeedRandFunction = Nan::GetFunction(disableSeedRandTpl).ToLocalChecked();
@@ -357,6 +870,9 @@ void FANNY::Init(v8::Local<v8::Object> target) {
 	// Assign a property called 'FANNY' to module.exports, pointing to our constructor
 	v8::Local<v8::Function> ctorFunction = Nan::GetFunction(tpl).ToLocalChecked();
 	Nan::Set(ctorFunction, Nan::New("loadFile").ToLocalChecked(), loadFileFunction);
+	Nan::Set(ctorFunction, Nan::New("loadBuffer").ToLocalChecked(), loadBufferFunction);
+	Nan::Set(ctorFunction, Nan::New("loadModelFile").ToLocalChecked(), loadModelFileFunction);
+	Nan::Set(ctorFunction, Nan::New("createAsync").ToLocalChecked(), createAsyncFunction);
 	Nan::Set(ctorFunction, Nan::New("disableSeedRand").ToLocalChecked(), disableSeedRandFunction);
 	Nan::Set(ctorFunction, Nan::New("enableSeedRand").ToLocalChecked(), enableSeedRandFunction);
 	FANNY::constructorFunction.Reset(ctorFunction);
@@ -364,13 +880,87 @@ void FANNY::Init(v8::Local<v8::Object> target) {
 }
 
 
-Nan::Persistent<v8::FunctionTemplate> FANNY::constructorFunctionTpl;
-Nan::Persistent<v8::Function> FANNY::constructorFunction;
+thread_local Nan::Persistent<v8::FunctionTemplate> FANNY::constructorFunctionTpl;
+thread_local Nan::Persistent<v8::Function> FANNY::constructorFunction;
 
-FANNY::FANNY(FANN::neural_net *_fann) : fann(_fann), currentTrainWorker(NULL) {}
+FANNY::FANNY(FANN::neural_net *_fann) : fann(_fann), currentTrainWorker(NULL), checkpointer(NULL), cascadeThreads(0), sparsePlan(NULL), csrNet(NULL), shortcutNet(NULL), concurrentNet(NULL), mappedModel(NULL), rng(Rng::randomSeed()), weightsViewData(NULL), weightsViewLength(0) {}
 
 FANNY::~FANNY() {
+	// The view holds a reference to this object, so it can only be unreachable too; drop the weak handle
+	// so its callback doesn't run against a deleted FANNY
+	weightsView.Reset();
+	if (checkpointer) delete checkpointer;
+	if (sparsePlan) delete sparsePlan;
+	if (csrNet) delete csrNet;
+	if (shortcutNet) delete shortcutNet;
+	if (concurrentNet) delete concurrentNet;
+	// FANN would free weights that are still in the mapping
+	if (mappedModel && mappedModel->contains(getFannStruct(fann)->weights)) getFannStruct(fann)->weights = NULL;
 	delete fann;
+	if (mappedModel) delete mappedModel;
+}
+
+bool FANNY::unmapWeights() {
+	if (!mappedModel) return true;
+	struct fann *ann = getFannStruct(fann);
+	if (mappedModel->contains(ann->weights)) {
+		fann_type *weights = (fann_type *)malloc((size_t)ann->total_connections_allocated * sizeof(fann_type));
+		if (!weights) return false;
+		std::copy(ann->weights, ann->weights + ann->total_connections, weights);
+		detachWeightsView();
+		ann->weights = weights;
+	}
+	delete mappedModel;
+	mappedModel = NULL;
+	return true;
+}
+
+SparseNetPlan *FANNY::getSparsePlan() {
+	struct fann *ann = getFannStruct(fann);
+	if (sparsePlan && !sparsePlan->isCurrent(ann)) {
+		delete sparsePlan;
+		sparsePlan = NULL;
+	}
+	if (!sparsePlan) sparsePlan = new SparseNetPlan(ann);
+	return sparsePlan;
+}
+
+CsrNet *FANNY::getCsrNet() {
+	struct fann *ann = getFannStruct(fann);
+	if (csrNet && !csrNet->isCurrent(ann)) {
+		delete csrNet;
+		csrNet = NULL;
+	}
+	if (!csrNet && CsrNet::handles(ann)) csrNet = new CsrNet(ann);
+	return csrNet;
+}
+
+ForwardEngine *FANNY::getRunEngine() {
+	CsrNet *csr = getCsrNet();
+	if (csr) return csr;
+	struct fann *ann = getFannStruct(fann);
+	if (shortcutNet && !shortcutNet->isCurrent(ann)) {
+		delete shortcutNet;
+		shortcutNet = NULL;
+	}
+	if (!shortcutNet && ShortcutNet::handles(ann)) shortcutNet = new ShortcutNet(ann);
+	return (shortcutNet && shortcutNet->valid) ? shortcutNet : NULL;
+}
+
+ForwardEngine *FANNY::getConcurrentEngine() {
+	ForwardEngine *engine = getRunEngine();
+	if (engine) return engine;
+	#ifndef FANNY_FIXED
+	struct fann *ann = getFannStruct(fann);
+	if (concurrentNet && !concurrentNet->isCurrent(ann)) {
+		delete concurrentNet;
+		concurrentNet = NULL;
+	}
+	if (!concurrentNet && ann->network_type == FANN_NETTYPE_LAYER) concurrentNet = new CsrNet(ann);
+	return concurrentNet;
+	#else
+	return NULL;
+	#endif
 }
 
 NAN_METHOD(FANNY::printConnections) {
@@ -393,14 +983,82 @@ NAN_METHOD(FANNY::randomizeWeights) {
 	fann_type min_weight = v8NumberToFannType(info[0]);
 	fann_type max_weight = v8NumberToFannType(info[1]);
 
-	fanny->fann->randomize_weights(min_weight, max_weight);
+	// Each initialization takes its own stream, so the sync and async versions give the same weights
+	Rng rng = fanny->rng.fork();
+	fanny::randomizeWeights(getFannStruct(fanny->fann), min_weight, max_weight, rng);
+}
+
+NAN_METHOD(FANNY::randomizeWeightsAsync) {
+	if (info.Length() != 3) return Nan::ThrowError("Must have 3 arguments: min_weight, max_weight and callback");
+	if (!info[0]->IsNumber() || !info[1]->IsNumber()) {
+		return Nan::ThrowError("min_weight and max_weight must be numbers");
+	}
+	if (!info[2]->IsFunction()) return Nan::ThrowTypeError("Last argument must be callback");
+	fann_type min_weight = v8NumberToFannType(info[0]);
+	fann_type max_weight = v8NumberToFannType(info[1]);
+	Nan::Callback *callback = new Nan::Callback(info[2].As<v8::Function>());
+	Nan::AsyncQueueWorker(new InitWeightsWorker(callback, info.Holder(), min_weight, max_weight));
+}
+
+NAN_METHOD(FANNY::initWeightsAsync) {
+	if (info.Length() != 2) return Nan::ThrowError("Takes training data and a callback");
+	if (!Nan::New(TrainingData::constructorFunctionTpl)->HasInstance(info[0])) {
+		return Nan::ThrowError("Argument must be an instance of TrainingData");
+	}
+	if (!info[1]->IsFunction()) return Nan::ThrowTypeError("Last argument must be callback");
+	if (!Nan::ObjectWrap::Unwrap<TrainingData>(info[0].As<v8::Object>())->hold(false)) return;
+	Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
+	Nan::AsyncQueueWorker(new InitWeightsWorker(callback, info.Holder(), info[0].As<v8::Object>()));
 }
 
 NAN_METHOD(FANNY::loadFile) {
+	if (info.Length() != 2 && info.Length() != 3) return Nan::ThrowError("Requires filename and callback");
+	std::string filename = *Nan::Utf8String(info[0]->ToString(Nan::GetCurrentContext()).FromMaybe(v8::Local<v8::String>()));
+	// Optional second argument: also load the training state sidecar file
+	bool loadTrainState = info.Length() == 3 && Nan::To<bool>(info[1]).FromJust();
+	if (!info[info.Length() - 1]->IsFunction()) return Nan::ThrowTypeError("Last argument must be callback");
+	Nan::Callback * callback = new Nan::Callback(info[info.Length() - 1].As<v8::Function>());
+	Nan::AsyncQueueWorker(new LoadFileWorker(callback, filename, loadTrainState));
+}
+
+NAN_METHOD(FANNY::loadModelFile) {
 	if (info.Length() != 2) return Nan::ThrowError("Requires filename and callback");
+	if (!info[0]->IsString() || !info[1]->IsFunction()) return Nan::ThrowTypeError("Wrong argument type");
 	std::string filename = *Nan::Utf8String(info[0]->ToString(Nan::GetCurrentContext()).FromMaybe(v8::Local<v8::String>()));
-	Nan::Callback * callback = new Nan::Callback(info[1].As<v8::Function>());
-	Nan::AsyncQueueWorker(new LoadFileWorker(callback, filename));
+	Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
+	Nan::AsyncQueueWorker(new LoadFileWorker(callback, filename, false, true));
+}
+
+NAN_METHOD(FANNY::createAsync) {
+	if (info.Length() != 2) return Nan::ThrowError("Requires options and callback");
+	if (!info[1]->IsFunction()) return Nan::ThrowTypeError("Last argument must be callback");
+	CreateWorker *worker;
+	if (Nan::New(FANNY::constructorFunctionTpl)->HasInstance(info[0])) {
+		worker = new CreateWorker(new Nan::Callback(info[1].As<v8::Function>()), info[0].As<v8::Object>());
+	} else if (info[0]->IsObject()) {
+		CreateOptions options;
+		if (!parseCreateOptions(info[0].As<v8::Object>(), options)) return;
+		worker = new CreateWorker(new Nan::Callback(info[1].As<v8::Function>()), options);
+	} else {
+		return Nan::ThrowTypeError("Invalid argument type");
+	}
+	Nan::AsyncQueueWorker(worker);
+}
+
+NAN_METHOD(FANNY::loadBuffer) {
+	if (info.Length() != 2) return Nan::ThrowError("Requires buffer and callback");
+	if (!node::Buffer::HasInstance(info[0]) || !info[1]->IsFunction()) return Nan::ThrowTypeError("Wrong argument type");
+	if (!node::Buffer::Length(info[0])) return Nan::ThrowError("Buffer is empty");
+	Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
+	Nan::AsyncQueueWorker(new LoadFileWorker(callback, info[0].As<v8::Object>()));
+}
+
+NAN_METHOD(FANNY::exportBuffer) {
+	if (info.Length() != 2) return Nan::ThrowError("Takes a boolean and a callback");
+	if (!info[1]->IsFunction()) return Nan::ThrowTypeError("Last argument must be callback");
+	bool asFixed = Nan::To<bool>(info[0]).FromJust();
+	Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
+	Nan::AsyncQueueWorker(new ExportBufferWorker(callback, info.Holder(), asFixed));
 }
 
 NAN_METHOD(FANNY::New) {
@@ -410,11 +1068,13 @@ NAN_METHOD(FANNY::New) {
 	}
 
 	FANN::neural_net *fann;
+	CreateOptions options;
+	Rng rng;
 
 	if (Nan::New(FANNY::constructorFunctionTpl)->HasInstance(info[0])) {
 		// Copy constructor
 		FANNY *other = Nan::ObjectWrap::Unwrap<FANNY>(info[0].As<v8::Object>());
-		fann = new FANN::neural_net(*other->fann);
+		fann = copyNetwork(other->fann);
 	} else if (info[0]->IsString()) {
 		// Load-from-file constructor
 		fann = new FANN::neural_net(std::string(*Nan::Utf8String(info[0]->ToString(Nan::GetCurrentContext()).FromMaybe(v8::Local<v8::String>()))));
@@ -423,71 +1083,14 @@ NAN_METHOD(FANNY::New) {
 		fann = (FANN::neural_net *)info[0].As<v8::External>()->Value();
 	} else if (info[0]->IsObject()) {
 		// Options constructor
-
-		// Get the options argument
-		v8::Local<v8::Object> optionsObj(info[0].As<v8::Object>());
-
-		// Variables for individual options
-		std::string optType;
-		std::vector<unsigned int> optLayers;
-		float optConnectionRate = 0.5;
-
-		// Get the type option
-		Nan::MaybeLocal<v8::Value> maybeType = Nan::Get(optionsObj, Nan::New("type").ToLocalChecked());
-		if (!maybeType.IsEmpty()) {
-			v8::Local<v8::Value> localType = maybeType.ToLocalChecked();
-			if (localType->IsString()) {
-				optType = std::string(*(Nan::Utf8String(localType->ToString(Nan::GetCurrentContext()).FromMaybe(v8::Local<v8::String>()))));
-			}
-		}
-
-		// Get the layers option
-		Nan::MaybeLocal<v8::Value> maybeLayers = Nan::Get(optionsObj, Nan::New("layers").ToLocalChecked());
-		if (!maybeLayers.IsEmpty()) {
-			v8::Local<v8::Value> localLayers = maybeLayers.ToLocalChecked();
-			if (localLayers->IsArray()) {
-				v8::Local<v8::Array> arrayLayers = localLayers.As<v8::Array>();
-				uint32_t length = arrayLayers->Length();
-				for (uint32_t idx = 0; idx < length; ++idx) {
-					Nan::MaybeLocal<v8::Value> maybeIdxValue = Nan::Get(arrayLayers, idx);
-					if (!maybeIdxValue.IsEmpty()) {
-						v8::Local<v8::Value> localIdxValue = maybeIdxValue.ToLocalChecked();
-						if (localIdxValue->IsNumber()) {
-							unsigned int idxValue = localIdxValue->Uint32Value(Nan::GetCurrentContext()).FromJust();
-							optLayers.push_back(idxValue);
-						}
-					}
-				}
-			}
-		}
-		if (optLayers.size() < 2) {
-			return Nan::ThrowError("layers option is required with at least 2 layers");
-		}
-
-		// Get the connectionRate option
-		Nan::MaybeLocal<v8::Value> maybeConnectionRate = Nan::Get(optionsObj, Nan::New("connectionRate").ToLocalChecked());
-		if (!maybeConnectionRate.IsEmpty()) {
-			v8::Local<v8::Value> localConnectionRate = maybeConnectionRate.ToLocalChecked();
-			if (localConnectionRate->IsNumber()) {
-				optConnectionRate = localConnectionRate->NumberValue(Nan::GetCurrentContext()).FromJust();
-			}
-		}
-
-		// Construct the neural_net underlying class
-		if (!optType.compare("standard") || optType.empty()) {
-			fann = new FANN::neural_net(FANN::network_type_enum::LAYER, (unsigned int)optLayers.size(), (const unsigned int *)&optLayers[0]);
-		} else if(optType.compare("sparse")) {
-			fann = new FANN::neural_net(optConnectionRate, optLayers.size(), &optLayers[0]);
-		} else if (optType.compare("shortcut")) {
-			fann = new FANN::neural_net(FANN::network_type_enum::SHORTCUT, optLayers.size(), &optLayers[0]);
-		} else {
-			return Nan::ThrowError("Invalid type option");
-		}
+		if (!parseCreateOptions(info[0].As<v8::Object>(), options)) return;
+		fann = createFromOptions(options, rng);
 	} else {
 		return Nan::ThrowTypeError("Invalid argument type");
 	}
 
 	FANNY *obj = new FANNY(fann);
+	if (options.hasSeed) obj->rng = rng;
 	obj->Wrap(info.This());
 	info.GetReturnValue().Set(info.This());
 }
@@ -507,11 +1110,21 @@ bool FANNY::checkError() {
 }
 
 NAN_METHOD(FANNY::save) {
+	// Optional middle argument: also save the training state to a sidecar file
+	if (info.Length() != 2 && info.Length() != 3) return Nan::ThrowError("Takes a filename and a callback");
+	if (!info[0]->IsString() || !info[info.Length() - 1]->IsFunction()) return Nan::ThrowTypeError("Wrong argument type");
+	std::string filename(*Nan::Utf8String(info[0]->ToString(Nan::GetCurrentContext()).FromMaybe(v8::Local<v8::String>())));
+	bool saveTrainState = info.Length() == 3 && Nan::To<bool>(info[1]).FromJust();
+	Nan::Callback *callback = new Nan::Callback(info[info.Length() - 1].As<v8::Function>());
+	Nan::AsyncQueueWorker(new SaveFileWorker(callback, info.Holder(), filename, false, saveTrainState));
+}
+
+NAN_METHOD(FANNY::saveModelFile) {
 	if (info.Length() != 2) return Nan::ThrowError("Takes a filename and a callback");
 	if (!info[0]->IsString() || !info[1]->IsFunction()) return Nan::ThrowTypeError("Wrong argument type");
 	std::string filename(*Nan::Utf8String(info[0]->ToString(Nan::GetCurrentContext()).FromMaybe(v8::Local<v8::String>())));
 	Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
-	Nan::AsyncQueueWorker(new SaveFileWorker(callback, info.Holder(), filename, false));
+	Nan::AsyncQueueWorker(new SaveFileWorker(callback, info.Holder(), filename, false, false, true));
 }
 
 NAN_METHOD(FANNY::saveToFixed) {
@@ -519,7 +1132,7 @@ NAN_METHOD(FANNY::saveToFixed) {
 	if (!info[0]->IsString() || !info[1]->IsFunction()) return Nan::ThrowTypeError("Wrong argument type");
 	std::string filename(*Nan::Utf8String(info[0]->ToString(Nan::GetCurrentContext()).FromMaybe(v8::Local<v8::String>())));
 	Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
-	Nan::AsyncQueueWorker(new SaveFileWorker(callback, info.Holder(), filename, true));
+	Nan::AsyncQueueWorker(new SaveFileWorker(callback, info.Holder(), filename, true, false));
 }
 
 int FANNY::fannInternalCallback(
@@ -536,6 +1149,9 @@ int FANNY::fannInternalCallback(
 	fanny->currentTrainingProgress.mse = fanny->fann->get_MSE();
 	fanny->currentTrainingProgress.bitFail = fanny->fann->get_bit_fail();
 	fanny->currentTrainingProgress.neurons = fanny->fann->get_total_neurons();
+	if (fanny->checkpointer) {
+		fanny->checkpointer->update(getFannStruct(fanny->fann), epochs, fanny->currentTrainingProgress.mse);
+	}
 	if (fanny->currentTrainWorker && fanny->currentTrainWorker->executionProgress) {
 		fanny->currentTrainWorker->executionProgress->Signal();
 	}
@@ -546,21 +1162,166 @@ int FANNY::fannInternalCallback(
 	}
 }
 
+void FANNY::registerTrainingCallback() {
+	#ifndef FANNY_FIXED
+	if (trainingCallbackFn.IsEmpty()) {
+		fann->set_callback(NULL, NULL);
+	} else {
+		fann->set_callback(fannInternalCallback, this);
+	}
+	#endif
+}
+
 NAN_METHOD(FANNY::setCallback) {
 	#ifndef FANNY_FIXED
 	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
 	if (info.Length() == 0 || !info[0]->IsFunction()) {
 		fanny->trainingCallbackFn.Reset();
-		fanny->fann->set_callback(NULL, NULL);
 	} else {
 		fanny->trainingCallbackFn.Reset(info[0].As<v8::Function>());
-		fanny->fann->set_callback(fannInternalCallback, fanny);
 	}
+	fanny->registerTrainingCallback();
+	#else
+	Nan::ThrowError("Not supported for fixed FANN");
+	#endif
+}
+
+NAN_METHOD(FANNY::setCheckpoint) {
+	#ifndef FANNY_FIXED
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	if (info.Length() == 0 || !info[0]->IsObject()) {
+		if (fanny->checkpointer) fanny->checkpointer->disable();
+		return;
+	}
+	v8::Local<v8::Object> optionsObj = info[0].As<v8::Object>();
+	unsigned int everyEpochs = 0;
+	double everySeconds = 0;
+	std::string filename;
+	unsigned int ringSize = 1;
+	v8::Local<v8::Value> localEpochs = Nan::Get(optionsObj, Nan::New("epochs").ToLocalChecked()).ToLocalChecked();
+	if (localEpochs->IsNumber()) everyEpochs = localEpochs->Uint32Value(Nan::GetCurrentContext()).FromJust();
+	v8::Local<v8::Value> localSeconds = Nan::Get(optionsObj, Nan::New("seconds").ToLocalChecked()).ToLocalChecked();
+	if (localSeconds->IsNumber()) everySeconds = localSeconds->NumberValue(Nan::GetCurrentContext()).FromJust();
+	v8::Local<v8::Value> localFilename = Nan::Get(optionsObj, Nan::New("filename").ToLocalChecked()).ToLocalChecked();
+	if (localFilename->IsString()) filename = std::string(*Nan::Utf8String(localFilename));
+	v8::Local<v8::Value> localRingSize = Nan::Get(optionsObj, Nan::New("ringSize").ToLocalChecked()).ToLocalChecked();
+	if (localRingSize->IsNumber()) ringSize = localRingSize->Uint32Value(Nan::GetCurrentContext()).FromJust();
+	if (!everyEpochs && everySeconds <= 0) return Nan::ThrowError("Checkpoint requires an interval in epochs or seconds");
+	if (fanny->checkpointer) delete fanny->checkpointer;
+	fanny->checkpointer = new Checkpointer(everyEpochs, everySeconds, filename, ringSize);
+	#else
+	Nan::ThrowError("Not supported for fixed FANN");
+	#endif
+}
+
+NAN_METHOD(FANNY::getCheckpoints) {
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	v8::Local<v8::Array> array = Nan::New<v8::Array>();
+	if (fanny->checkpointer) {
+		size_t numCheckpoints = fanny->checkpointer->getNumCheckpoints();
+		for (size_t idx = 0; idx < numCheckpoints; ++idx) {
+			unsigned int epochs;
+			float mse;
+			if (!fanny->checkpointer->getCheckpointInfo(idx, epochs, mse)) break;
+			v8::Local<v8::Object> obj = Nan::New<v8::Object>();
+			Nan::Set(obj, Nan::New("epochs").ToLocalChecked(), Nan::New(epochs));
+			Nan::Set(obj, Nan::New("mse").ToLocalChecked(), Nan::New(mse));
+			Nan::Set(array, (uint32_t)idx, obj);
+		}
+	}
+	info.GetReturnValue().Set(array);
+}
+
+NAN_METHOD(FANNY::getCheckpoint) {
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	if (info.Length() != 1 || !info[0]->IsNumber()) return Nan::ThrowTypeError("Takes checkpoint index");
+	size_t idx = info[0]->Uint32Value(Nan::GetCurrentContext()).FromJust();
+	if (!fanny->checkpointer) return Nan::ThrowError("No such checkpoint");
+	std::string errorMessage;
+	FANN::neural_net *fann = fanny->checkpointer->restoreCheckpoint(idx, errorMessage);
+	if (!fann) return Nan::ThrowError(errorMessage.c_str());
+	v8::Local<v8::Value> externFann = Nan::New<v8::External>(fann);
+	v8::Local<v8::Function> ctor = Nan::New(FANNY::constructorFunction);
+	v8::Local<v8::Value> ctorArgs[] = { externFann };
+	info.GetReturnValue().Set(Nan::NewInstance(ctor, 1, ctorArgs).ToLocalChecked());
+}
+
+NAN_METHOD(FANNY::getTrainState) {
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	TrainState trainState;
+	trainState.capture(getFannStruct(fanny->fann));
+	std::vector<char> buffer;
+	trainState.serialize(buffer);
+	info.GetReturnValue().Set(Nan::CopyBuffer(&buffer[0], (uint32_t)buffer.size()).ToLocalChecked());
+}
+
+NAN_METHOD(FANNY::setTrainState) {
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	if (info.Length() != 1 || !node::Buffer::HasInstance(info[0])) return Nan::ThrowTypeError("Takes a Buffer");
+	TrainState trainState;
+	std::string errorMessage;
+	if (!trainState.deserialize(node::Buffer::Data(info[0]), node::Buffer::Length(info[0]), errorMessage)) {
+		return Nan::ThrowError(errorMessage.c_str());
+	}
+	if (!trainState.apply(getFannStruct(fanny->fann), errorMessage)) {
+		return Nan::ThrowError(errorMessage.c_str());
+	}
+}
+
+NAN_METHOD(FANNY::quantize) {
+	#ifndef FANNY_FIXED
+	if (info.Length() != 3) return Nan::ThrowError("Takes training data, bits, and a callback");
+	if (!Nan::New(TrainingData::constructorFunctionTpl)->HasInstance(info[0])) return Nan::ThrowTypeError("First argument must be TrainingData");
+	if (!info[1]->IsNumber()) return Nan::ThrowTypeError("Bits must be a number");
+	if (!info[2]->IsFunction()) return Nan::ThrowTypeError("Last argument must be callback");
+	unsigned int bits = info[1]->Uint32Value(Nan::GetCurrentContext()).FromJust();
+	if (bits != 8 && bits != 16) return Nan::ThrowError("Bits must be 8 or 16");
+	Nan::Callback *callback = new Nan::Callback(info[2].As<v8::Function>());
+	Nan::AsyncQueueWorker(new QuantizeWorker(callback, info.Holder(), info[0].As<v8::Object>(), bits));
 	#else
 	Nan::ThrowError("Not supported for fixed FANN");
 	#endif
 }
 
+NAN_METHOD(FANNY::share) {
+	#ifndef FANNY_FIXED
+	#if V8_MAJOR_VERSION >= 8
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	struct fann *ann = getFannStruct(fanny->fann);
+	if (!SharedNet::canShare(ann)) return Nan::ThrowError("Network type cannot be shared");
+	struct fann *copy = fann_copy(ann);
+	if (!copy) return Nan::ThrowError("Could not copy network");
+	info.GetReturnValue().Set((new SharedNet(copy))->toSharedArrayBuffer());
+	#else
+	Nan::ThrowError("Shared networks require a newer version of Node");
+	#endif
+	#else
+	Nan::ThrowError("Not supported for fixed FANN");
+	#endif
+}
+
+NAN_METHOD(FANNY::swapNetwork) {
+	if (info.Length() != 1 || !Nan::New(FANNY::constructorFunctionTpl)->HasInstance(info[0])) {
+		return Nan::ThrowTypeError("Argument must be a FANNY");
+	}
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	FANNY *other = Nan::ObjectWrap::Unwrap<FANNY>(info[0].As<v8::Object>());
+	if (fanny == other) return;
+	if (fanny->currentTrainWorker || other->currentTrainWorker) return Nan::ThrowError("Cannot swap a network while training");
+	// Views over the weights would otherwise follow the network to the other object
+	fanny->detachWeightsView();
+	other->detachWeightsView();
+	std::swap(fanny->fann, other->fann);
+	std::swap(fanny->sparsePlan, other->sparsePlan);
+	std::swap(fanny->csrNet, other->csrNet);
+	std::swap(fanny->shortcutNet, other->shortcutNet);
+	std::swap(fanny->concurrentNet, other->concurrentNet);
+	std::swap(fanny->mappedModel, other->mappedModel);
+	// The callback's user data went with each network; point it at the object that now owns the network
+	fanny->registerTrainingCallback();
+	other->registerTrainingCallback();
+}
+
 void FANNY::_doTrainOrTest(
 	const Nan::FunctionCallbackInfo<v8::Value> &info,
 	bool fromFile,
@@ -583,6 +1344,8 @@ void FANNY::_doTrainOrTest(
 		v8::Local<v8::Object> trainingDataHolder = info[0].As<v8::Object>();
 		maybeTrainingData = Nan::MaybeLocal<v8::Object>(trainingDataHolder);
 	}
+	TrainingData *trainingData = maybeTrainingData.IsEmpty() ? NULL :
+		Nan::ObjectWrap::Unwrap<TrainingData>(maybeTrainingData.ToLocalChecked());
 	unsigned int maxIterations = 0;
 	unsigned int iterationsBetweenReports = 0;
 	float desiredError = 0;
@@ -596,6 +1359,19 @@ void FANNY::_doTrainOrTest(
 	}
 	if (!info[numArgs - 1]->IsFunction()) return Nan::ThrowTypeError("Last argument must be callback");
 	Nan::Callback *callback = new Nan::Callback(info[numArgs - 1].As<v8::Function>());
+	if (isCascade) {
+		// Cascade training reallocates the weights as it adds neurons
+		FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+		fanny->detachWeightsView();
+		if (!fanny->unmapWeights()) {
+			delete callback;
+			return Nan::ThrowError("Could not allocate weights");
+		}
+	}
+	if (trainingData && !trainingData->hold(false)) {
+		delete callback;
+		return;
+	}
 	Nan::AsyncQueueWorker(new TrainWorker(
 		callback,
 		info.Holder(),
@@ -638,27 +1414,164 @@ NAN_METHOD(FANNY::testData) {
 	_doTrainOrTest(info, false, false, true, true);
 }
 
+// Reads the optional concurrency flag of run and runBatch, and picks the engine to run with.  Throws a JS
+// error and returns false if a concurrent run was asked for and the network has no engine for one.
+static bool v8ToRunEngine(FANNY *fanny, v8::Local<v8::Value> value, ForwardEngine *&engine) {
+	if (!value->IsTrue()) {
+		engine = fanny->getRunEngine();
+		return true;
+	}
+	engine = fanny->getConcurrentEngine();
+	if (!engine) {
+		Nan::ThrowError("Network cannot be run while another run is in progress");
+		return false;
+	}
+	return true;
+}
+
 NAN_METHOD(FANNY::run) {
 	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
-	if (info.Length() != 1) return Nan::ThrowError("Takes one argument");
+	if (info.Length() < 1 || info.Length() > 3) return Nan::ThrowError("Takes one to three arguments");
 	if (!info[0]->IsArray()) return Nan::ThrowError("Must be array");
+	bool scale = false;
+	if (info.Length() > 1 && !v8ToRunScale(info[1], scale)) return;
+	ForwardEngine *engine;
+	if (!v8ToRunEngine(fanny, info[2], engine)) return;
 	std::vector<fann_type> inputs = v8ArrayToFannData(info[0]);
 	if (inputs.size() != fanny->fann->get_num_input()) return Nan::ThrowError("Wrong number of inputs");
-	fann_type *outputs = fanny->fann->run(&inputs[0]);
-	if (fanny->checkError()) return;
-	v8::Local<v8::Value> outputArray = fannDataToV8Array(outputs, fanny->fann->get_num_output());
-	info.GetReturnValue().Set(outputArray);
+	std::vector<fann_type> outputs(fanny->fann->get_num_output());
+	if (!runEngineRows(getFannStruct(fanny->fann), engine, &inputs[0], 1, scale, &outputs[0])) return Nan::ThrowError("Network has no scaling parameters");
+	info.GetReturnValue().Set(runOutputsToV8(outputs, 1, outputs.size(), RUN_RESULT_ARRAY));
 }
 
 NAN_METHOD(FANNY::runAsync) {
 	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
-	if (info.Length() != 2) return Nan::ThrowError("Takes two arguments");
+	if (info.Length() < 2 || info.Length() > 3) return Nan::ThrowError("Takes two or three arguments");
 	if (!info[0]->IsArray()) return Nan::ThrowError("First argument must be array");
-	if (!info[1]->IsFunction()) return Nan::ThrowError("Second argument must be callback");
+	if (!info[info.Length() - 1]->IsFunction()) return Nan::ThrowError("Last argument must be callback");
+	bool scale = false;
+	if (info.Length() > 2 && !v8ToRunScale(info[1], scale)) return;
 	std::vector<fann_type> inputs = v8ArrayToFannData(info[0]);
 	if (inputs.size() != fanny->fann->get_num_input()) return Nan::ThrowError("Wrong number of inputs");
-	Nan::Callback * callback = new Nan::Callback(info[1].As<v8::Function>());
-	Nan::AsyncQueueWorker(new RunWorker(callback, inputs, info.Holder()));
+	Nan::Callback * callback = new Nan::Callback(info[info.Length() - 1].As<v8::Function>());
+	Nan::AsyncQueueWorker(new RunWorker(callback, inputs, 1, scale, RUN_RESULT_ARRAY, info.Holder()));
+}
+
+NAN_METHOD(FANNY::runBatch) {
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	if (info.Length() < 1 || info.Length() > 3) return Nan::ThrowError("Takes one to three arguments");
+	bool scale = false;
+	if (info.Length() > 1 && !v8ToRunScale(info[1], scale)) return;
+	ForwardEngine *engine;
+	if (!v8ToRunEngine(fanny, info[2], engine)) return;
+	std::vector<fann_type> inputs;
+	unsigned int numRows;
+	RunResultFormat format;
+	if (!v8ToInputRows(info[0], fanny->fann->get_num_input(), inputs, numRows, format)) return;
+	unsigned int numOutput = fanny->fann->get_num_output();
+	std::vector<fann_type> outputs((size_t)numRows * numOutput);
+	if (!runEngineRows(getFannStruct(fanny->fann), engine, &inputs[0], numRows, scale, &outputs[0])) return Nan::ThrowError("Network has no scaling parameters");
+	info.GetReturnValue().Set(runOutputsToV8(outputs, numRows, numOutput, format));
+}
+
+NAN_METHOD(FANNY::canRunConcurrently) {
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	info.GetReturnValue().Set(fanny->getConcurrentEngine() != NULL);
+}
+
+NAN_METHOD(FANNY::runBatchAsync) {
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	if (info.Length() < 2 || info.Length() > 3) return Nan::ThrowError("Takes two or three arguments");
+	if (!info[info.Length() - 1]->IsFunction()) return Nan::ThrowError("Last argument must be callback");
+	bool scale = false;
+	if (info.Length() > 2 && !v8ToRunScale(info[1], scale)) return;
+	std::vector<fann_type> inputs;
+	unsigned int numRows;
+	RunResultFormat format;
+	if (!v8ToInputRows(info[0], fanny->fann->get_num_input(), inputs, numRows, format)) return;
+	Nan::Callback * callback = new Nan::Callback(info[info.Length() - 1].As<v8::Function>());
+	Nan::AsyncQueueWorker(new RunWorker(callback, inputs, numRows, scale, format, info.Holder()));
+}
+
+NAN_METHOD(FANNY::runSparse) {
+	#ifndef FANNY_FIXED
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	if (info.Length() != 2) return Nan::ThrowError("Takes indices and values");
+	unsigned int numInput = fanny->fann->get_num_input();
+	SparseRows rows;
+	v8::Local<v8::Array> rowOffsets = Nan::New<v8::Array>(2);
+	Nan::Set(rowOffsets, 0, Nan::New<v8::Number>(0));
+	uint32_t numEntries = info[0]->IsTypedArray() ? (uint32_t)info[0].As<v8::TypedArray>()->Length() :
+		info[0]->IsArray() ? info[0].As<v8::Array>()->Length() : 0;
+	Nan::Set(rowOffsets, 1, Nan::New<v8::Number>(numEntries));
+	if (!rows.fromV8(rowOffsets, info[0], info[1], numInput)) return;
+	SparseNetPlan *plan = fanny->getSparsePlan();
+	std::vector<fann_type> neuronValues(plan->totalNeurons), neuronSums(plan->totalNeurons);
+	plan->forward(rows.indices.data(), rows.values.data(), numEntries, &neuronValues[0], &neuronSums[0]);
+	info.GetReturnValue().Set(fannDataToV8Array(&neuronValues[plan->firstOutputNeuron], plan->numOutput));
+	#else
+	Nan::ThrowError("Not supported for fixed FANN");
+	#endif
+}
+
+NAN_METHOD(FANNY::runSparseBatch) {
+	#ifndef FANNY_FIXED
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	if (info.Length() != 3) return Nan::ThrowError("Takes rowOffsets, indices and values");
+	SparseRows rows;
+	if (!rows.fromV8(info[0], info[1], info[2], fanny->fann->get_num_input())) return;
+	SparseNetPlan *plan = fanny->getSparsePlan();
+	std::vector<fann_type> neuronValues(plan->totalNeurons), neuronSums(plan->totalNeurons);
+	std::vector<fann_type> outputs((size_t)rows.numRows() * plan->numOutput);
+	for (unsigned int row = 0; row < rows.numRows(); ++row) {
+		unsigned int entryBegin = rows.rowOffsets[row];
+		plan->forward(rows.indices.data() + entryBegin, rows.values.data() + entryBegin, rows.rowOffsets[row + 1] - entryBegin, &neuronValues[0], &neuronSums[0]);
+		std::copy(&neuronValues[plan->firstOutputNeuron], &neuronValues[plan->firstOutputNeuron] + plan->numOutput, &outputs[(size_t)row * plan->numOutput]);
+	}
+	info.GetReturnValue().Set(fannDataToTypedArray(&outputs[0], outputs.size()));
+	#else
+	Nan::ThrowError("Not supported for fixed FANN");
+	#endif
+}
+
+NAN_METHOD(FANNY::runSparseBatchAsync) {
+	#ifndef FANNY_FIXED
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	if (info.Length() != 4) return Nan::ThrowError("Takes rowOffsets, indices, values and a callback");
+	if (!info[3]->IsFunction()) return Nan::ThrowError("Last argument must be callback");
+	SparseRows rows;
+	if (!rows.fromV8(info[0], info[1], info[2], fanny->fann->get_num_input())) return;
+	Nan::Callback *callback = new Nan::Callback(info[3].As<v8::Function>());
+	Nan::AsyncQueueWorker(new SparseRunWorker(callback, info.Holder(), rows));
+	#else
+	Nan::ThrowError("Not supported for fixed FANN");
+	#endif
+}
+
+NAN_METHOD(FANNY::trainSparse) {
+	#ifndef FANNY_FIXED
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	if (info.Length() != 4) return Nan::ThrowError("Takes data, maxEpochs, desiredError and a callback");
+	if (!info[0]->IsObject() || !Nan::New(SparseTrainingData::constructorFunctionTpl)->HasInstance(info[0])) {
+		return Nan::ThrowTypeError("First argument must be SparseTrainingData");
+	}
+	if (!info[1]->IsNumber() || !info[2]->IsNumber()) return Nan::ThrowTypeError("maxEpochs and desiredError must be numbers");
+	if (!info[3]->IsFunction()) return Nan::ThrowError("Last argument must be callback");
+	SparseTrainingData *data = Nan::ObjectWrap::Unwrap<SparseTrainingData>(info[0].As<v8::Object>());
+	if (data->inputs.numInput != fanny->fann->get_num_input() || data->outputSize != fanny->fann->get_num_output()) {
+		return Nan::ThrowError("Training data does not match the network's inputs and outputs");
+	}
+	Nan::Callback *callback = new Nan::Callback(info[3].As<v8::Function>());
+	Nan::AsyncQueueWorker(new SparseTrainWorker(
+		callback,
+		info.Holder(),
+		info[0].As<v8::Object>(),
+		Nan::To<uint32_t>(info[1]).FromJust(),
+		(float)Nan::To<double>(info[2]).FromJust()
+	));
+	#else
+	Nan::ThrowError("Not supported for fixed FANN");
+	#endif
 }
 
 NAN_METHOD(FANNY::getTrainingAlgorithm) {
@@ -1066,7 +1979,10 @@ NAN_METHOD(FANNY::initWeights) {
 	}
 	TrainingData *fannyTrainingData = Nan::ObjectWrap::Unwrap<TrainingData>(info[0].As<v8::Object>());
 	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
-	return fanny->fann->init_weights(*fannyTrainingData->trainingData);
+	struct fann_train_data *data = getFannTrainDataStruct(fannyTrainingData->trainingData);
+	if (!data || !data->num_data) return Nan::ThrowError("Training data is empty");
+	Rng rng = fanny->rng.fork();
+	fanny::initWeights(getFannStruct(fanny->fann), data, rng);
 }
 
 NAN_METHOD(FANNY::getLayerArray) {
@@ -1691,6 +2607,18 @@ NAN_METHOD(FANNY::setCascadeNumCandidateGroups) {
 	#endif
 }
 
+NAN_METHOD(FANNY::getCascadeThreads) {
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	info.GetReturnValue().Set(fanny->cascadeThreads);
+}
+
+NAN_METHOD(FANNY::setCascadeThreads) {
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	if (info.Length() != 1) return Nan::ThrowError("Must have an argument: threads");
+	if (!info[0]->IsNumber()) return Nan::ThrowError("threads not a number");
+	fanny->cascadeThreads = info[0]->Uint32Value(Nan::GetCurrentContext()).FromJust();
+}
+
 NAN_METHOD(FANNY::getActivationSteepness) {
 	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
 	if (info.Length() != 2) return Nan::ThrowError("Must have an arguments: layer and neuron");
@@ -1769,6 +2697,71 @@ NAN_METHOD(FANNY::setWeight) {
 	fanny->fann->set_weight(fromNeuron, toNeuron, weight);
 }
 
+NAN_METHOD(FANNY::getWeights) {
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	struct fann *ann = getFannStruct(fanny->fann);
+	info.GetReturnValue().Set(fannDataToTypedArray(ann->weights, ann->total_connections));
+}
+
+NAN_METHOD(FANNY::setWeights) {
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	if (info.Length() != 1) return Nan::ThrowError("Must have one argument");
+	struct fann *ann = getFannStruct(fanny->fann);
+	if (!typedArrayToFannData(info[0], ann->weights, ann->total_connections)) {
+		return Nan::ThrowTypeError("Weights must be a Float32Array, Float64Array or Int32Array with one entry per connection");
+	}
+}
+
+NAN_METHOD(FANNY::getWeightsView) {
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	struct fann *ann = getFannStruct(fanny->fann);
+	size_t length = ann->total_connections;
+	v8::Local<v8::ArrayBuffer> arrayBuffer;
+	if (!fanny->weightsView.IsEmpty() && fanny->weightsViewData == ann->weights && fanny->weightsViewLength == length) {
+		arrayBuffer = Nan::New(fanny->weightsView);
+	} else {
+		fanny->detachWeightsView();
+		v8::Isolate *isolate = v8::Isolate::GetCurrent();
+		#if V8_MAJOR_VERSION >= 8
+		// The network owns the memory, so the backing store must not free it
+		std::unique_ptr<v8::BackingStore> backingStore = v8::ArrayBuffer::NewBackingStore(
+			ann->weights,
+			length * sizeof(fann_type),
+			[](void *data, size_t length, void *deleterData) {},
+			NULL
+		);
+		arrayBuffer = v8::ArrayBuffer::New(isolate, std::move(backingStore));
+		#else
+		arrayBuffer = v8::ArrayBuffer::New(isolate, ann->weights, length * sizeof(fann_type));
+		#endif
+		// Keep the network alive for as long as the buffer is reachable
+		Nan::SetPrivate(arrayBuffer, Nan::New("fannyHolder").ToLocalChecked(), info.Holder());
+		fanny->weightsView.Reset(arrayBuffer);
+		fanny->weightsView.SetWeak(fanny, weightsViewWeakCallback, Nan::WeakCallbackType::kParameter);
+		fanny->weightsViewData = ann->weights;
+		fanny->weightsViewLength = length;
+	}
+	info.GetReturnValue().Set(FannTypedArray::New(arrayBuffer, 0, length));
+}
+
+void FANNY::weightsViewWeakCallback(const Nan::WeakCallbackInfo<FANNY> &data) {
+	data.GetParameter()->weightsView.Reset();
+}
+
+void FANNY::detachWeightsView() {
+	if (weightsView.IsEmpty()) return;
+	Nan::HandleScope scope;
+	v8::Local<v8::ArrayBuffer> arrayBuffer = Nan::New(weightsView);
+	#if V8_MAJOR_VERSION > 11 || (V8_MAJOR_VERSION == 11 && V8_MINOR_VERSION >= 3)
+	arrayBuffer->Detach(v8::Local<v8::Value>()).Check();
+	#else
+	arrayBuffer->Detach();
+	#endif
+	weightsView.Reset();
+	weightsViewData = NULL;
+	weightsViewLength = 0;
+}
+
 NAN_METHOD(FANNY::getUserDataString) {
 	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
 	char *str = fanny->fann->get_user_data_string();
@@ -1786,6 +2779,14 @@ NAN_METHOD(FANNY::setUserDataString) {
 	fanny->fann->set_user_data_string(*utf8String);
 }
 
+NAN_METHOD(FANNY::setSeed) {
+	if (info.Length() != 1 || !info[0]->IsNumber()) return Nan::ThrowError("Seed must be a number");
+	double seed = Nan::To<double>(info[0]).FromJust();
+	if (!(seed >= 0) || seed != floor(seed) || seed > 9007199254740992.0) return Nan::ThrowError("Seed must be a non-negative integer");
+	FANNY *fanny = Nan::ObjectWrap::Unwrap<FANNY>(info.Holder());
+	fanny->rng.seed((uint64_t)seed);
+}
+
 NAN_METHOD(FANNY::disableSeedRand) {
 	fann_disable_seed_rand();
 }
@@ -3,6 +3,12 @@
 
 #include <nan.h>
 #include "fann-includes.h"
+#include "train-state.h"
+#include "sparse.h"
+#include "csr-net.h"
+#include "shortcut-net.h"
+#include "rng.h"
+#include "model-file.h"
 
 namespace fanny {
 
@@ -20,10 +26,12 @@ public:
 
 	// User-defined training callback function
 	Nan::Persistent<v8::Function> trainingCallbackFn;
+	// Registers the training callback (if any) on the current network, with this object as its user data
+	void registerTrainingCallback();
 
 	// Constructor
-	static Nan::Persistent<v8::FunctionTemplate> constructorFunctionTpl;
-	static Nan::Persistent<v8::Function> constructorFunction;
+	static thread_local Nan::Persistent<v8::FunctionTemplate> constructorFunctionTpl;
+	static thread_local Nan::Persistent<v8::Function> constructorFunction;
 
 	// Current training iteration data
 	class TrainingProgress {
@@ -37,6 +45,51 @@ public:
 	TrainWorker *currentTrainWorker;
 	bool cancelTrainingFlag;
 
+	// Takes periodic snapshots during training, if enabled with setCheckpoint()
+	Checkpointer *checkpointer;
+
+	// Number of threads to train cascade candidates on.  0 or 1 uses FANN's serial cascade training.
+	unsigned int cascadeThreads;
+
+	// Layout for sparse inputs, built on first use and rebuilt when the network's structure changes
+	SparseNetPlan *sparsePlan;
+	SparseNetPlan *getSparsePlan();
+
+	// CSR engine used to run and train partially connected networks.  getCsrNet() returns NULL if the
+	// network isn't one (see CsrNet::handles()).  Must be called from the main thread.
+	CsrNet *csrNet;
+	CsrNet *getCsrNet();
+
+	// Engine for shortcut networks, built on first run
+	ShortcutNet *shortcutNet;
+	// Engine to run the network with instead of fann_run(), or NULL.  Must be called from the main thread.
+	ForwardEngine *getRunEngine();
+
+	// CSR engine over a fully connected network, for runs that overlap a run on a worker thread
+	CsrNet *concurrentNet;
+	// Engine that keeps its neuron values in its own scratch space, so it can run on the main thread
+	// while a queued run is executing fann_run() on a worker thread.  Returns getRunEngine() if there is
+	// one, NULL if the network can't be run that way (fixed point and invalid shortcut networks).  Must be
+	// called from the main thread.
+	ForwardEngine *getConcurrentEngine();
+
+	// Mapping of the model file the weights were loaded from (see loadModelFile), or NULL.  FANN must not
+	// free or reallocate mapped weights, so anything that would calls unmapWeights() first.
+	MappedModel *mappedModel;
+	// Copies mapped weights into memory the network owns and releases the mapping.  Returns false if
+	// the memory can't be allocated.
+	bool unmapWeights();
+
+	// Random stream for weight initialization.  Seeded from the system unless setSeed() is called.
+	Rng rng;
+
+	// ArrayBuffer over the network's weight storage handed out by getWeightsView(), held weakly.
+	// It must be detached before anything reallocates the weights (eg. cascade training adding neurons).
+	Nan::Persistent<v8::ArrayBuffer> weightsView;
+	fann_type *weightsViewData;
+	size_t weightsViewLength;
+	void detachWeightsView();
+
 private:
 
 	// Javascript Constructor.  Takes single "options" object parameter.  Options can include:
@@ -47,15 +100,51 @@ private:
 
 	static NAN_METHOD(loadFile);
 
+	// Asynchronous version of the constructor.  Takes an options object (as for the constructor) or
+	// another FANNY to copy, and a callback.  Construction happens on a worker thread.
+	static NAN_METHOD(createAsync);
+
+	// Creates a FANNY from a Buffer in FANN's network file format.  This is how networks are converted
+	// between datatypes: each datatype is a separate addon, linked against its own FANN build.
+	static NAN_METHOD(loadBuffer);
+	// Serializes the network to a Buffer in FANN's network file format.  Takes a boolean (whether to
+	// save as fixed point) and a callback.
+	static NAN_METHOD(exportBuffer);
+
 	static NAN_METHOD(save);
 	static NAN_METHOD(saveToFixed);
+	// Writes a model file (see model-file.h).  Takes a filename and a callback.
+	static NAN_METHOD(saveModelFile);
+	// Creates a FANNY from a model file, using its weights in place from a private memory map.  Takes
+	// a filename and a callback.
+	static NAN_METHOD(loadModelFile);
 
 	// FANN "run" method.  Parameter is array of numbers.  Returns array of numbers.
-	// Also takes a callback.
+	// Also takes a callback.  An optional boolean before the callback applies the network's
+	// scaling parameters to the inputs and outputs.
 	static NAN_METHOD(runAsync);
 
-	// Synchronous version of "run".
+	// Synchronous version of "run".  An optional boolean after the scaling flag runs with
+	// getConcurrentEngine(), for calls made while another run is in progress.
 	static NAN_METHOD(run);
+
+	// Runs a batch of inputs, given as an array of arrays or a typed array of rows laid end to end.
+	// Returns outputs in the same form.  Takes the same optional scaling and concurrency flags as run.
+	static NAN_METHOD(runBatch);
+	// Whether run and runBatch can be called while another run is in progress
+	static NAN_METHOD(canRunConcurrently);
+	// Asynchronous version of runBatch.  The last argument is a callback.
+	static NAN_METHOD(runBatchAsync);
+
+	// Runs the network on a sparse input, given as arrays of indices and values.  Unlisted inputs are 0.
+	static NAN_METHOD(runSparse);
+	// Runs a batch of sparse inputs in CSR form (rowOffsets, indices, values).  Returns a typed array
+	// of the output rows laid end to end.
+	static NAN_METHOD(runSparseBatch);
+	static NAN_METHOD(runSparseBatchAsync);
+	// Trains on SparseTrainingData with sparse incremental backpropagation (see SparseNetPlan::trainEpoch()).
+	// Takes the data, maxEpochs, desiredError and a callback, which receives the final MSE.
+	static NAN_METHOD(trainSparse);
 	static NAN_METHOD(getNumInput);
 	static NAN_METHOD(getNumOutput);
 	static NAN_METHOD(getTotalNeurons);
@@ -93,6 +182,10 @@ private:
 	static NAN_METHOD(printParameters);
 
 	static NAN_METHOD(randomizeWeights);
+	static NAN_METHOD(randomizeWeightsAsync);
+	static NAN_METHOD(initWeightsAsync);
+	// Reseeds the network's random stream.  Takes a non-negative integer.
+	static NAN_METHOD(setSeed);
 	static NAN_METHOD(disableSeedRand);
 	static NAN_METHOD(enableSeedRand);
 
@@ -122,6 +215,10 @@ private:
 	static NAN_METHOD(setCascadeMaxCandEpochs);
 	static NAN_METHOD(setCascadeNumCandidateGroups);
 
+	// Sets the number of threads used to train cascade candidates (see parallelCascadetrainOnData())
+	static NAN_METHOD(getCascadeThreads);
+	static NAN_METHOD(setCascadeThreads);
+
 	static NAN_METHOD(setQuickpropDecay);
 	static NAN_METHOD(setQuickpropMu);
 	static NAN_METHOD(setRpropIncreaseFactor);
@@ -176,12 +273,40 @@ private:
 	static NAN_METHOD(setWeightArray);
 	static NAN_METHOD(setWeight);
 
+	// Bulk weight access, in the same order as getConnectionArray().  getWeights() returns a copy
+	// in a typed array matching fann_type; setWeights() takes a typed array with one entry per connection.
+	static NAN_METHOD(getWeights);
+	static NAN_METHOD(setWeights);
+	// Returns a typed array backed directly by the network's weight storage, without copying
+	static NAN_METHOD(getWeightsView);
+	static void weightsViewWeakCallback(const Nan::WeakCallbackInfo<FANNY> &data);
+
 	static NAN_METHOD(getUserDataString);
 	static NAN_METHOD(setUserDataString);
 
 	static void _doTrainOrTest(const Nan::FunctionCallbackInfo<v8::Value> &info, bool fromFile, bool isCascade, bool singleEpoch, bool isTest);
 
 	static NAN_METHOD(setCallback);
+
+	// Enables periodic checkpoints for subsequent training.  Takes an options object with
+	// epochs, seconds, filename and ringSize; with no arguments, disables checkpointing.
+	static NAN_METHOD(setCheckpoint);
+	// Returns an array of { epochs, mse } for the in-memory checkpoint ring
+	static NAN_METHOD(getCheckpoints);
+	// Returns a new FANNY restored from the in-memory checkpoint at the given index
+	static NAN_METHOD(getCheckpoint);
+
+	// Export and import the optimizer state (see TrainState) as a Buffer
+	static NAN_METHOD(getTrainState);
+	static NAN_METHOD(setTrainState);
+
+	// Builds a QuantizedANN from this network.  Takes calibration TrainingData, bits (8 or 16), and a callback.
+	static NAN_METHOD(quantize);
+	// Copies this network into a SharedNet and returns the SharedArrayBuffer that owns it
+	static NAN_METHOD(share);
+	// Takes another FANNY and swaps networks with it, along with everything built from them.  Wrappers
+	// that refer to this object (eg. ensembles) use the new network from then on.
+	static NAN_METHOD(swapNetwork);
 	static int fannInternalCallback(
 		FANN::neural_net &fann,
 		FANN::training_data &train,
@@ -0,0 +1,59 @@
+#ifndef FANNY_FORWARD_ENGINE_H
+#define FANNY_FORWARD_ENGINE_H
+
+#include "fann-includes.h"
+#include <vector>
+#include <algorithm>
+
+namespace fanny {
+
+// A native evaluator used in place of fann_run() for network topologies that FANN runs slowly.
+// Engines only capture a network's connection structure, and read its weights and activation
+// parameters on each run, so they stay valid while the network is trained.  They must be rebuilt when
+// the structure changes (see isCurrent()).  run() is const, so one engine can run rows concurrently
+// with separate scratch buffers.
+class ForwardEngine {
+public:
+	virtual ~ForwardEngine() {}
+
+	// Whether the engine was built from this structure
+	virtual bool isCurrent(struct fann *ann) const = 0;
+
+	// Runs the network on one row of inputs, writing its outputs.  scratch is resized as needed, and can
+	// be reused across calls.
+	virtual void run(const fann_type *input, fann_type *output, std::vector<fann_type> &scratch) const = 0;
+};
+
+// Runs rows of inputs with an engine, scaling them in place and descaling the outputs if scale is set.
+// Without an engine, rows are run with fann_run(), which uses the network's own neuron values, so only one
+// such run can happen at a time.  Never touches the network's error state.  Returns false, without running
+// anything, if scaling was requested and the network has no scaling parameters.
+inline bool runEngineRows(struct fann *ann, const ForwardEngine *engine, fann_type *inputs, unsigned int numRows, bool scale, fann_type *outputs) {
+	#ifndef FANNY_FIXED
+	// fann_scale_input() reports missing parameters by setting the error on the network, so check for
+	// them first
+	if (scale && (ann->scale_mean_in == NULL || ann->scale_mean_out == NULL)) return false;
+	#endif
+	std::vector<fann_type> scratch;
+	for (unsigned int row = 0; row < numRows; ++row) {
+		fann_type *rowInputs = inputs + (size_t)row * ann->num_input;
+		fann_type *rowOutputs = outputs + (size_t)row * ann->num_output;
+		#ifndef FANNY_FIXED
+		if (scale) fann_scale_input(ann, rowInputs);
+		#endif
+		if (engine) {
+			engine->run(rowInputs, rowOutputs, scratch);
+		} else {
+			fann_type *fannOutputs = fann_run(ann, rowInputs);
+			std::copy(fannOutputs, fannOutputs + ann->num_output, rowOutputs);
+		}
+		#ifndef FANNY_FIXED
+		if (scale) fann_descale_output(ann, rowOutputs);
+		#endif
+	}
+	return true;
+}
+
+}
+
+#endif
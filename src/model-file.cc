@@ -0,0 +1,238 @@
+#include "model-file.h"
+#include "fann-internals.h"
+#include <vector>
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace fanny {
+
+static const char modelFileMagic[8] = { 'F', 'A', 'N', 'N', 'Y', 'M', 'F', '1' };
+
+#if defined(FANNY_FIXED)
+static const uint32_t modelFileDatatype = 2;
+#elif defined(FANNY_DOUBLE)
+static const uint32_t modelFileDatatype = 1;
+#else
+static const uint32_t modelFileDatatype = 0;
+#endif
+
+// Alignment of the weights in the file, so they start on a page boundary of the mapping
+static const uint64_t modelFileWeightsAlignment = 65536;
+
+struct ModelFileHeader {
+	char magic[8];
+	uint32_t datatype;
+	uint32_t fannTypeSize;
+	uint64_t configOffset;
+	uint64_t configLength;
+	uint64_t numNeurons;
+	uint64_t numConnections;
+	uint64_t inputCountsOffset;
+	uint64_t sourcesOffset;
+	uint64_t weightsOffset;
+};
+
+static uint64_t alignOffset(uint64_t offset, uint64_t alignment) {
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Whether [offset, offset + length) fits in a file of size bytes
+static bool inFile(uint64_t offset, uint64_t length, uint64_t size) {
+	return offset <= size && length <= size - offset;
+}
+
+bool saveModelFile(struct fann *ann, const std::string &filename, std::string &errorMessage) {
+	struct fann_neuron *firstNeuron = ann->first_layer->first_neuron;
+	unsigned int numNeurons = ann->total_neurons;
+	unsigned int numConnections = ann->total_connections;
+	std::vector<uint32_t> inputCounts(numNeurons);
+	std::vector<unsigned int> firstCons(numNeurons);
+	for (unsigned int neuronIdx = 0; neuronIdx < numNeurons; ++neuronIdx) {
+		inputCounts[neuronIdx] = firstNeuron[neuronIdx].last_con - firstNeuron[neuronIdx].first_con;
+		firstCons[neuronIdx] = firstNeuron[neuronIdx].first_con;
+	}
+	std::vector<uint32_t> sources(numConnections);
+	for (unsigned int con = 0; con < numConnections; ++con) {
+		sources[con] = (uint32_t)(ann->connections[con] - firstNeuron);
+	}
+
+	// FANN writes each neuron's [first_con, last_con) range and total_connections connections, so
+	// empty them while it writes the rest of the network
+	char *config = NULL;
+	size_t configLength = 0;
+	FILE *stream = open_memstream(&config, &configLength);
+	if (!stream) {
+		errorMessage = "Error allocating model buffer";
+		return false;
+	}
+	for (unsigned int neuronIdx = 0; neuronIdx < numNeurons; ++neuronIdx) {
+		firstNeuron[neuronIdx].first_con = firstNeuron[neuronIdx].last_con = 0;
+	}
+	ann->total_connections = 0;
+	int result = fann_save_internal_fd(ann, stream, filename.c_str(), 0);
+	ann->total_connections = numConnections;
+	for (unsigned int neuronIdx = 0; neuronIdx < numNeurons; ++neuronIdx) {
+		firstNeuron[neuronIdx].first_con = firstCons[neuronIdx];
+		firstNeuron[neuronIdx].last_con = firstCons[neuronIdx] + inputCounts[neuronIdx];
+	}
+	fclose(stream);
+	if (result == -1) {
+		free(config);
+		errorMessage = "Error serializing FANN network";
+		return false;
+	}
+
+	ModelFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, modelFileMagic, sizeof(modelFileMagic));
+	header.datatype = modelFileDatatype;
+	header.fannTypeSize = sizeof(fann_type);
+	header.configOffset = sizeof(header);
+	header.configLength = configLength;
+	header.numNeurons = numNeurons;
+	header.numConnections = numConnections;
+	header.inputCountsOffset = alignOffset(header.configOffset + configLength, 8);
+	header.sourcesOffset = alignOffset(header.inputCountsOffset + (uint64_t)numNeurons * sizeof(uint32_t), 8);
+	header.weightsOffset = alignOffset(header.sourcesOffset + (uint64_t)numConnections * sizeof(uint32_t), modelFileWeightsAlignment);
+
+	// Processes may have the existing file mapped, and would read torn weights (or fault on truncated pages)
+	// if it were rewritten in place.  Write a new file next to it and rename it over the old one, so existing
+	// mappings keep the old file.
+	static std::atomic<unsigned int> tempCounter(0);
+	std::string tempFilename = filename + ".tmp." + std::to_string(getpid()) + "." + std::to_string(tempCounter++);
+	int fd = open(tempFilename.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+	FILE *file = (fd == -1) ? NULL : fdopen(fd, "wb");
+	if (!file) {
+		if (fd != -1) {
+			close(fd);
+			unlink(tempFilename.c_str());
+		}
+		free(config);
+		errorMessage = "Could not open model file for writing";
+		return false;
+	}
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(config, 1, configLength, file) == configLength &&
+		fseeko(file, (off_t)header.inputCountsOffset, SEEK_SET) == 0 &&
+		(!numNeurons || fwrite(&inputCounts[0], sizeof(uint32_t), numNeurons, file) == numNeurons) &&
+		fseeko(file, (off_t)header.sourcesOffset, SEEK_SET) == 0 &&
+		(!numConnections || fwrite(&sources[0], sizeof(uint32_t), numConnections, file) == numConnections) &&
+		fseeko(file, (off_t)header.weightsOffset, SEEK_SET) == 0 &&
+		(!numConnections || fwrite(ann->weights, sizeof(fann_type), numConnections, file) == numConnections);
+	free(config);
+	// The data must be on disk before the rename is, or a crash could leave an empty model file
+	if (ok && (fflush(file) != 0 || fsync(fileno(file)) != 0)) ok = false;
+	if (fclose(file) != 0) ok = false;
+	if (ok && rename(tempFilename.c_str(), filename.c_str()) != 0) ok = false;
+	if (!ok) {
+		unlink(tempFilename.c_str());
+		errorMessage = "Error writing model file";
+	}
+	return ok;
+}
+
+
+MappedModel::MappedModel(void *_data, size_t _length) : data(_data), length(_length) {}
+
+MappedModel::~MappedModel() {
+	munmap(data, length);
+}
+
+bool MappedModel::contains(const void *ptr) const {
+	return ptr >= data && ptr < (const char *)data + length;
+}
+
+struct fann *loadModelFile(const std::string &filename, MappedModel *&mapping, std::string &errorMessage) {
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd == -1) {
+		errorMessage = "Could not open model file";
+		return NULL;
+	}
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || (uint64_t)fileStat.st_size < sizeof(ModelFileHeader)) {
+		close(fd);
+		errorMessage = "Model file is truncated";
+		return NULL;
+	}
+	uint64_t size = (uint64_t)fileStat.st_size;
+	// Writable but private: the file is never modified, and written pages become private copies
+	void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		errorMessage = "Could not map model file";
+		return NULL;
+	}
+	MappedModel *newMapping = new MappedModel(data, size);
+
+	const ModelFileHeader *header = (const ModelFileHeader *)data;
+	if (memcmp(header->magic, modelFileMagic, sizeof(modelFileMagic)) != 0) {
+		errorMessage = "Not a model file";
+	} else if (header->datatype != modelFileDatatype || header->fannTypeSize != sizeof(fann_type)) {
+		errorMessage = "Model file has a different datatype";
+	} else if (
+		!inFile(header->configOffset, header->configLength, size) ||
+		header->numNeurons > UINT32_MAX || header->numConnections > UINT32_MAX ||
+		header->inputCountsOffset % sizeof(uint32_t) || !inFile(header->inputCountsOffset, header->numNeurons * sizeof(uint32_t), size) ||
+		header->sourcesOffset % sizeof(uint32_t) || !inFile(header->sourcesOffset, header->numConnections * sizeof(uint32_t), size) ||
+		header->weightsOffset % sizeof(fann_type) || !inFile(header->weightsOffset, header->numConnections * sizeof(fann_type), size)
+	) {
+		errorMessage = "Model file is truncated";
+	}
+	if (!errorMessage.empty()) {
+		delete newMapping;
+		return NULL;
+	}
+
+	const uint32_t *inputCounts = (const uint32_t *)((const char *)data + header->inputCountsOffset);
+	const uint32_t *sources = (const uint32_t *)((const char *)data + header->sourcesOffset);
+	unsigned int numNeurons = (unsigned int)header->numNeurons;
+	unsigned int numConnections = (unsigned int)header->numConnections;
+	uint64_t connectionSum = 0;
+	for (unsigned int neuronIdx = 0; neuronIdx < numNeurons; ++neuronIdx) connectionSum += inputCounts[neuronIdx];
+	bool valid = connectionSum == numConnections;
+	for (unsigned int con = 0; valid && con < numConnections; ++con) {
+		if (sources[con] >= numNeurons) valid = false;
+	}
+	struct fann *ann = NULL;
+	if (valid) {
+		FILE *stream = fmemopen((char *)data + header->configOffset, header->configLength, "r");
+		if (stream) {
+			ann = fann_create_from_fd(stream, filename.c_str());
+			fclose(stream);
+		}
+		valid = ann && ann->total_neurons == numNeurons && ann->total_connections == 0;
+	}
+	struct fann_neuron **connections = valid ? (struct fann_neuron **)malloc((size_t)numConnections * sizeof(struct fann_neuron *)) : NULL;
+	if (!connections) {
+		if (ann) fann_destroy(ann);
+		delete newMapping;
+		errorMessage = valid ? "Could not allocate connections" : "Error loading FANN model file";
+		return NULL;
+	}
+
+	// Replace the empty connection arrays FANN allocated with the file's connections
+	struct fann_neuron *firstNeuron = ann->first_layer->first_neuron;
+	unsigned int con = 0;
+	for (unsigned int neuronIdx = 0; neuronIdx < numNeurons; ++neuronIdx) {
+		firstNeuron[neuronIdx].first_con = con;
+		con += inputCounts[neuronIdx];
+		firstNeuron[neuronIdx].last_con = con;
+	}
+	for (con = 0; con < numConnections; ++con) connections[con] = firstNeuron + sources[con];
+	free(ann->weights);
+	free(ann->connections);
+	ann->weights = (fann_type *)((char *)data + header->weightsOffset);
+	ann->connections = connections;
+	ann->total_connections = ann->total_connections_allocated = numConnections;
+	mapping = newMapping;
+	return ann;
+}
+
+}
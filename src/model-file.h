@@ -0,0 +1,42 @@
+#ifndef FANNY_MODEL_FILE_H
+#define FANNY_MODEL_FILE_H
+
+#include "fann-includes.h"
+#include <string>
+#include <stddef.h>
+
+namespace fanny {
+
+// Binary network file whose weights can be used in place from a memory map.  Parsing FANN's text
+// format is slow for large networks and leaves every process with a private copy of the weights.  A
+// model file holds:
+// - A header (see ModelFileHeader in model-file.cc)
+// - FANN's text format for the network with its connections left out (parameters, layers, activation
+//   functions and scaling)
+// - The number of inputs of each neuron, and the source neuron of each connection, as uint32
+// - The weights, as fann_type, at a page-aligned offset
+// Model files are specific to the datatype and byte order of the build that wrote them.  The file is
+// replaced atomically, so processes that have the old file mapped keep running on it.
+bool saveModelFile(struct fann *ann, const std::string &filename, std::string &errorMessage);
+
+// Private, read-only mapping of a model file.  Pages that aren't written are shared with the page
+// cache, so every process that maps the same file uses one physical copy of the weights.  Writes (eg.
+// training) copy the pages they touch.
+class MappedModel {
+public:
+	MappedModel(void *_data, size_t _length);
+	~MappedModel();
+	void *data;
+	size_t length;
+
+	// Whether ptr is inside the mapping
+	bool contains(const void *ptr) const;
+};
+
+// Loads a model file, leaving the network's weights in a new MappedModel.  FANN must never free or
+// reallocate those weights; see FANNY::unmapWeights().  Returns NULL and sets errorMessage on failure.
+struct fann *loadModelFile(const std::string &filename, MappedModel *&mapping, std::string &errorMessage);
+
+}
+
+#endif
@@ -0,0 +1,193 @@
+#include "parallel-cascade.h"
+#include "fann-internals.h"
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace fanny {
+
+// Part of the candidate pool: one activation function, with every steepness, and some of the candidate groups
+class CandidateSlice {
+public:
+	CandidateSlice(enum fann_activationfunc_enum _activationFunction, unsigned int _numGroups) :
+		activationFunction(_activationFunction), numGroups(_numGroups), ann(NULL), bestScore(0), epochs(0) {}
+	enum fann_activationfunc_enum activationFunction;
+	unsigned int numGroups;
+	// Copy of the network the slice was trained on, with its candidates in place
+	struct fann *ann;
+	fann_type bestScore;
+	int epochs;
+};
+
+// The score fann_train_candidates() uses to choose cascade_best_candidate
+static fann_type bestCandidateScore(struct fann *ann) {
+	unsigned int numCandidates = fann_get_cascade_num_candidates(ann);
+	fann_type best = ann->cascade_candidate_scores[0];
+	for (unsigned int idx = 1; idx < numCandidates; ++idx) {
+		if (ann->cascade_candidate_scores[idx] > best) best = ann->cascade_candidate_scores[idx];
+	}
+	return best;
+}
+
+// Copies the network and trains the slice's candidates on the copy.  Returns false if the
+// candidates couldn't be allocated.
+static bool trainCandidateSlice(struct fann *ann, struct fann_train_data *data, CandidateSlice &slice) {
+	slice.ann = fann_copy(ann);
+	if (!slice.ann) return false;
+	fann_set_cascade_activation_functions(slice.ann, &slice.activationFunction, 1);
+	fann_set_cascade_num_candidate_groups(slice.ann, slice.numGroups);
+	if (fann_initialize_candidates(slice.ann) == -1) return false;
+	slice.epochs = fann_train_candidates(slice.ann, data);
+	slice.bestScore = bestCandidateScore(slice.ann);
+	return true;
+}
+
+// Trains every slice across the threads.  Returns the index of the slice with the best candidate
+// (the earliest one on ties, as in the serial candidate order), or -1 if any slice failed.  Copies
+// other than the winner's are destroyed.
+static int trainCandidateSlices(struct fann *ann, struct fann_train_data *data, std::vector<CandidateSlice> &slices, unsigned int numThreads) {
+	std::atomic<size_t> nextSlice(0);
+	std::atomic<bool> failed(false);
+	std::vector<int> threadBest(numThreads, -1);
+	auto worker = [&](unsigned int threadIdx) {
+		for (size_t sliceIdx = nextSlice++; sliceIdx < slices.size() && !failed; sliceIdx = nextSlice++) {
+			CandidateSlice &slice = slices[sliceIdx];
+			if (!trainCandidateSlice(ann, data, slice)) {
+				failed = true;
+				break;
+			}
+			// Slices are taken in increasing order, so a tie keeps the earlier one
+			int &best = threadBest[threadIdx];
+			if (best < 0 || slice.bestScore > slices[best].bestScore) {
+				if (best >= 0) {
+					fann_destroy(slices[best].ann);
+					slices[best].ann = NULL;
+				}
+				best = (int)sliceIdx;
+			} else {
+				fann_destroy(slice.ann);
+				slice.ann = NULL;
+			}
+		}
+	};
+	std::vector<std::thread> threads;
+	for (unsigned int threadIdx = 1; threadIdx < numThreads; ++threadIdx) {
+		threads.push_back(std::thread(worker, threadIdx));
+	}
+	worker(0);
+	for (size_t idx = 0; idx < threads.size(); ++idx) {
+		threads[idx].join();
+	}
+
+	int winner = -1;
+	for (unsigned int threadIdx = 0; threadIdx < numThreads; ++threadIdx) {
+		int best = threadBest[threadIdx];
+		if (best < 0) continue;
+		if (winner < 0 || slices[best].bestScore > slices[winner].bestScore ||
+			(slices[best].bestScore == slices[winner].bestScore && best < winner)
+		) {
+			winner = best;
+		}
+	}
+	for (size_t sliceIdx = 0; sliceIdx < slices.size(); ++sliceIdx) {
+		if (slices[sliceIdx].ann && (failed || (int)sliceIdx != winner)) {
+			fann_destroy(slices[sliceIdx].ann);
+			slices[sliceIdx].ann = NULL;
+		}
+	}
+	return failed ? -1 : winner;
+}
+
+bool parallelCascadetrainOnData(
+	FANN::neural_net *net,
+	struct fann_train_data *data,
+	unsigned int maxNeurons,
+	unsigned int neuronsBetweenReports,
+	float desiredError,
+	unsigned int numThreads,
+	std::string &error
+) {
+	struct fann *ann = getFannStruct(net);
+	if (ann->network_type != FANN_NETTYPE_SHORTCUT) {
+		error = "Cascade training requires a shortcut network";
+		return false;
+	}
+	if (data->num_input != ann->num_input || data->num_output != ann->num_output) {
+		error = "Training data does not match the network's inputs and outputs";
+		return false;
+	}
+	if (numThreads < 1) numThreads = 1;
+
+	// Split the pool by activation function, then split the candidate groups as needed to give every thread work
+	std::vector<enum fann_activationfunc_enum> activationFunctions(
+		ann->cascade_activation_functions,
+		ann->cascade_activation_functions + ann->cascade_activation_functions_count
+	);
+	unsigned int numGroups = ann->cascade_num_candidate_groups;
+	std::vector<CandidateSlice> sliceTemplate;
+	if (!activationFunctions.empty() && numGroups > 0) {
+		unsigned int groupChunks = (unsigned int)((numThreads + activationFunctions.size() - 1) / activationFunctions.size());
+		if (groupChunks > numGroups) groupChunks = numGroups;
+		for (size_t fnIdx = 0; fnIdx < activationFunctions.size(); ++fnIdx) {
+			for (unsigned int chunk = 0; chunk < groupChunks; ++chunk) {
+				unsigned int chunkGroups = numGroups / groupChunks + ((chunk < numGroups % groupChunks) ? 1 : 0);
+				sliceTemplate.push_back(CandidateSlice(activationFunctions[fnIdx], chunkGroups));
+			}
+		}
+	}
+	if (sliceTemplate.empty() || ann->cascade_activation_steepnesses_count == 0) {
+		error = "No cascade candidates are configured";
+		return false;
+	}
+	if (numThreads > sliceTemplate.size()) numThreads = (unsigned int)sliceTemplate.size();
+
+	unsigned int totalEpochs = 0;
+	for (unsigned int neuronIdx = 1; neuronIdx <= maxNeurons; ++neuronIdx) {
+		totalEpochs += fann_train_outputs(ann, data, desiredError);
+		int desiredErrorReached = fann_desired_error_reached(ann, desiredError);
+		if (neuronsBetweenReports && (
+			neuronIdx % neuronsBetweenReports == 0 || neuronIdx == maxNeurons || neuronIdx == 1 || desiredErrorReached == 0
+		)) {
+			if (ann->callback == NULL) {
+				printf("Neurons     %3d. Current error: %.6f. Epochs %5d. Bit fail %3d\n",
+					neuronIdx - 1, fann_get_MSE(ann), totalEpochs, ann->num_bit_fail);
+			} else if ((*ann->callback)(ann, data, maxNeurons, neuronsBetweenReports, desiredError, totalEpochs) == -1) {
+				break;
+			}
+		}
+		if (desiredErrorReached == 0) break;
+
+		std::vector<CandidateSlice> slices(sliceTemplate);
+		int winner = trainCandidateSlices(ann, data, slices, numThreads);
+		// Like fann_cascadetrain_on_data(), stop adding neurons if candidates can't be allocated
+		if (winner < 0) break;
+		int maxSliceEpochs = 0;
+		for (size_t sliceIdx = 0; sliceIdx < slices.size(); ++sliceIdx) {
+			if (slices[sliceIdx].epochs > maxSliceEpochs) maxSliceEpochs = slices[sliceIdx].epochs;
+		}
+		totalEpochs += maxSliceEpochs;
+
+		// The winning copy becomes the network, with the original settings and callback
+		struct fann *winnerAnn = slices[winner].ann;
+		fann_install_candidate(winnerAnn);
+		fann_set_cascade_activation_functions(winnerAnn, &activationFunctions[0], (unsigned int)activationFunctions.size());
+		fann_set_cascade_num_candidate_groups(winnerAnn, numGroups);
+		// fann_train_candidates() only allocates the scores if they're missing, and this array is sized for the slice
+		free(winnerAnn->cascade_candidate_scores);
+		winnerAnn->cascade_candidate_scores = NULL;
+		winnerAnn->callback = ann->callback;
+		winnerAnn->user_data = ann->user_data;
+		setFannStruct(net, winnerAnn);
+		fann_destroy(ann);
+		ann = winnerAnn;
+	}
+
+	// Train outputs one last time without a desired error, as fann_cascadetrain_on_data() does
+	fann_train_outputs(ann, data, 0.0f);
+	fann_set_shortcut_connections(ann);
+	return true;
+}
+
+}
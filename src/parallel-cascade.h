@@ -0,0 +1,29 @@
+#ifndef FANNY_PARALLEL_CASCADE_H
+#define FANNY_PARALLEL_CASCADE_H
+
+#include "fann-includes.h"
+#include <string>
+
+namespace fanny {
+
+// Cascade-correlation training that trains the candidate pool on several threads.  It follows
+// fann_cascadetrain_on_data(), except that each round the candidates are split into slices (by
+// activation function, then by candidate group), and each slice is initialized and trained on its
+// own copy of the network.  The candidate with the highest score over all slices is installed.
+// The network's cascade settings are unchanged afterwards.
+//
+// The network's underlying fann structure is replaced each time a neuron is installed, so callers
+// must not hold on to pointers into it.  Returns false and sets error if training can't start.
+bool parallelCascadetrainOnData(
+	FANN::neural_net *net,
+	struct fann_train_data *data,
+	unsigned int maxNeurons,
+	unsigned int neuronsBetweenReports,
+	float desiredError,
+	unsigned int numThreads,
+	std::string &error
+);
+
+}
+
+#endif
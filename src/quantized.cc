@@ -0,0 +1,684 @@
+#include "quantized.h"
+#include "fanny.h"
+#include "training-data.h"
+#include "fann-internals.h"
+#include "activation.h"
+#include "utils.h"
+#include <math.h>
+#include <limits.h>
+#include <string.h>
+#include <algorithm>
+
+namespace fanny {
+
+QuantizationReport::QuantizationReport() :
+	floatMSE(0), quantizedMSE(0), maxAbsDiff(0), meanAbsDiff(0), argmaxAgreement(0), floatBytes(0), quantizedBytes(0) {}
+
+static const char quantizedModelMagic[8] = { 'F', 'A', 'N', 'N', 'Y', 'Q', 'M', '1' };
+
+// Bits of fraction in a position in an activation table
+static const int lutFractionBits = 8;
+
+// AccType must be wide enough to hold a row's worth of QType products
+template<typename QType, typename AccType>
+inline AccType quantizedDotProduct(const QType *weights, const QType *values, unsigned int length) {
+	AccType acc = 0;
+	for (unsigned int idx = 0; idx < length; ++idx) {
+		acc += (AccType)weights[idx] * (AccType)values[idx];
+	}
+	return acc;
+}
+
+// Multiplies by multiplier / 2^shift, rounding to nearest
+inline int64_t fixedPointScale(int64_t value, int32_t multiplier, uint8_t shift) {
+	int64_t product = value * multiplier;
+	if (!shift) return product;
+	return (product + ((int64_t)1 << (shift - 1))) >> shift;
+}
+
+// Splits scale into a multiplier of at most mantissaBits bits and a right shift
+static void toFixedPointScale(double scale, int mantissaBits, int32_t &multiplier, uint8_t &shift) {
+	int exponent;
+	double fraction = frexp(scale, &exponent);
+	int rightShift = mantissaBits - exponent;
+	if (scale == 0 || rightShift > 62) {
+		// Too small to move a sum by a table position
+		multiplier = 0;
+		shift = 0;
+		return;
+	}
+	if (rightShift < 0) {
+		// Any nonzero sum lands off the end of the table anyway
+		multiplier = (int32_t)((scale < 0) ? -((1 << mantissaBits) - 1) : ((1 << mantissaBits) - 1));
+		shift = 0;
+		return;
+	}
+	int64_t rounded = llround(ldexp(fraction, mantissaBits));
+	if ((rounded == ((int64_t)1 << mantissaBits) || rounded == -((int64_t)1 << mantissaBits)) && rightShift > 0) {
+		rounded /= 2;
+		--rightShift;
+	}
+	multiplier = (int32_t)rounded;
+	shift = (uint8_t)rightShift;
+}
+
+// Bounds-checked reads and writes for the serialized model (native byte order)
+class ModelWriter {
+public:
+	explicit ModelWriter(std::vector<char> &_buffer) : buffer(_buffer) {}
+	template<typename T> void write(const T &value) {
+		const char *bytes = (const char *)&value;
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+	}
+	template<typename T> void writeVector(const std::vector<T> &values) {
+		write((uint32_t)values.size());
+		if (!values.empty()) buffer.insert(buffer.end(), (const char *)&values[0], (const char *)&values[0] + values.size() * sizeof(T));
+	}
+	std::vector<char> &buffer;
+};
+
+class ModelReader {
+public:
+	ModelReader(const char *_data, size_t _length) : data(_data), length(_length), offset(0), ok(true) {}
+	template<typename T> T read() {
+		T value;
+		memset(&value, 0, sizeof(T));
+		if (length - offset < sizeof(T)) {
+			ok = false;
+			return value;
+		}
+		memcpy(&value, data + offset, sizeof(T));
+		offset += sizeof(T);
+		return value;
+	}
+	template<typename T> void readVector(std::vector<T> &values) {
+		uint32_t size = read<uint32_t>();
+		if (!ok || (length - offset) / sizeof(T) < size) {
+			ok = false;
+			values.clear();
+			return;
+		}
+		values.resize(size);
+		if (size) memcpy(&values[0], data + offset, (size_t)size * sizeof(T));
+		offset += (size_t)size * sizeof(T);
+	}
+	const char *data;
+	size_t length;
+	size_t offset;
+	bool ok;
+};
+
+template<typename QType, typename AccType, int maxQuantized, unsigned int lutIntervals>
+class QuantizedModelImpl : public QuantizedModel {
+public:
+	// Part of a layer's source range that comes from a single source layer
+	class Segment {
+	public:
+		uint32_t begin;
+		uint32_t end;
+	};
+
+	// An activation function sampled at lutIntervals + 1 evenly spaced sums across the layer's calibrated
+	// range, as quantized outputs of the layer
+	class ActivationTable {
+	public:
+		// Off for the threshold functions, which would be smeared across the interval around 0
+		uint8_t interpolate;
+		std::vector<QType> values;
+	};
+
+	class Layer {
+	public:
+		// Global index of the first source neuron, and the number of source neurons in each row
+		uint32_t srcBegin;
+		uint32_t rowLength;
+		// Global indices of the neurons computed by this layer, and of its bias neurons
+		std::vector<uint32_t> neurons;
+		std::vector<uint32_t> biasNeurons;
+		// Quantized value of this layer's bias neurons
+		QType biasValue;
+		// One row of rowLength weights per computed neuron
+		std::vector<QType> weights;
+		std::vector<Segment> segments;
+		// Per neuron and segment, the fixed point scale taking the segment's dot product to a position in
+		// the neuron's activation table.  Folds in the weight, source and table scales and the steepness.
+		std::vector<int32_t> multipliers;
+		std::vector<uint8_t> shifts;
+		std::vector<uint8_t> tableIndices;
+		std::vector<ActivationTable> tables;
+	};
+
+	uint32_t totalNeurons;
+	float inputScale;
+	float outputScale;
+	QType inputBiasValue;
+	std::vector<uint32_t> inputBiasNeurons;
+	std::vector<Layer> layers;
+
+	static QType quantize(float value) {
+		long rounded = lrintf(value);
+		if (rounded > maxQuantized) return maxQuantized;
+		if (rounded < -maxQuantized) return -maxQuantized;
+		return (QType)rounded;
+	}
+
+	static QType lookup(const ActivationTable &table, int64_t position) {
+		if (position <= 0) return table.values[0];
+		if (position >= ((int64_t)lutIntervals << lutFractionBits)) return table.values[lutIntervals];
+		size_t idx = (size_t)(position >> lutFractionBits);
+		int32_t fraction = (int32_t)(position & ((1 << lutFractionBits) - 1));
+		if (!table.interpolate) return table.values[(fraction >= (1 << (lutFractionBits - 1))) ? idx + 1 : idx];
+		int32_t delta = (int32_t)table.values[idx + 1] - (int32_t)table.values[idx];
+		return (QType)(table.values[idx] + ((delta * fraction + (1 << (lutFractionBits - 1))) >> lutFractionBits));
+	}
+
+	// Everything between quantizing the inputs and dequantizing the outputs is integer arithmetic
+	void run(const fann_type *inputs, float *outputs) const {
+		std::vector<QType> values(totalNeurons);
+		float invInputScale = 1.0f / inputScale;
+		for (unsigned int idx = 0; idx < numInput; ++idx) {
+			values[idx] = quantize((float)inputs[idx] * invInputScale);
+		}
+		for (size_t idx = 0; idx < inputBiasNeurons.size(); ++idx) {
+			values[inputBiasNeurons[idx]] = inputBiasValue;
+		}
+		const int64_t center = (int64_t)(lutIntervals / 2) << lutFractionBits;
+		const int64_t limit = (int64_t)lutIntervals << lutFractionBits;
+		for (size_t layerIdx = 0; layerIdx < layers.size(); ++layerIdx) {
+			const Layer &layer = layers[layerIdx];
+			const QType *src = &values[layer.srcBegin];
+			size_t numSegments = layer.segments.size();
+			for (size_t neuronIdx = 0; neuronIdx < layer.neurons.size(); ++neuronIdx) {
+				const QType *row = &layer.weights[neuronIdx * layer.rowLength];
+				int64_t position = center;
+				for (size_t segmentIdx = 0; segmentIdx < numSegments; ++segmentIdx) {
+					const Segment &segment = layer.segments[segmentIdx];
+					AccType acc = quantizedDotProduct<QType, AccType>(row + segment.begin, src + segment.begin, segment.end - segment.begin);
+					size_t scaleIdx = neuronIdx * numSegments + segmentIdx;
+					position += fixedPointScale((int64_t)acc, layer.multipliers[scaleIdx], layer.shifts[scaleIdx]);
+					// Keep the sum of several segments from overflowing; it's off the table past this
+					if (position > 2 * limit) position = 2 * limit;
+					if (position < -limit) position = -limit;
+				}
+				values[layer.neurons[neuronIdx]] = lookup(layer.tables[layer.tableIndices[neuronIdx]], position);
+			}
+			for (size_t idx = 0; idx < layer.biasNeurons.size(); ++idx) {
+				values[layer.biasNeurons[idx]] = layer.biasValue;
+			}
+		}
+		const Layer &outputLayer = layers.back();
+		for (unsigned int idx = 0; idx < numOutput; ++idx) {
+			outputs[idx] = (float)values[outputLayer.neurons[idx]] * outputScale;
+		}
+	}
+
+	size_t getMemoryUsage() const {
+		size_t bytes = 0;
+		for (size_t idx = 0; idx < layers.size(); ++idx) {
+			const Layer &layer = layers[idx];
+			bytes += layer.weights.size() * sizeof(QType);
+			bytes += layer.neurons.size() * (sizeof(uint32_t) + sizeof(uint8_t));
+			bytes += layer.multipliers.size() * (sizeof(int32_t) + sizeof(uint8_t));
+			for (size_t tableIdx = 0; tableIdx < layer.tables.size(); ++tableIdx) {
+				bytes += layer.tables[tableIdx].values.size() * sizeof(QType);
+			}
+		}
+		return bytes;
+	}
+
+	unsigned int getBits() const {
+		return sizeof(QType) * 8;
+	}
+
+	void build(struct fann *ann, const std::vector<float> &activationScales, const std::vector<float> &maxSums) {
+		struct fann_neuron *firstNeuron = ann->first_layer->first_neuron;
+		unsigned int numLayers = ann->last_layer - ann->first_layer;
+		numInput = ann->num_input;
+		numOutput = ann->num_output;
+		totalNeurons = ann->total_neurons;
+		inputScale = activationScales[0];
+		outputScale = activationScales[numLayers - 1];
+		inputBiasValue = quantize(1.0f / inputScale);
+		for (unsigned int idx = numInput; idx < (unsigned int)(ann->first_layer->last_neuron - firstNeuron); ++idx) {
+			inputBiasNeurons.push_back(idx);
+		}
+
+		for (struct fann_layer *layerIt = ann->first_layer + 1; layerIt != ann->last_layer; ++layerIt) {
+			unsigned int layerIdx = layerIt - ann->first_layer;
+			layers.push_back(Layer());
+			Layer &layer = layers.back();
+			float layerScale = activationScales[layerIdx];
+			layer.biasValue = quantize(1.0f / layerScale);
+
+			// Find the range of neurons this layer takes input from
+			unsigned int srcBegin = UINT_MAX;
+			unsigned int srcEnd = 0;
+			std::vector<float> steepnesses;
+			for (struct fann_neuron *neuronIt = layerIt->first_neuron; neuronIt != layerIt->last_neuron; ++neuronIt) {
+				if (neuronIt->first_con == neuronIt->last_con) {
+					layer.biasNeurons.push_back(neuronIt - firstNeuron);
+					continue;
+				}
+				layer.neurons.push_back(neuronIt - firstNeuron);
+				steepnesses.push_back((float)neuronIt->activation_steepness);
+				for (unsigned int con = neuronIt->first_con; con != neuronIt->last_con; ++con) {
+					unsigned int src = ann->connections[con] - firstNeuron;
+					if (src < srcBegin) srcBegin = src;
+					if (src + 1 > srcEnd) srcEnd = src + 1;
+				}
+			}
+			if (layer.neurons.empty()) {
+				srcBegin = 0;
+				srcEnd = 0;
+			}
+			layer.srcBegin = srcBegin;
+			layer.rowLength = srcEnd - srcBegin;
+
+			// Split the source range at layer boundaries, since each source layer has its own scale
+			std::vector<float> segmentScales;
+			for (struct fann_layer *srcLayerIt = ann->first_layer; srcLayerIt != layerIt; ++srcLayerIt) {
+				unsigned int layerBegin = srcLayerIt->first_neuron - firstNeuron;
+				unsigned int layerEnd = srcLayerIt->last_neuron - firstNeuron;
+				if (layerBegin < srcBegin) layerBegin = srcBegin;
+				if (layerEnd > srcEnd) layerEnd = srcEnd;
+				if (layerBegin >= layerEnd) continue;
+				Segment segment;
+				segment.begin = layerBegin - srcBegin;
+				segment.end = layerEnd - srcBegin;
+				layer.segments.push_back(segment);
+				segmentScales.push_back(activationScales[srcLayerIt - ann->first_layer]);
+			}
+
+			// Sample each activation function used in the layer across the calibrated range of its sums
+			double maxSum = (maxSums[layerIdx] > 0) ? maxSums[layerIdx] : 1.0;
+			double tableStep = 2 * maxSum / lutIntervals;
+			std::vector<enum fann_activationfunc_enum> tableFunctions;
+			for (size_t neuronIdx = 0; neuronIdx < layer.neurons.size(); ++neuronIdx) {
+				enum fann_activationfunc_enum fn = firstNeuron[layer.neurons[neuronIdx]].activation_function;
+				size_t tableIdx = std::find(tableFunctions.begin(), tableFunctions.end(), fn) - tableFunctions.begin();
+				if (tableIdx == tableFunctions.size()) {
+					tableFunctions.push_back(fn);
+					ActivationTable table;
+					table.interpolate = fn != FANN_THRESHOLD && fn != FANN_THRESHOLD_SYMMETRIC;
+					for (unsigned int sampleIdx = 0; sampleIdx <= lutIntervals; ++sampleIdx) {
+						float sum = (float)(-maxSum + sampleIdx * tableStep);
+						table.values.push_back(quantize(activationFunction(fn, 1.0f, sum) / layerScale));
+					}
+					layer.tables.push_back(table);
+				}
+				layer.tableIndices.push_back((uint8_t)tableIdx);
+			}
+
+			// The widest dot product decides how many bits of multiplier fit in 64 bits
+			double maxAcc = (double)layer.rowLength * maxQuantized * maxQuantized;
+			int accBits = 1;
+			while (accBits < 62 && ldexp(1.0, accBits) <= maxAcc) ++accBits;
+			int mantissaBits = std::min(30, std::max(1, 62 - accBits));
+
+			// Quantize each neuron's weights with its own scale, leaving missing connections as zero
+			layer.weights.assign(layer.neurons.size() * layer.rowLength, 0);
+			for (size_t neuronIdx = 0; neuronIdx < layer.neurons.size(); ++neuronIdx) {
+				struct fann_neuron *neuron = firstNeuron + layer.neurons[neuronIdx];
+				float maxWeight = 0;
+				for (unsigned int con = neuron->first_con; con != neuron->last_con; ++con) {
+					float weight = fabsf((float)ann->weights[con]);
+					if (weight > maxWeight) maxWeight = weight;
+				}
+				float weightScale = (maxWeight > 0) ? (maxWeight / maxQuantized) : 1.0f;
+				QType *row = &layer.weights[neuronIdx * layer.rowLength];
+				for (unsigned int con = neuron->first_con; con != neuron->last_con; ++con) {
+					unsigned int src = ann->connections[con] - firstNeuron;
+					row[src - srcBegin] = quantize((float)ann->weights[con] / weightScale);
+				}
+				for (size_t segmentIdx = 0; segmentIdx < layer.segments.size(); ++segmentIdx) {
+					double scale = (double)steepnesses[neuronIdx] * weightScale * segmentScales[segmentIdx] / tableStep * (1 << lutFractionBits);
+					int32_t multiplier;
+					uint8_t shift;
+					toFixedPointScale(scale, mantissaBits, multiplier, shift);
+					layer.multipliers.push_back(multiplier);
+					layer.shifts.push_back(shift);
+				}
+			}
+		}
+	}
+
+	void serialize(std::vector<char> &buffer) const {
+		ModelWriter writer(buffer);
+		for (size_t idx = 0; idx < sizeof(quantizedModelMagic); ++idx) writer.write(quantizedModelMagic[idx]);
+		writer.write((uint32_t)getBits());
+		writer.write((uint32_t)numInput);
+		writer.write((uint32_t)numOutput);
+		writer.write(totalNeurons);
+		writer.write(inputScale);
+		writer.write(outputScale);
+		writer.write(inputBiasValue);
+		writer.writeVector(inputBiasNeurons);
+		writer.write((uint32_t)layers.size());
+		for (size_t layerIdx = 0; layerIdx < layers.size(); ++layerIdx) {
+			const Layer &layer = layers[layerIdx];
+			writer.write(layer.srcBegin);
+			writer.write(layer.rowLength);
+			writer.writeVector(layer.neurons);
+			writer.writeVector(layer.biasNeurons);
+			writer.write(layer.biasValue);
+			writer.writeVector(layer.weights);
+			writer.writeVector(layer.segments);
+			writer.writeVector(layer.multipliers);
+			writer.writeVector(layer.shifts);
+			writer.writeVector(layer.tableIndices);
+			writer.write((uint32_t)layer.tables.size());
+			for (size_t tableIdx = 0; tableIdx < layer.tables.size(); ++tableIdx) {
+				writer.write(layer.tables[tableIdx].interpolate);
+				writer.writeVector(layer.tables[tableIdx].values);
+			}
+		}
+	}
+
+	// Reads the rest of a serialized model after its bits.  Checks every index, so a corrupt buffer can't
+	// make run() read out of bounds.
+	bool deserialize(ModelReader &reader) {
+		numInput = reader.read<uint32_t>();
+		numOutput = reader.read<uint32_t>();
+		totalNeurons = reader.read<uint32_t>();
+		inputScale = reader.read<float>();
+		outputScale = reader.read<float>();
+		inputBiasValue = reader.read<QType>();
+		reader.readVector(inputBiasNeurons);
+		uint32_t numLayers = reader.read<uint32_t>();
+		if (!reader.ok || numInput > totalNeurons || numLayers == 0 || numLayers > totalNeurons) return false;
+		for (size_t idx = 0; idx < inputBiasNeurons.size(); ++idx) {
+			if (inputBiasNeurons[idx] >= totalNeurons) return false;
+		}
+		layers.resize(numLayers);
+		for (size_t layerIdx = 0; layerIdx < numLayers; ++layerIdx) {
+			Layer &layer = layers[layerIdx];
+			layer.srcBegin = reader.read<uint32_t>();
+			layer.rowLength = reader.read<uint32_t>();
+			reader.readVector(layer.neurons);
+			reader.readVector(layer.biasNeurons);
+			layer.biasValue = reader.read<QType>();
+			reader.readVector(layer.weights);
+			reader.readVector(layer.segments);
+			reader.readVector(layer.multipliers);
+			reader.readVector(layer.shifts);
+			reader.readVector(layer.tableIndices);
+			uint32_t numTables = reader.read<uint32_t>();
+			if (!reader.ok || numTables > 256) return false;
+			layer.tables.resize(numTables);
+			for (size_t tableIdx = 0; tableIdx < numTables; ++tableIdx) {
+				layer.tables[tableIdx].interpolate = reader.read<uint8_t>();
+				reader.readVector(layer.tables[tableIdx].values);
+				if (layer.tables[tableIdx].values.size() != lutIntervals + 1) return false;
+			}
+			size_t numNeurons = layer.neurons.size();
+			if (
+				!reader.ok ||
+				layer.srcBegin > totalNeurons || layer.rowLength > totalNeurons - layer.srcBegin ||
+				layer.weights.size() != numNeurons * layer.rowLength ||
+				layer.multipliers.size() != numNeurons * layer.segments.size() ||
+				layer.shifts.size() != layer.multipliers.size() ||
+				layer.tableIndices.size() != numNeurons
+			) return false;
+			for (size_t idx = 0; idx < numNeurons; ++idx) {
+				if (layer.neurons[idx] >= totalNeurons || layer.tableIndices[idx] >= numTables) return false;
+			}
+			for (size_t idx = 0; idx < layer.biasNeurons.size(); ++idx) {
+				if (layer.biasNeurons[idx] >= totalNeurons) return false;
+			}
+			for (size_t idx = 0; idx < layer.segments.size(); ++idx) {
+				if (layer.segments[idx].begin > layer.segments[idx].end || layer.segments[idx].end > layer.rowLength) return false;
+			}
+			for (size_t idx = 0; idx < layer.shifts.size(); ++idx) {
+				if (layer.shifts[idx] > 62) return false;
+			}
+		}
+		return layers.back().neurons.size() == numOutput && reader.offset == reader.length;
+	}
+};
+
+typedef QuantizedModelImpl<int8_t, int32_t, 127, 64> QuantizedModel8;
+typedef QuantizedModelImpl<int16_t, int64_t, 32767, 1024> QuantizedModel16;
+
+QuantizedModel *QuantizedModel::create(struct fann *ann, struct fann_train_data *data, unsigned int bits) {
+	// Calibrate the range of each layer's outputs, and of the sums going into its activation functions, by
+	// running the float network over the data
+	unsigned int numLayers = ann->last_layer - ann->first_layer;
+	std::vector<float> maxActivations(numLayers, 0);
+	std::vector<float> maxSums(numLayers, 0);
+	for (unsigned int dataIdx = 0; dataIdx < data->num_data; ++dataIdx) {
+		fann_run(ann, data->input[dataIdx]);
+		for (unsigned int layerIdx = 0; layerIdx < numLayers; ++layerIdx) {
+			struct fann_layer *layer = ann->first_layer + layerIdx;
+			for (struct fann_neuron *neuronIt = layer->first_neuron; neuronIt != layer->last_neuron; ++neuronIt) {
+				float value = fabsf((float)neuronIt->value);
+				if (value > maxActivations[layerIdx]) maxActivations[layerIdx] = value;
+				if (layerIdx == 0 || neuronIt->first_con == neuronIt->last_con) continue;
+				float sum = fabsf((float)neuronIt->sum);
+				if (sum > maxSums[layerIdx]) maxSums[layerIdx] = sum;
+			}
+		}
+	}
+	int maxQuantized = (bits == 8) ? 127 : 32767;
+	std::vector<float> activationScales(numLayers);
+	for (unsigned int layerIdx = 0; layerIdx < numLayers; ++layerIdx) {
+		float maxActivation = (maxActivations[layerIdx] > 0) ? maxActivations[layerIdx] : 1.0f;
+		activationScales[layerIdx] = maxActivation / maxQuantized;
+	}
+
+	if (bits == 8) {
+		QuantizedModel8 *model = new QuantizedModel8();
+		model->build(ann, activationScales, maxSums);
+		return model;
+	} else if (bits == 16) {
+		QuantizedModel16 *model = new QuantizedModel16();
+		model->build(ann, activationScales, maxSums);
+		return model;
+	}
+	return NULL;
+}
+
+QuantizedModel *QuantizedModel::deserialize(const char *data, size_t length, std::string &errorMessage) {
+	ModelReader reader(data, length);
+	char magic[sizeof(quantizedModelMagic)];
+	for (size_t idx = 0; idx < sizeof(magic); ++idx) magic[idx] = reader.read<char>();
+	uint32_t bits = reader.read<uint32_t>();
+	if (!reader.ok || memcmp(magic, quantizedModelMagic, sizeof(magic)) != 0) {
+		errorMessage = "Not a quantized network";
+		return NULL;
+	}
+	QuantizedModel *model = NULL;
+	bool ok = false;
+	if (bits == 8) {
+		QuantizedModel8 *model8 = new QuantizedModel8();
+		model = model8;
+		ok = model8->deserialize(reader);
+	} else if (bits == 16) {
+		QuantizedModel16 *model16 = new QuantizedModel16();
+		model = model16;
+		ok = model16->deserialize(reader);
+	}
+	if (!ok) {
+		delete model;
+		errorMessage = "Quantized network is invalid or truncated";
+		return NULL;
+	}
+	return model;
+}
+
+void QuantizedModel::evaluate(struct fann *ann, struct fann_train_data *data, QuantizationReport &report) const {
+	std::vector<float> floatOutputs(numOutput);
+	std::vector<float> quantizedOutputs(numOutput);
+	double floatSquaredError = 0;
+	double quantizedSquaredError = 0;
+	double absDiffTotal = 0;
+	float maxAbsDiff = 0;
+	unsigned int argmaxMatches = 0;
+	for (unsigned int dataIdx = 0; dataIdx < data->num_data; ++dataIdx) {
+		fann_type *fannOutputs = fann_run(ann, data->input[dataIdx]);
+		for (unsigned int idx = 0; idx < numOutput; ++idx) floatOutputs[idx] = (float)fannOutputs[idx];
+		run(data->input[dataIdx], &quantizedOutputs[0]);
+		unsigned int floatArgmax = 0;
+		unsigned int quantizedArgmax = 0;
+		for (unsigned int idx = 0; idx < numOutput; ++idx) {
+			float desired = (float)data->output[dataIdx][idx];
+			floatSquaredError += (floatOutputs[idx] - desired) * (floatOutputs[idx] - desired);
+			quantizedSquaredError += (quantizedOutputs[idx] - desired) * (quantizedOutputs[idx] - desired);
+			float absDiff = fabsf(floatOutputs[idx] - quantizedOutputs[idx]);
+			absDiffTotal += absDiff;
+			if (absDiff > maxAbsDiff) maxAbsDiff = absDiff;
+			if (floatOutputs[idx] > floatOutputs[floatArgmax]) floatArgmax = idx;
+			if (quantizedOutputs[idx] > quantizedOutputs[quantizedArgmax]) quantizedArgmax = idx;
+		}
+		if (floatArgmax == quantizedArgmax) ++argmaxMatches;
+	}
+	double numValues = (double)data->num_data * numOutput;
+	if (numValues > 0) {
+		report.floatMSE = floatSquaredError / numValues;
+		report.quantizedMSE = quantizedSquaredError / numValues;
+		report.meanAbsDiff = absDiffTotal / numValues;
+		report.argmaxAgreement = (float)argmaxMatches / data->num_data;
+	}
+	report.maxAbsDiff = maxAbsDiff;
+	report.floatBytes = (size_t)ann->total_connections * sizeof(fann_type);
+	report.quantizedBytes = getMemoryUsage();
+}
+
+
+QuantizeWorker::QuantizeWorker(Nan::Callback *callback, v8::Local<v8::Object> fannyHolder, v8::Local<v8::Object> trainingDataHolder, unsigned int _bits) :
+	Nan::AsyncWorker(callback), bits(_bits), model(NULL)
+{
+	SaveToPersistent("fannyHolder", fannyHolder);
+	SaveToPersistent("tdHolder", trainingDataHolder);
+	ann = getFannStruct(Nan::ObjectWrap::Unwrap<FANNY>(fannyHolder)->fann);
+	data = getFannTrainDataStruct(Nan::ObjectWrap::Unwrap<TrainingData>(trainingDataHolder)->trainingData);
+}
+
+QuantizeWorker::~QuantizeWorker() {
+	if (model) delete model;
+}
+
+void QuantizeWorker::Execute() {
+	if (data->num_input != ann->num_input || data->num_output != ann->num_output) {
+		return SetErrorMessage("Calibration data does not match the network's inputs and outputs");
+	}
+	if (data->num_data == 0) return SetErrorMessage("Calibration data is empty");
+	model = QuantizedModel::create(ann, data, bits);
+	if (!model) return SetErrorMessage("Quantization bits must be 8 or 16");
+	model->evaluate(ann, data, report);
+}
+
+void QuantizeWorker::HandleOKCallback() {
+	Nan::HandleScope scope;
+	v8::Local<v8::Value> externModel = Nan::New<v8::External>(model);
+	v8::Local<v8::Function> ctor = Nan::New(QuantizedANN::constructorFunction);
+	v8::Local<v8::Value> ctorArgs[] = { externModel };
+	v8::Local<v8::Object> instance = Nan::NewInstance(ctor, 1, ctorArgs).ToLocalChecked();
+	// The QuantizedANN owns the model now
+	model = NULL;
+	v8::Local<v8::Value> args[] = { Nan::Null(), instance, QuantizedANN::reportToV8Object(report) };
+	callback->Call(3, args, async_resource);
+}
+
+
+void QuantizedANN::Init(v8::Local<v8::Object> target) {
+	v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(New);
+	tpl->SetClassName(Nan::New("QuantizedANN").ToLocalChecked());
+	tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+	Nan::SetPrototypeMethod(tpl, "run", run);
+	Nan::SetPrototypeMethod(tpl, "getNumInput", getNumInput);
+	Nan::SetPrototypeMethod(tpl, "getNumOutput", getNumOutput);
+	Nan::SetPrototypeMethod(tpl, "getBits", getBits);
+	Nan::SetPrototypeMethod(tpl, "getMemoryUsage", getMemoryUsage);
+	Nan::SetPrototypeMethod(tpl, "toBuffer", toBuffer);
+
+	constructorFunctionTpl.Reset(tpl);
+	v8::Local<v8::Function> ctorFunction = Nan::GetFunction(tpl).ToLocalChecked();
+	constructorFunction.Reset(ctorFunction);
+	Nan::Set(ctorFunction, Nan::New("loadBuffer").ToLocalChecked(), Nan::GetFunction(Nan::New<v8::FunctionTemplate>(loadBuffer)).ToLocalChecked());
+	Nan::Set(target, Nan::New("QuantizedANN").ToLocalChecked(), ctorFunction);
+}
+
+thread_local Nan::Persistent<v8::FunctionTemplate> QuantizedANN::constructorFunctionTpl;
+thread_local Nan::Persistent<v8::Function> QuantizedANN::constructorFunction;
+
+QuantizedANN::QuantizedANN(QuantizedModel *_model) : model(_model) {}
+
+QuantizedANN::~QuantizedANN() {
+	delete model;
+}
+
+NAN_METHOD(QuantizedANN::New) {
+	if (info.Length() != 1 || !info[0]->IsExternal()) {
+		return Nan::ThrowError("QuantizedANN can only be created with ANN quantize()");
+	}
+	QuantizedANN *obj = new QuantizedANN((QuantizedModel *)info[0].As<v8::External>()->Value());
+	obj->Wrap(info.This());
+	info.GetReturnValue().Set(info.This());
+}
+
+v8::Local<v8::Object> QuantizedANN::reportToV8Object(const QuantizationReport &report) {
+	Nan::EscapableHandleScope scope;
+	v8::Local<v8::Object> obj = Nan::New<v8::Object>();
+	Nan::Set(obj, Nan::New("floatMSE").ToLocalChecked(), Nan::New(report.floatMSE));
+	Nan::Set(obj, Nan::New("quantizedMSE").ToLocalChecked(), Nan::New(report.quantizedMSE));
+	Nan::Set(obj, Nan::New("maxAbsDiff").ToLocalChecked(), Nan::New(report.maxAbsDiff));
+	Nan::Set(obj, Nan::New("meanAbsDiff").ToLocalChecked(), Nan::New(report.meanAbsDiff));
+	Nan::Set(obj, Nan::New("argmaxAgreement").ToLocalChecked(), Nan::New(report.argmaxAgreement));
+	Nan::Set(obj, Nan::New("floatBytes").ToLocalChecked(), Nan::New((double)report.floatBytes));
+	Nan::Set(obj, Nan::New("quantizedBytes").ToLocalChecked(), Nan::New((double)report.quantizedBytes));
+	return scope.Escape(obj);
+}
+
+NAN_METHOD(QuantizedANN::run) {
+	QuantizedANN *quantized = Nan::ObjectWrap::Unwrap<QuantizedANN>(info.Holder());
+	if (info.Length() != 1) return Nan::ThrowError("Takes one argument");
+	if (!info[0]->IsArray()) return Nan::ThrowError("Must be array");
+	std::vector<fann_type> inputs = v8ArrayToFannData(info[0]);
+	if (inputs.size() != quantized->model->numInput) return Nan::ThrowError("Wrong number of inputs");
+	std::vector<float> outputs(quantized->model->numOutput);
+	quantized->model->run(&inputs[0], &outputs[0]);
+	v8::Local<v8::Array> outputArray = Nan::New<v8::Array>(outputs.size());
+	for (uint32_t idx = 0; idx < outputs.size(); ++idx) {
+		Nan::Set(outputArray, idx, Nan::New<v8::Number>(outputs[idx]));
+	}
+	info.GetReturnValue().Set(outputArray);
+}
+
+NAN_METHOD(QuantizedANN::getNumInput) {
+	QuantizedANN *quantized = Nan::ObjectWrap::Unwrap<QuantizedANN>(info.Holder());
+	info.GetReturnValue().Set(quantized->model->numInput);
+}
+
+NAN_METHOD(QuantizedANN::getNumOutput) {
+	QuantizedANN *quantized = Nan::ObjectWrap::Unwrap<QuantizedANN>(info.Holder());
+	info.GetReturnValue().Set(quantized->model->numOutput);
+}
+
+NAN_METHOD(QuantizedANN::getBits) {
+	QuantizedANN *quantized = Nan::ObjectWrap::Unwrap<QuantizedANN>(info.Holder());
+	info.GetReturnValue().Set(quantized->model->getBits());
+}
+
+NAN_METHOD(QuantizedANN::getMemoryUsage) {
+	QuantizedANN *quantized = Nan::ObjectWrap::Unwrap<QuantizedANN>(info.Holder());
+	info.GetReturnValue().Set((double)quantized->model->getMemoryUsage());
+}
+
+NAN_METHOD(QuantizedANN::toBuffer) {
+	QuantizedANN *quantized = Nan::ObjectWrap::Unwrap<QuantizedANN>(info.Holder());
+	std::vector<char> buffer;
+	quantized->model->serialize(buffer);
+	info.GetReturnValue().Set(Nan::CopyBuffer(&buffer[0], (uint32_t)buffer.size()).ToLocalChecked());
+}
+
+NAN_METHOD(QuantizedANN::loadBuffer) {
+	if (info.Length() != 1 || !node::Buffer::HasInstance(info[0])) return Nan::ThrowTypeError("Takes a Buffer");
+	std::string errorMessage;
+	QuantizedModel *model = QuantizedModel::deserialize(node::Buffer::Data(info[0]), node::Buffer::Length(info[0]), errorMessage);
+	if (!model) return Nan::ThrowError(errorMessage.c_str());
+	v8::Local<v8::Value> ctorArgs[] = { Nan::New<v8::External>(model) };
+	info.GetReturnValue().Set(Nan::NewInstance(Nan::New(constructorFunction), 1, ctorArgs).ToLocalChecked());
+}
+
+}
@@ -0,0 +1,105 @@
+#ifndef FANNY_QUANTIZED_H
+#define FANNY_QUANTIZED_H
+
+#include <nan.h>
+#include "fann-includes.h"
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+namespace fanny {
+
+// Accuracy of a quantized network compared to the float network it was built from,
+// measured over the calibration data
+class QuantizationReport {
+public:
+	QuantizationReport();
+	float floatMSE;
+	float quantizedMSE;
+	float maxAbsDiff;
+	float meanAbsDiff;
+	// Fraction of samples where both networks have the same highest output
+	float argmaxAgreement;
+	size_t floatBytes;
+	size_t quantizedBytes;
+};
+
+// Integer inference model built from a trained FANN network.  Weights are quantized per neuron and
+// neuron outputs are quantized per layer, using activation ranges calibrated on sample data.  Each
+// layer stores a dense row per neuron spanning the range of neurons it takes input from, so the dot
+// products are plain integer loops the compiler can vectorize.  Sums are requantized with fixed point
+// multipliers into a position in a small per-layer table of the activation function, which gives the
+// neuron's quantized output directly.  Only quantizing the inputs and dequantizing the outputs use
+// floating point.
+class QuantizedModel {
+public:
+	virtual ~QuantizedModel() {}
+	virtual void run(const fann_type *inputs, float *outputs) const = 0;
+	virtual size_t getMemoryUsage() const = 0;
+	virtual unsigned int getBits() const = 0;
+	unsigned int numInput;
+	unsigned int numOutput;
+
+	// Builds a model from the network, calibrating activation scales and the ranges of the activation
+	// tables on the training data.  Returns NULL if bits is not 8 or 16.
+	static QuantizedModel *create(struct fann *ann, struct fann_train_data *data, unsigned int bits);
+
+	// Binary format (native byte order), independent of the FANN datatype
+	virtual void serialize(std::vector<char> &buffer) const = 0;
+	// Returns NULL and sets errorMessage if the data isn't a valid serialized model
+	static QuantizedModel *deserialize(const char *data, size_t length, std::string &errorMessage);
+
+	// Runs the float and quantized networks over the data and compares them
+	void evaluate(struct fann *ann, struct fann_train_data *data, QuantizationReport &report) const;
+};
+
+class QuantizedANN : public Nan::ObjectWrap {
+
+public:
+	static void Init(v8::Local<v8::Object> target);
+
+	static thread_local Nan::Persistent<v8::FunctionTemplate> constructorFunctionTpl;
+	static thread_local Nan::Persistent<v8::Function> constructorFunction;
+
+	QuantizedModel *model;
+
+	// Converts a QuantizationReport to a JS object
+	static v8::Local<v8::Object> reportToV8Object(const QuantizationReport &report);
+
+private:
+	// Javascript Constructor.  Only constructed internally, with an External pointing to a QuantizedModel.
+	static NAN_METHOD(New);
+
+	explicit QuantizedANN(QuantizedModel *_model);
+	~QuantizedANN();
+
+	static NAN_METHOD(run);
+	static NAN_METHOD(getNumInput);
+	static NAN_METHOD(getNumOutput);
+	static NAN_METHOD(getBits);
+	static NAN_METHOD(getMemoryUsage);
+	// Serializes the model to a Buffer
+	static NAN_METHOD(toBuffer);
+	// Static; creates a QuantizedANN from a Buffer returned by toBuffer()
+	static NAN_METHOD(loadBuffer);
+};
+
+// Builds a QuantizedANN on a worker thread.  Calls back with the QuantizedANN and its QuantizationReport.
+class QuantizeWorker : public Nan::AsyncWorker {
+public:
+	QuantizeWorker(Nan::Callback *callback, v8::Local<v8::Object> fannyHolder, v8::Local<v8::Object> trainingDataHolder, unsigned int _bits);
+	~QuantizeWorker();
+
+	void Execute();
+	void HandleOKCallback();
+
+	struct fann *ann;
+	struct fann_train_data *data;
+	unsigned int bits;
+	QuantizedModel *model;
+	QuantizationReport report;
+};
+
+}
+
+#endif
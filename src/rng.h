@@ -0,0 +1,80 @@
+#ifndef FANNY_RNG_H
+#define FANNY_RNG_H
+
+#include <stdint.h>
+#include <random>
+
+namespace fanny {
+
+// Small seedable pseudo-random number generator (xoshiro256**, seeded through splitmix64), so that
+// stochastic operations can have their own reproducible streams instead of sharing the C library's rand().
+// Not thread safe; each thread or object should have its own.
+class Rng {
+public:
+	explicit Rng(uint64_t seedValue = 0) {
+		seed(seedValue);
+	}
+
+	void seed(uint64_t seedValue) {
+		for (int idx = 0; idx < 4; ++idx) {
+			seedValue += 0x9e3779b97f4a7c15ull;
+			uint64_t z = seedValue;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			state[idx] = z ^ (z >> 31);
+		}
+	}
+
+	uint64_t next() {
+		uint64_t result = rotl(state[1] * 5, 7) * 9;
+		uint64_t t = state[1] << 17;
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+		state[2] ^= t;
+		state[3] = rotl(state[3], 45);
+		return result;
+	}
+
+	// Uniform integer in [0, bound), without modulo bias
+	uint32_t below(uint32_t bound) {
+		uint64_t product = (next() >> 32) * bound;
+		uint32_t low = (uint32_t)product;
+		if (low < bound) {
+			uint32_t threshold = (uint32_t)-bound % bound;
+			while (low < threshold) {
+				product = (next() >> 32) * bound;
+				low = (uint32_t)product;
+			}
+		}
+		return (uint32_t)(product >> 32);
+	}
+
+	// Uniform double in [0, 1)
+	double uniform() {
+		return (double)(next() >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	// Starts an independent stream seeded from this one, for handing to another thread
+	Rng fork() {
+		return Rng(next());
+	}
+
+	// A seed from the system's entropy source, for generators that weren't given one
+	static uint64_t randomSeed() {
+		std::random_device device;
+		return ((uint64_t)device() << 32) ^ device();
+	}
+
+private:
+	static uint64_t rotl(uint64_t x, int k) {
+		return (x << k) | (x >> (64 - k));
+	}
+
+	uint64_t state[4];
+};
+
+}
+
+#endif
@@ -0,0 +1,147 @@
+#include "shared-ann.h"
+#include "fann-internals.h"
+#include "csr-net.h"
+#include "shortcut-net.h"
+#include "utils.h"
+#include <map>
+#include <mutex>
+
+namespace fanny {
+
+// Networks with a live handle buffer, by the address of the buffer's memory.  Shared by every isolate.
+// Never freed, since V8 can release backing stores after static destructors have run.
+static std::mutex &sharedNetsMutex = *new std::mutex();
+static std::map<const void *, SharedNet *> &sharedNets = *new std::map<const void *, SharedNet *>();
+
+SharedNet::SharedNet(struct fann *_ann) : ann(_ann), engine(NULL), handleKey(0) {
+	if (ann->network_type == FANN_NETTYPE_LAYER) {
+		engine = new CsrNet(ann);
+	} else {
+		engine = new ShortcutNet(ann);
+	}
+}
+
+SharedNet::~SharedNet() {
+	delete engine;
+	fann_destroy(ann);
+}
+
+bool SharedNet::canShare(struct fann *ann) {
+	#ifndef FANNY_FIXED
+	if (ann->network_type == FANN_NETTYPE_LAYER) return true;
+	return ShortcutNet(ann).valid;
+	#else
+	return false;
+	#endif
+}
+
+bool SharedNet::runRows(fann_type *inputs, unsigned int numRows, bool scale, fann_type *outputs) const {
+	return runEngineRows(ann, engine, inputs, numRows, scale, outputs);
+}
+
+#if V8_MAJOR_VERSION >= 8
+
+v8::Local<v8::SharedArrayBuffer> SharedNet::toSharedArrayBuffer() {
+	{
+		std::lock_guard<std::mutex> lock(sharedNetsMutex);
+		sharedNets[&handleKey] = this;
+	}
+	// The backing store is freed, on whichever thread drops the last reference, once no isolate uses it
+	std::shared_ptr<v8::BackingStore> backingStore = v8::SharedArrayBuffer::NewBackingStore(
+		&handleKey,
+		sizeof(handleKey),
+		[](void *data, size_t length, void *deleterData) {
+			{
+				std::lock_guard<std::mutex> lock(sharedNetsMutex);
+				sharedNets.erase(data);
+			}
+			delete (SharedNet *)deleterData;
+		},
+		this
+	);
+	return v8::SharedArrayBuffer::New(v8::Isolate::GetCurrent(), backingStore);
+}
+
+SharedNet *SharedNet::fromBackingStore(const std::shared_ptr<v8::BackingStore> &backingStore) {
+	std::lock_guard<std::mutex> lock(sharedNetsMutex);
+	std::map<const void *, SharedNet *>::iterator it = sharedNets.find(backingStore->Data());
+	return (it == sharedNets.end()) ? NULL : it->second;
+}
+
+#endif
+
+
+void SharedANN::Init(v8::Local<v8::Object> target) {
+	v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(New);
+	tpl->SetClassName(Nan::New("SharedANN").ToLocalChecked());
+	tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+	Nan::SetPrototypeMethod(tpl, "run", run);
+	Nan::SetPrototypeMethod(tpl, "runBatch", runBatch);
+	Nan::SetPrototypeMethod(tpl, "getNumInput", getNumInput);
+	Nan::SetPrototypeMethod(tpl, "getNumOutput", getNumOutput);
+
+	constructorFunctionTpl.Reset(tpl);
+	v8::Local<v8::Function> ctorFunction = Nan::GetFunction(tpl).ToLocalChecked();
+	constructorFunction.Reset(ctorFunction);
+	Nan::Set(target, Nan::New("SharedANN").ToLocalChecked(), ctorFunction);
+}
+
+thread_local Nan::Persistent<v8::FunctionTemplate> SharedANN::constructorFunctionTpl;
+thread_local Nan::Persistent<v8::Function> SharedANN::constructorFunction;
+
+SharedANN::SharedANN() : net(NULL) {}
+
+NAN_METHOD(SharedANN::New) {
+	#if V8_MAJOR_VERSION >= 8
+	if (info.Length() != 1 || !info[0]->IsSharedArrayBuffer()) {
+		return Nan::ThrowError("SharedANN must be created from the buffer returned by ANN share()");
+	}
+	std::shared_ptr<v8::BackingStore> backingStore = info[0].As<v8::SharedArrayBuffer>()->GetBackingStore();
+	SharedNet *net = SharedNet::fromBackingStore(backingStore);
+	if (!net) return Nan::ThrowError("Buffer is not a shared network of this datatype");
+	SharedANN *obj = new SharedANN();
+	obj->backingStore = backingStore;
+	obj->net = net;
+	obj->Wrap(info.This());
+	info.GetReturnValue().Set(info.This());
+	#else
+	Nan::ThrowError("Shared networks require a newer version of Node");
+	#endif
+}
+
+NAN_METHOD(SharedANN::run) {
+	SharedANN *shared = Nan::ObjectWrap::Unwrap<SharedANN>(info.Holder());
+	if (info.Length() < 1 || info.Length() > 2) return Nan::ThrowError("Takes one or two arguments");
+	if (!info[0]->IsArray()) return Nan::ThrowError("Must be array");
+	std::vector<fann_type> inputs = v8ArrayToFannData(info[0]);
+	if (inputs.size() != shared->net->ann->num_input) return Nan::ThrowError("Wrong number of inputs");
+	std::vector<fann_type> outputs(shared->net->ann->num_output);
+	if (!shared->net->runRows(&inputs[0], 1, info[1]->IsTrue(), &outputs[0])) return Nan::ThrowError("Network has no scaling parameters");
+	info.GetReturnValue().Set(runOutputsToV8(outputs, 1, outputs.size(), RUN_RESULT_ARRAY));
+}
+
+NAN_METHOD(SharedANN::runBatch) {
+	SharedANN *shared = Nan::ObjectWrap::Unwrap<SharedANN>(info.Holder());
+	if (info.Length() < 1 || info.Length() > 2) return Nan::ThrowError("Takes one or two arguments");
+	unsigned int numOutput = shared->net->ann->num_output;
+	std::vector<fann_type> inputs;
+	unsigned int numRows;
+	RunResultFormat format;
+	if (!v8ToInputRows(info[0], shared->net->ann->num_input, inputs, numRows, format)) return;
+	std::vector<fann_type> outputs((size_t)numRows * numOutput);
+	if (!shared->net->runRows(&inputs[0], numRows, info[1]->IsTrue(), &outputs[0])) return Nan::ThrowError("Network has no scaling parameters");
+	info.GetReturnValue().Set(runOutputsToV8(outputs, numRows, numOutput, format));
+}
+
+NAN_METHOD(SharedANN::getNumInput) {
+	SharedANN *shared = Nan::ObjectWrap::Unwrap<SharedANN>(info.Holder());
+	info.GetReturnValue().Set(shared->net->ann->num_input);
+}
+
+NAN_METHOD(SharedANN::getNumOutput) {
+	SharedANN *shared = Nan::ObjectWrap::Unwrap<SharedANN>(info.Holder());
+	info.GetReturnValue().Set(shared->net->ann->num_output);
+}
+
+}
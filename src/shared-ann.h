@@ -0,0 +1,80 @@
+#ifndef FANNY_SHARED_ANN_H
+#define FANNY_SHARED_ANN_H
+
+#include <nan.h>
+#include "fann-includes.h"
+#include "forward-engine.h"
+#include <memory>
+#include <vector>
+#include <stdint.h>
+
+namespace fanny {
+
+// Immutable copy of a network that can be run from several isolates (eg. worker threads) at once.
+// fann_run() stores neuron values in the network, so rows are run with a CSR or shortcut engine,
+// which keeps them in per-call scratch space instead.  Nothing writes to the network after it's
+// built.
+//
+// Isolates refer to a SharedNet through an opaque one-byte SharedArrayBuffer, which only identifies
+// the network and keeps it alive; the network's memory itself is never exposed to Javascript.  The
+// buffer's backing store is shared between isolates and owns the SharedNet, so the network is freed once
+// no isolate holds the buffer or a SharedANN built from it.
+class SharedNet {
+public:
+	// Takes ownership of ann
+	explicit SharedNet(struct fann *_ann);
+	~SharedNet();
+
+	struct fann *ann;
+	ForwardEngine *engine;
+	// Memory of the handle buffer, whose address identifies the network
+	uint8_t handleKey;
+
+	// Whether a network can be shared (a layered or valid shortcut network, in a float build)
+	static bool canShare(struct fann *ann);
+
+	// Runs rows of inputs as FANN::neural_net::run(), scaling them in place if scale is set.  Returns false
+	// if scaling was requested and the network has no scaling parameters.
+	bool runRows(fann_type *inputs, unsigned int numRows, bool scale, fann_type *outputs) const;
+
+	#if V8_MAJOR_VERSION >= 8
+	// Creates the handle buffer, which owns the network
+	v8::Local<v8::SharedArrayBuffer> toSharedArrayBuffer();
+	// Finds the network a backing store from toSharedArrayBuffer() belongs to, or NULL
+	static SharedNet *fromBackingStore(const std::shared_ptr<v8::BackingStore> &backingStore);
+	#endif
+};
+
+// Inference-only handle on a SharedNet in one isolate.  Created from the SharedArrayBuffer returned
+// by ANN share(), which can be posted to worker threads.
+class SharedANN : public Nan::ObjectWrap {
+
+public:
+	static void Init(v8::Local<v8::Object> target);
+
+	static thread_local Nan::Persistent<v8::FunctionTemplate> constructorFunctionTpl;
+	static thread_local Nan::Persistent<v8::Function> constructorFunction;
+
+	#if V8_MAJOR_VERSION >= 8
+	// Keeps the network alive for as long as this object is
+	std::shared_ptr<v8::BackingStore> backingStore;
+	#endif
+	SharedNet *net;
+
+private:
+	// Javascript Constructor.  Takes a SharedArrayBuffer from ANN share().
+	static NAN_METHOD(New);
+
+	SharedANN();
+
+	// Takes inputs and an optional scaling flag, as ANN run()
+	static NAN_METHOD(run);
+	// Takes a batch of inputs and an optional scaling flag, as ANN runBatch()
+	static NAN_METHOD(runBatch);
+	static NAN_METHOD(getNumInput);
+	static NAN_METHOD(getNumOutput);
+};
+
+}
+
+#endif
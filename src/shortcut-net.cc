@@ -0,0 +1,74 @@
+#include "shortcut-net.h"
+#include "activation.h"
+#include <algorithm>
+
+namespace fanny {
+
+// Dot product of two dense vectors.  Independent partial sums let the compiler keep several SIMD lanes
+// busy without reassociating floating point math itself.
+static inline fann_type dotProduct(const fann_type *a, const fann_type *b, unsigned int length) {
+	fann_type partial[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	unsigned int idx = 0;
+	for (; idx + 8 <= length; idx += 8) {
+		for (unsigned int lane = 0; lane < 8; ++lane) {
+			partial[lane] += a[idx + lane] * b[idx + lane];
+		}
+	}
+	fann_type sum = 0;
+	for (; idx < length; ++idx) sum += a[idx] * b[idx];
+	for (unsigned int lane = 0; lane < 8; ++lane) sum += partial[lane];
+	return sum;
+}
+
+ShortcutNet::ShortcutNet(struct fann *_ann) :
+	ann(_ann), weights(_ann->weights), totalConnections(_ann->total_connections), totalNeurons(_ann->total_neurons),
+	numInput(_ann->num_input), numOutput(_ann->num_output), valid(true)
+{
+	struct fann_neuron *firstNeuron = ann->first_layer->first_neuron;
+	firstOutputNeuron = (unsigned int)((ann->last_layer - 1)->first_neuron - firstNeuron);
+	// The input layer is the inputs and a single bias neuron
+	if (ann->first_layer->last_neuron - firstNeuron != (long)numInput + 1) valid = false;
+	for (struct fann_layer *layer = ann->first_layer + 1; layer != ann->last_layer && valid; ++layer) {
+		unsigned int prefixLength = (unsigned int)(layer->first_neuron - firstNeuron);
+		for (struct fann_neuron *neuron = layer->first_neuron; neuron != layer->last_neuron && valid; ++neuron) {
+			if (neuron->last_con - neuron->first_con != prefixLength) {
+				valid = false;
+				break;
+			}
+			for (unsigned int idx = 0; idx < prefixLength; ++idx) {
+				if (ann->connections[neuron->first_con + idx] != firstNeuron + idx) {
+					valid = false;
+					break;
+				}
+			}
+		}
+	}
+}
+
+bool ShortcutNet::isCurrent(struct fann *_ann) const {
+	return ann == _ann && weights == _ann->weights && totalConnections == _ann->total_connections && totalNeurons == _ann->total_neurons;
+}
+
+bool ShortcutNet::handles(struct fann *ann) {
+	#ifndef FANNY_FIXED
+	return ann->network_type == FANN_NETTYPE_SHORTCUT && ann->connection_rate >= 1;
+	#else
+	return false;
+	#endif
+}
+
+void ShortcutNet::run(const fann_type *input, fann_type *output, std::vector<fann_type> &scratch) const {
+	scratch.resize(totalNeurons);
+	fann_type *values = &scratch[0];
+	const fann_type *w = ann->weights;
+	struct fann_neuron *neuron = ann->first_layer->first_neuron + numInput + 1;
+	std::copy(input, input + numInput, values);
+	values[numInput] = 1;
+	for (unsigned int neuronIdx = numInput + 1; neuronIdx < totalNeurons; ++neuronIdx, ++neuron) {
+		fann_type sum = dotProduct(w + neuron->first_con, values, neuron->last_con - neuron->first_con);
+		values[neuronIdx] = activationFunction(neuron->activation_function, neuron->activation_steepness, sum);
+	}
+	std::copy(values + firstOutputNeuron, values + firstOutputNeuron + numOutput, output);
+}
+
+}
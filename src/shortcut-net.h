@@ -0,0 +1,39 @@
+#ifndef FANNY_SHORTCUT_NET_H
+#define FANNY_SHORTCUT_NET_H
+
+#include "fann-includes.h"
+#include "forward-engine.h"
+#include <vector>
+
+namespace fanny {
+
+// Forward engine for shortcut networks, including every network built by cascade training.  In these,
+// each neuron is connected to every neuron before its layer, in order, so its incoming weights are one
+// contiguous prefix that lines up with the neuron values computed so far.  Values are kept in a single
+// contiguous vector that grows as the network is evaluated, and each neuron is one dense dot product
+// over a prefix of it, instead of FANN's reads through the neuron structures.
+//
+// The prefix layout is checked when the engine is built; if a network doesn't have it, valid is false and
+// the network is left to fann_run().
+class ShortcutNet : public ForwardEngine {
+public:
+	ShortcutNet(struct fann *ann);
+	bool isCurrent(struct fann *ann) const;
+	void run(const fann_type *input, fann_type *output, std::vector<fann_type> &scratch) const;
+
+	// Whether the engine should be used for a network
+	static bool handles(struct fann *ann);
+
+	struct fann *ann;
+	fann_type *weights;
+	unsigned int totalConnections;
+	unsigned int totalNeurons;
+	unsigned int numInput;
+	unsigned int numOutput;
+	unsigned int firstOutputNeuron;
+	bool valid;
+};
+
+}
+
+#endif
@@ -0,0 +1,301 @@
+#include "sparse.h"
+#include "activation.h"
+#include "utils.h"
+#include <algorithm>
+#include <math.h>
+
+namespace fanny {
+
+// Reads an array or Uint32Array/Int32Array of indices
+static bool v8ToIndexArray(v8::Local<v8::Value> value, std::vector<unsigned int> &ret) {
+	if (value->IsUint32Array() || value->IsInt32Array()) {
+		Nan::TypedArrayContents<uint32_t> contents(value);
+		ret.assign(*contents, *contents + contents.length());
+		return true;
+	}
+	if (!value->IsArray()) return false;
+	v8::Local<v8::Array> array = value.As<v8::Array>();
+	uint32_t length = array->Length();
+	ret.resize(length);
+	for (uint32_t idx = 0; idx < length; ++idx) {
+		v8::Local<v8::Value> entry = Nan::Get(array, idx).ToLocalChecked();
+		if (!entry->IsNumber() || Nan::To<double>(entry).FromJust() < 0) return false;
+		ret[idx] = Nan::To<uint32_t>(entry).FromJust();
+	}
+	return true;
+}
+
+// Reads an array or typed array of values, which must have exactly length entries
+static bool v8ToValueArray(v8::Local<v8::Value> value, std::vector<fann_type> &ret, size_t length) {
+	if (value->IsTypedArray()) {
+		ret.resize(length);
+		return length == 0 ? value.As<v8::TypedArray>()->Length() == 0 : typedArrayToFannData(value, &ret[0], length);
+	}
+	if (!value->IsArray() || value.As<v8::Array>()->Length() != length) return false;
+	ret = v8ArrayToFannData(value);
+	return ret.size() == length;
+}
+
+bool SparseRows::fromV8(v8::Local<v8::Value> v8RowOffsets, v8::Local<v8::Value> v8Indices, v8::Local<v8::Value> v8Values, unsigned int _numInput) {
+	numInput = _numInput;
+	if (!v8ToIndexArray(v8RowOffsets, rowOffsets) || rowOffsets.size() < 2) {
+		Nan::ThrowTypeError("rowOffsets must be an array of at least two offsets");
+		return false;
+	}
+	if (!v8ToIndexArray(v8Indices, indices)) {
+		Nan::ThrowTypeError("indices must be an array of non-negative integers");
+		return false;
+	}
+	if (!v8ToValueArray(v8Values, values, indices.size())) {
+		Nan::ThrowTypeError("values must be an array with one number per index");
+		return false;
+	}
+	if (rowOffsets[0] != 0 || rowOffsets.back() != indices.size()) {
+		Nan::ThrowError("rowOffsets must start at 0 and end at the number of indices");
+		return false;
+	}
+	for (size_t idx = 1; idx < rowOffsets.size(); ++idx) {
+		if (rowOffsets[idx] < rowOffsets[idx - 1]) {
+			Nan::ThrowError("rowOffsets must not decrease");
+			return false;
+		}
+	}
+	for (size_t idx = 0; idx < indices.size(); ++idx) {
+		if (indices[idx] >= numInput) {
+			Nan::ThrowError("Input index out of range");
+			return false;
+		}
+	}
+	return true;
+}
+
+
+SparseNetPlan::SparseNetPlan(struct fann *_ann) :
+	ann(_ann), weights(_ann->weights), totalConnections(_ann->total_connections), totalNeurons(_ann->total_neurons),
+	numInput(_ann->num_input), numOutput(_ann->num_output)
+{
+	struct fann_neuron *firstNeuron = ann->first_layer->first_neuron;
+	firstOutputNeuron = (unsigned int)((ann->last_layer - 1)->first_neuron - firstNeuron);
+
+	// Count the connections in each group, then fill them in
+	inputOffsets.assign(numInput + 1, 0);
+	neuronOffsets.assign(totalNeurons + 1, 0);
+	for (struct fann_layer *layer = ann->first_layer + 1; layer != ann->last_layer; ++layer) {
+		layerBegins.push_back((unsigned int)(layer->first_neuron - firstNeuron));
+		layerEnds.push_back((unsigned int)(layer->last_neuron - firstNeuron));
+		for (struct fann_neuron *neuron = layer->first_neuron; neuron != layer->last_neuron; ++neuron) {
+			unsigned int neuronIdx = (unsigned int)(neuron - firstNeuron);
+			for (unsigned int con = neuron->first_con; con < neuron->last_con; ++con) {
+				unsigned int source = (unsigned int)(ann->connections[con] - firstNeuron);
+				if (source < numInput) inputOffsets[source + 1]++;
+				else neuronOffsets[neuronIdx + 1]++;
+			}
+		}
+	}
+	for (unsigned int idx = 0; idx < numInput; ++idx) inputOffsets[idx + 1] += inputOffsets[idx];
+	for (unsigned int idx = 0; idx < totalNeurons; ++idx) neuronOffsets[idx + 1] += neuronOffsets[idx];
+	inputTargets.resize(inputOffsets[numInput]);
+	inputConnections.resize(inputOffsets[numInput]);
+	neuronSources.resize(neuronOffsets[totalNeurons]);
+	neuronConnections.resize(neuronOffsets[totalNeurons]);
+	std::vector<unsigned int> inputCursors(inputOffsets.begin(), inputOffsets.end() - 1);
+	std::vector<unsigned int> neuronCursors(neuronOffsets.begin(), neuronOffsets.end() - 1);
+	for (struct fann_layer *layer = ann->first_layer + 1; layer != ann->last_layer; ++layer) {
+		for (struct fann_neuron *neuron = layer->first_neuron; neuron != layer->last_neuron; ++neuron) {
+			unsigned int neuronIdx = (unsigned int)(neuron - firstNeuron);
+			for (unsigned int con = neuron->first_con; con < neuron->last_con; ++con) {
+				unsigned int source = (unsigned int)(ann->connections[con] - firstNeuron);
+				if (source < numInput) {
+					inputTargets[inputCursors[source]] = neuronIdx;
+					inputConnections[inputCursors[source]++] = con;
+				} else {
+					neuronSources[neuronCursors[neuronIdx]] = source;
+					neuronConnections[neuronCursors[neuronIdx]++] = con;
+				}
+			}
+		}
+	}
+}
+
+bool SparseNetPlan::isCurrent(struct fann *_ann) const {
+	return ann == _ann && weights == _ann->weights && totalConnections == _ann->total_connections && totalNeurons == _ann->total_neurons;
+}
+
+void SparseNetPlan::forward(const unsigned int *indices, const fann_type *values, unsigned int numEntries, fann_type *neuronValues, fann_type *neuronSums) const {
+	const fann_type *w = ann->weights;
+	struct fann_neuron *firstNeuron = ann->first_layer->first_neuron;
+	std::fill(neuronSums + numInput, neuronSums + totalNeurons, (fann_type)0);
+	for (unsigned int entry = 0; entry < numEntries; ++entry) {
+		unsigned int input = indices[entry];
+		fann_type value = values[entry];
+		for (unsigned int col = inputOffsets[input]; col < inputOffsets[input + 1]; ++col) {
+			neuronSums[inputTargets[col]] += w[inputConnections[col]] * value;
+		}
+	}
+	// The input layer's bias neuron
+	neuronValues[numInput] = 1;
+	for (size_t layerIdx = 0; layerIdx < layerBegins.size(); ++layerIdx) {
+		for (unsigned int neuronIdx = layerBegins[layerIdx]; neuronIdx < layerEnds[layerIdx]; ++neuronIdx) {
+			struct fann_neuron &neuron = firstNeuron[neuronIdx];
+			if (neuron.first_con == neuron.last_con) {
+				// Bias neuron
+				neuronValues[neuronIdx] = 1;
+				continue;
+			}
+			fann_type sum = neuronSums[neuronIdx];
+			for (unsigned int con = neuronOffsets[neuronIdx]; con < neuronOffsets[neuronIdx + 1]; ++con) {
+				sum += w[neuronConnections[con]] * neuronValues[neuronSources[con]];
+			}
+			sum = activationSum(neuron.activation_steepness, sum);
+			neuronSums[neuronIdx] = sum;
+			neuronValues[neuronIdx] = activationOfSum(neuron.activation_function, sum);
+		}
+	}
+}
+
+// Activation functions whose output range is -1 to 1, for which FANN halves the error
+static bool isSymmetricActivation(enum fann_activationfunc_enum fn) {
+	switch (fn) {
+		case FANN_LINEAR_PIECE_SYMMETRIC:
+		case FANN_THRESHOLD_SYMMETRIC:
+		case FANN_SIGMOID_SYMMETRIC:
+		case FANN_SIGMOID_SYMMETRIC_STEPWISE:
+		case FANN_ELLIOT_SYMMETRIC:
+		case FANN_GAUSSIAN_SYMMETRIC:
+		case FANN_SIN_SYMMETRIC:
+		case FANN_COS_SYMMETRIC:
+			return true;
+		default:
+			return false;
+	}
+}
+
+float SparseNetPlan::trainEpoch(const SparseRows &inputs, const fann_type *outputs) {
+	std::vector<fann_type> neuronValues(totalNeurons), neuronSums(totalNeurons), errors(totalNeurons);
+	fann_type *w = ann->weights;
+	struct fann_neuron *firstNeuron = ann->first_layer->first_neuron;
+	fann_type learningRate = ann->learning_rate;
+	double mseSum = 0;
+	unsigned int bitFail = 0;
+	unsigned int numRows = inputs.numRows();
+	for (unsigned int row = 0; row < numRows; ++row) {
+		unsigned int entryBegin = inputs.rowOffsets[row];
+		unsigned int numEntries = inputs.rowOffsets[row + 1] - entryBegin;
+		const unsigned int *rowIndices = inputs.indices.data() + entryBegin;
+		const fann_type *rowValues = inputs.values.data() + entryBegin;
+		const fann_type *desired = outputs + (size_t)row * numOutput;
+		forward(rowIndices, rowValues, numEntries, &neuronValues[0], &neuronSums[0]);
+		std::fill(errors.begin(), errors.end(), (fann_type)0);
+
+		// Output errors, as in fann_compute_MSE()
+		for (unsigned int outputIdx = 0; outputIdx < numOutput; ++outputIdx) {
+			unsigned int neuronIdx = firstOutputNeuron + outputIdx;
+			struct fann_neuron &neuron = firstNeuron[neuronIdx];
+			fann_type diff = desired[outputIdx] - neuronValues[neuronIdx];
+			if (isSymmetricActivation(neuron.activation_function)) diff /= 2;
+			mseSum += (double)diff * diff;
+			if (fabs(diff) >= ann->bit_fail_limit) bitFail++;
+			if (ann->train_error_function == FANN_ERRORFUNC_TANH) {
+				if (diff < -.9999999) diff = -17;
+				else if (diff > .9999999) diff = 17;
+				else diff = (fann_type)log((1.0 + diff) / (1.0 - diff));
+			}
+			errors[neuronIdx] = activationDerived(neuron.activation_function, neuron.activation_steepness, neuronValues[neuronIdx], neuronSums[neuronIdx]) * diff;
+		}
+
+		// Propagate the errors back to the first hidden layer, as in fann_backpropagate_MSE()
+		for (size_t layerIdx = layerBegins.size() - 1; layerIdx > 0; --layerIdx) {
+			for (unsigned int neuronIdx = layerBegins[layerIdx]; neuronIdx < layerEnds[layerIdx]; ++neuronIdx) {
+				fann_type error = errors[neuronIdx];
+				for (unsigned int con = neuronOffsets[neuronIdx]; con < neuronOffsets[neuronIdx + 1]; ++con) {
+					errors[neuronSources[con]] += error * w[neuronConnections[con]];
+				}
+			}
+			for (unsigned int neuronIdx = layerBegins[layerIdx - 1]; neuronIdx < layerEnds[layerIdx - 1]; ++neuronIdx) {
+				struct fann_neuron &neuron = firstNeuron[neuronIdx];
+				errors[neuronIdx] *= activationDerived(neuron.activation_function, neuron.activation_steepness, neuronValues[neuronIdx], neuronSums[neuronIdx]);
+			}
+		}
+
+		// Update the weights, as in fann_update_weights().  Connections from zero inputs don't change.
+		for (size_t layerIdx = 0; layerIdx < layerBegins.size(); ++layerIdx) {
+			for (unsigned int neuronIdx = layerBegins[layerIdx]; neuronIdx < layerEnds[layerIdx]; ++neuronIdx) {
+				fann_type delta = errors[neuronIdx] * learningRate;
+				for (unsigned int con = neuronOffsets[neuronIdx]; con < neuronOffsets[neuronIdx + 1]; ++con) {
+					w[neuronConnections[con]] += delta * neuronValues[neuronSources[con]];
+				}
+			}
+		}
+		for (unsigned int entry = 0; entry < numEntries; ++entry) {
+			unsigned int input = rowIndices[entry];
+			fann_type scaledValue = rowValues[entry] * learningRate;
+			for (unsigned int col = inputOffsets[input]; col < inputOffsets[input + 1]; ++col) {
+				w[inputConnections[col]] += errors[inputTargets[col]] * scaledValue;
+			}
+		}
+	}
+	ann->MSE_value = (float)mseSum;
+	ann->num_MSE = numRows * numOutput;
+	ann->num_bit_fail = bitFail;
+	return ann->num_MSE ? ann->MSE_value / (float)ann->num_MSE : 0;
+}
+
+
+void SparseTrainingData::Init(v8::Local<v8::Object> target) {
+	v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(New);
+	tpl->SetClassName(Nan::New("SparseTrainingData").ToLocalChecked());
+	tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+	Nan::SetPrototypeMethod(tpl, "length", length);
+	Nan::SetPrototypeMethod(tpl, "numInput", numInput);
+	Nan::SetPrototypeMethod(tpl, "numOutput", numOutput);
+
+	constructorFunctionTpl.Reset(tpl);
+	Nan::Set(target, Nan::New("SparseTrainingData").ToLocalChecked(), Nan::GetFunction(tpl).ToLocalChecked());
+}
+
+thread_local Nan::Persistent<v8::FunctionTemplate> SparseTrainingData::constructorFunctionTpl;
+
+SparseTrainingData::SparseTrainingData() : outputSize(0) {}
+
+NAN_METHOD(SparseTrainingData::New) {
+	#ifndef FANNY_FIXED
+	if (!info.IsConstructCall()) return Nan::ThrowError("Must be called as constructor");
+	if (info.Length() != 6) return Nan::ThrowError("Takes numInput, numOutput, rowOffsets, indices, values and outputs");
+	if (!info[0]->IsNumber() || !info[1]->IsNumber()) return Nan::ThrowTypeError("numInput and numOutput must be numbers");
+	unsigned int numInput = Nan::To<uint32_t>(info[0]).FromJust();
+	unsigned int numOutput = Nan::To<uint32_t>(info[1]).FromJust();
+	if (numInput == 0 || numOutput == 0) return Nan::ThrowError("numInput and numOutput must be positive");
+	SparseTrainingData *obj = new SparseTrainingData();
+	if (!obj->inputs.fromV8(info[2], info[3], info[4], numInput)) {
+		delete obj;
+		return;
+	}
+	obj->outputSize = numOutput;
+	if (!v8ToValueArray(info[5], obj->outputs, (size_t)obj->inputs.numRows() * numOutput)) {
+		delete obj;
+		return Nan::ThrowError("outputs must have numOutput numbers per row");
+	}
+	obj->Wrap(info.This());
+	info.GetReturnValue().Set(info.This());
+	#else
+	Nan::ThrowError("Not supported for fixed FANN");
+	#endif
+}
+
+NAN_METHOD(SparseTrainingData::length) {
+	SparseTrainingData *data = Nan::ObjectWrap::Unwrap<SparseTrainingData>(info.Holder());
+	info.GetReturnValue().Set(data->inputs.numRows());
+}
+
+NAN_METHOD(SparseTrainingData::numInput) {
+	SparseTrainingData *data = Nan::ObjectWrap::Unwrap<SparseTrainingData>(info.Holder());
+	info.GetReturnValue().Set(data->inputs.numInput);
+}
+
+NAN_METHOD(SparseTrainingData::numOutput) {
+	SparseTrainingData *data = Nan::ObjectWrap::Unwrap<SparseTrainingData>(info.Holder());
+	info.GetReturnValue().Set(data->outputSize);
+}
+
+}
@@ -0,0 +1,94 @@
+#ifndef FANNY_SPARSE_H
+#define FANNY_SPARSE_H
+
+#include <nan.h>
+#include "fann-includes.h"
+#include <vector>
+
+namespace fanny {
+
+// Rows of sparse inputs in compressed sparse row form: the entries of row r are
+// indices/values[rowOffsets[r] .. rowOffsets[r + 1]).  Duplicate indices in a row are summed.
+class SparseRows {
+public:
+	SparseRows() : numInput(0) {}
+	unsigned int numInput;
+	std::vector<unsigned int> rowOffsets;
+	std::vector<unsigned int> indices;
+	std::vector<fann_type> values;
+
+	unsigned int numRows() const { return rowOffsets.empty() ? 0 : (unsigned int)rowOffsets.size() - 1; }
+
+	// Reads CSR arrays (arrays or typed arrays) from Javascript.  Throws a JS error and returns false
+	// if they're malformed or an index is out of range.
+	bool fromV8(v8::Local<v8::Value> v8RowOffsets, v8::Local<v8::Value> v8Indices, v8::Local<v8::Value> v8Values, unsigned int _numInput);
+};
+
+// Layout for running a network on sparse inputs without touching the connections from zero inputs.
+// The connections leaving each input neuron are grouped by input, so a row only visits the columns of
+// its non-zero entries, and the remaining connections are grouped by target neuron.  Only connection
+// indices are stored, so the plan stays valid while the weights are trained; it must be rebuilt if
+// the network's structure changes (see isCurrent()).
+class SparseNetPlan {
+public:
+	SparseNetPlan(struct fann *ann);
+	bool isCurrent(struct fann *ann) const;
+
+	struct fann *ann;
+	fann_type *weights;
+	unsigned int totalConnections;
+	unsigned int totalNeurons;
+	unsigned int numInput;
+	unsigned int numOutput;
+	unsigned int firstOutputNeuron;
+
+	// Connections from each input neuron: target neuron and connection index
+	std::vector<unsigned int> inputOffsets;
+	std::vector<unsigned int> inputTargets;
+	std::vector<unsigned int> inputConnections;
+	// Connections from other neurons (including the input bias) into each neuron: source neuron and connection index
+	std::vector<unsigned int> neuronOffsets;
+	std::vector<unsigned int> neuronSources;
+	std::vector<unsigned int> neuronConnections;
+	// Range of neuron indices in each layer after the input layer
+	std::vector<unsigned int> layerBegins;
+	std::vector<unsigned int> layerEnds;
+
+	// Runs the network on one sparse row.  neuronValues and neuronSums must hold totalNeurons entries;
+	// outputs are at neuronValues + firstOutputNeuron.  Values of the input neurons are not set.
+	void forward(const unsigned int *indices, const fann_type *values, unsigned int numEntries, fann_type *neuronValues, fann_type *neuronSums) const;
+
+	// One epoch of incremental backpropagation (FANN_TRAIN_INCREMENTAL with the network's learning rate
+	// and error function), only updating the weights of non-zero inputs.  Momentum is not applied, since it
+	// would move every weight.  Updates the network's MSE and bit fail count, and returns the MSE.
+	float trainEpoch(const SparseRows &inputs, const fann_type *outputs);
+};
+
+// Training data with sparse inputs and dense outputs, for SparseNetPlan::trainEpoch()
+class SparseTrainingData : public Nan::ObjectWrap {
+
+public:
+	static void Init(v8::Local<v8::Object> target);
+
+	static thread_local Nan::Persistent<v8::FunctionTemplate> constructorFunctionTpl;
+
+	SparseRows inputs;
+	// Rows of outputSize values, laid end to end
+	std::vector<fann_type> outputs;
+	unsigned int outputSize;
+
+private:
+	// Javascript Constructor.  Takes numInput, numOutput, rowOffsets, indices, values and outputs (a
+	// flat array or typed array of numOutput entries per row).
+	static NAN_METHOD(New);
+
+	SparseTrainingData();
+
+	static NAN_METHOD(length);
+	static NAN_METHOD(numInput);
+	static NAN_METHOD(numOutput);
+};
+
+}
+
+#endif
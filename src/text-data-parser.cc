@@ -0,0 +1,332 @@
+#include "text-data-parser.h"
+#include "train-data-blocks.h"
+#include <vector>
+#include <thread>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace fanny {
+
+static inline bool isSpace(char c) {
+	return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline bool isDigit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+// Parses a token that the fast paths can't handle exactly, with the C library
+static bool parseNumberSlow(const char *begin, const char *end, double &out) {
+	char buf[128];
+	size_t length = end - begin;
+	if (length >= sizeof(buf)) return false;
+	memcpy(buf, begin, length);
+	buf[length] = 0;
+	char *parseEnd;
+	out = strtod(buf, &parseEnd);
+	return parseEnd == buf + length;
+}
+
+static bool parseNumberSlow(const char *begin, const char *end, float &out) {
+	char buf[128];
+	size_t length = end - begin;
+	if (length >= sizeof(buf)) return false;
+	memcpy(buf, begin, length);
+	buf[length] = 0;
+	char *parseEnd;
+	out = strtof(buf, &parseEnd);
+	return parseEnd == buf + length;
+}
+
+static bool parseNumberSlow(const char *begin, const char *end, int &out) {
+	char buf[64];
+	size_t length = end - begin;
+	if (length >= sizeof(buf)) return false;
+	memcpy(buf, begin, length);
+	buf[length] = 0;
+	char *parseEnd;
+	out = (int)strtol(buf, &parseEnd, 10);
+	return parseEnd == buf + length;
+}
+
+// Limits of the exact fast path: the decimal mantissa and the power of ten must both be exactly
+// representable, so that one multiplication or division gives the correctly rounded result
+template<typename T> struct FastPathLimits;
+template<> struct FastPathLimits<double> {
+	static const uint64_t maxMantissa = (uint64_t)1 << 53;
+	static const int maxExponent = 22;
+};
+template<> struct FastPathLimits<float> {
+	static const uint64_t maxMantissa = (uint64_t)1 << 24;
+	static const int maxExponent = 10;
+};
+
+template<typename T>
+static T powerOfTen(int exponent) {
+	static const T powers[] = {
+		(T)1e0, (T)1e1, (T)1e2, (T)1e3, (T)1e4, (T)1e5, (T)1e6, (T)1e7, (T)1e8, (T)1e9, (T)1e10, (T)1e11,
+		(T)1e12, (T)1e13, (T)1e14, (T)1e15, (T)1e16, (T)1e17, (T)1e18, (T)1e19, (T)1e20, (T)1e21, (T)1e22
+	};
+	return powers[exponent];
+}
+
+// Parses the decimal number in [begin, end) (which contains no whitespace).  Plain decimals with a
+// short mantissa are converted directly (Clinger's fast path); anything else goes to the C library.
+template<typename T>
+static bool parseNumber(const char *begin, const char *end, T &out) {
+	const char *p = begin;
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool anyDigits = false;
+	bool inexact = false;
+	for (; p < end && isDigit(*p); ++p) {
+		anyDigits = true;
+		if (digits < 19) {
+			mantissa = mantissa * 10 + (*p - '0');
+			if (mantissa) digits++;
+		} else {
+			exponent++;
+			if (*p != '0') inexact = true;
+		}
+	}
+	if (p < end && *p == '.') {
+		for (++p; p < end && isDigit(*p); ++p) {
+			anyDigits = true;
+			if (digits < 19) {
+				mantissa = mantissa * 10 + (*p - '0');
+				if (mantissa) digits++;
+				exponent--;
+			} else if (*p != '0') {
+				inexact = true;
+			}
+		}
+	}
+	if (anyDigits && p < end && (*p == 'e' || *p == 'E')) {
+		++p;
+		bool negativeExponent = false;
+		if (p < end && (*p == '-' || *p == '+')) negativeExponent = (*p++ == '-');
+		if (p == end || !isDigit(*p)) return parseNumberSlow(begin, end, out);
+		int explicitExponent = 0;
+		for (; p < end && isDigit(*p); ++p) {
+			if (explicitExponent < 100000) explicitExponent = explicitExponent * 10 + (*p - '0');
+		}
+		exponent += negativeExponent ? -explicitExponent : explicitExponent;
+	}
+	if (!anyDigits || p != end || inexact) return parseNumberSlow(begin, end, out);
+	if (mantissa == 0) {
+		out = negative ? -(T)0 : (T)0;
+		return true;
+	}
+	if (mantissa > FastPathLimits<T>::maxMantissa || exponent < -FastPathLimits<T>::maxExponent || exponent > FastPathLimits<T>::maxExponent) {
+		return parseNumberSlow(begin, end, out);
+	}
+	T value = (T)mantissa;
+	if (exponent < 0) {
+		value /= powerOfTen<T>(-exponent);
+	} else {
+		value *= powerOfTen<T>(exponent);
+	}
+	out = negative ? -value : value;
+	return true;
+}
+
+// Fixed point data files contain plain integers
+template<>
+bool parseNumber<int>(const char *begin, const char *end, int &out) {
+	const char *p = begin;
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+	if (p == end || end - p > 9) return parseNumberSlow(begin, end, out);
+	int value = 0;
+	for (; p < end; ++p) {
+		if (!isDigit(*p)) return parseNumberSlow(begin, end, out);
+		value = value * 10 + (*p - '0');
+	}
+	out = negative ? -value : value;
+	return true;
+}
+
+// Reads an unsigned integer from the header, advancing pos
+static bool parseHeaderNumber(const char *data, size_t size, size_t &pos, unsigned int &out) {
+	while (pos < size && isSpace(data[pos])) ++pos;
+	size_t begin = pos;
+	uint64_t value = 0;
+	for (; pos < size && isDigit(data[pos]); ++pos) {
+		value = value * 10 + (data[pos] - '0');
+		if (value > 0xffffffffu) return false;
+	}
+	if (pos == begin || (pos < size && !isSpace(data[pos]))) return false;
+	out = (unsigned int)value;
+	return true;
+}
+
+// One thread's part of the file
+struct ParseChunk {
+	const char *begin;
+	const char *end;
+	size_t firstNumber;
+	size_t numNumbers;
+	bool failed;
+};
+
+static size_t countNumbers(const char *p, const char *end) {
+	size_t count = 0;
+	while (p < end) {
+		while (p < end && isSpace(*p)) ++p;
+		if (p == end) break;
+		++count;
+		while (p < end && !isSpace(*p)) ++p;
+	}
+	return count;
+}
+
+// Parses a chunk's numbers into their rows.  Numbers after the last row are ignored, as FANN does.
+static bool parseChunk(const ParseChunk &chunk, unsigned int numData, unsigned int numInput, unsigned int numOutput, fann_type *inputs, fann_type *outputs) {
+	size_t rowWidth = (size_t)numInput + numOutput;
+	size_t row = chunk.firstNumber / rowWidth;
+	size_t col = chunk.firstNumber % rowWidth;
+	const char *p = chunk.begin;
+	while (p < chunk.end && row < numData) {
+		while (p < chunk.end && isSpace(*p)) ++p;
+		if (p == chunk.end) break;
+		const char *tokenBegin = p;
+		while (p < chunk.end && !isSpace(*p)) ++p;
+		fann_type *dest = (col < numInput) ? &inputs[row * numInput + col] : &outputs[row * numOutput + (col - numInput)];
+		if (!parseNumber(tokenBegin, p, *dest)) return false;
+		if (++col == rowWidth) {
+			col = 0;
+			++row;
+		}
+	}
+	return true;
+}
+
+// Runs fn(chunkIdx) for every chunk, one thread per chunk
+template<typename Fn>
+static void forEachChunk(size_t numChunks, Fn fn) {
+	std::vector<std::thread> threads;
+	for (size_t chunkIdx = 1; chunkIdx < numChunks; ++chunkIdx) {
+		threads.push_back(std::thread(fn, chunkIdx));
+	}
+	fn(0);
+	for (size_t idx = 0; idx < threads.size(); ++idx) {
+		threads[idx].join();
+	}
+}
+
+// Parses the mapped file contents
+static struct fann_train_data *parseTrainText(const char *data, size_t size, unsigned int numThreads, std::string &error) {
+	size_t pos = 0;
+	unsigned int numData, numInput, numOutput;
+	if (
+		!parseHeaderNumber(data, size, pos, numData) ||
+		!parseHeaderNumber(data, size, pos, numInput) ||
+		!parseHeaderNumber(data, size, pos, numOutput)
+	) {
+		error = "Invalid training data file header";
+		return NULL;
+	}
+	if (numData == 0 || numInput == 0 || numOutput == 0) {
+		error = "Training data file is empty";
+		return NULL;
+	}
+	// The header comes straight from the file, so the number of values can't be trusted to fit
+	size_t rowWidth = (size_t)numInput + numOutput;
+	if (rowWidth > SIZE_MAX / numData) {
+		error = "Invalid training data file header";
+		return NULL;
+	}
+	size_t numValues = (size_t)numData * rowWidth;
+
+	// Split the body at whitespace into one chunk per thread
+	if (numThreads < 1) numThreads = 1;
+	size_t bodySize = size - pos;
+	if (numThreads > bodySize / 4096 + 1) numThreads = (unsigned int)(bodySize / 4096 + 1);
+	std::vector<ParseChunk> chunks;
+	const char *chunkBegin = data + pos;
+	const char *dataEnd = data + size;
+	for (unsigned int chunkIdx = 0; chunkIdx < numThreads; ++chunkIdx) {
+		const char *chunkEnd = (chunkIdx == numThreads - 1) ? dataEnd : data + pos + bodySize * (chunkIdx + 1) / numThreads;
+		if (chunkEnd < chunkBegin) chunkEnd = chunkBegin;
+		while (chunkEnd < dataEnd && !isSpace(*chunkEnd)) ++chunkEnd;
+		ParseChunk chunk = { chunkBegin, chunkEnd, 0, 0, false };
+		chunks.push_back(chunk);
+		chunkBegin = chunkEnd;
+	}
+
+	forEachChunk(chunks.size(), [&](size_t chunkIdx) {
+		chunks[chunkIdx].numNumbers = countNumbers(chunks[chunkIdx].begin, chunks[chunkIdx].end);
+	});
+	size_t totalNumbers = 0;
+	for (size_t chunkIdx = 0; chunkIdx < chunks.size(); ++chunkIdx) {
+		chunks[chunkIdx].firstNumber = totalNumbers;
+		totalNumbers += chunks[chunkIdx].numNumbers;
+	}
+	if (totalNumbers < numValues) {
+		error = "Training data file does not contain the number of values given in its header";
+		return NULL;
+	}
+
+	fann_type *inputs = allocTrainBlock((size_t)numData * numInput);
+	fann_type *outputs = allocTrainBlock((size_t)numData * numOutput);
+	if (!inputs || !outputs) {
+		free(inputs);
+		free(outputs);
+		error = "Could not allocate training data";
+		return NULL;
+	}
+	forEachChunk(chunks.size(), [&](size_t chunkIdx) {
+		chunks[chunkIdx].failed = !parseChunk(chunks[chunkIdx], numData, numInput, numOutput, inputs, outputs);
+	});
+	for (size_t chunkIdx = 0; chunkIdx < chunks.size(); ++chunkIdx) {
+		if (chunks[chunkIdx].failed) {
+			free(inputs);
+			free(outputs);
+			error = "Invalid number in training data file";
+			return NULL;
+		}
+	}
+
+	struct fann_train_data *trainData = createTrainDataFromBlocks(numData, numInput, numOutput, inputs, outputs);
+	if (!trainData) {
+		free(inputs);
+		free(outputs);
+		error = "Could not allocate training data";
+	}
+	return trainData;
+}
+
+struct fann_train_data *parseTrainFile(const std::string &filename, unsigned int numThreads, std::string &error) {
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		error = "Could not open training data file";
+		return NULL;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		error = "Could not read training data file";
+		return NULL;
+	}
+	size_t size = (size_t)st.st_size;
+	void *mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) {
+		error = "Could not map training data file";
+		return NULL;
+	}
+	madvise(mapped, size, MADV_SEQUENTIAL);
+	struct fann_train_data *trainData = parseTrainText((const char *)mapped, size, numThreads, error);
+	munmap(mapped, size);
+	return trainData;
+}
+
+}
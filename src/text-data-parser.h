@@ -0,0 +1,20 @@
+#ifndef FANNY_TEXT_DATA_PARSER_H
+#define FANNY_TEXT_DATA_PARSER_H
+
+#include "fann-includes.h"
+#include <string>
+
+namespace fanny {
+
+// Reads a training data file in FANN's text format (a "numData numInput numOutput" header followed by the
+// numbers of each row) on several threads.  The file is memory mapped and split into one chunk per thread
+// at whitespace.  Each thread counts the numbers in its chunk, which gives every chunk its position in the
+// data, and then parses them straight into the final contiguous input and output blocks.  Like FANN's
+// reader, any whitespace separates numbers, and anything after the last row is ignored.
+//
+// Returns NULL and sets error on failure.  The result is freed with fann_destroy_train().
+struct fann_train_data *parseTrainFile(const std::string &filename, unsigned int numThreads, std::string &error);
+
+}
+
+#endif
@@ -0,0 +1,133 @@
+#include "train-data-blocks.h"
+#include "fann-internals.h"
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace fanny {
+
+fann_type *allocTrainBlock(size_t numValues) {
+	void *block;
+	// posix_memalign() may return NULL for a size of 0, which callers would take as a failure
+	size_t size = numValues ? numValues * sizeof(fann_type) : TRAIN_BLOCK_ALIGNMENT;
+	if (posix_memalign(&block, TRAIN_BLOCK_ALIGNMENT, size) != 0) return NULL;
+	return (fann_type *)block;
+}
+
+fann_type *reallocTrainBlock(fann_type *block, size_t keepValues, size_t newValues) {
+	// realloc() doesn't preserve the alignment, so the values are moved by hand
+	fann_type *newBlock = allocTrainBlock(newValues);
+	if (!newBlock) return NULL;
+	if (block && keepValues) memcpy(newBlock, block, keepValues * sizeof(fann_type));
+	free(block);
+	return newBlock;
+}
+
+struct fann_train_data *createTrainDataFromBlocks(
+	unsigned int numData,
+	unsigned int numInput,
+	unsigned int numOutput,
+	fann_type *inputs,
+	fann_type *outputs
+) {
+	// fann_destroy_train() frees input[0] and output[0], so each block must be a single allocation
+	struct fann_train_data *data = (struct fann_train_data *)calloc(1, sizeof(struct fann_train_data));
+	fann_type **inputRows = (fann_type **)malloc(numData * sizeof(fann_type *));
+	fann_type **outputRows = (fann_type **)malloc(numData * sizeof(fann_type *));
+	if (!data || !inputRows || !outputRows) {
+		free(data);
+		free(inputRows);
+		free(outputRows);
+		return NULL;
+	}
+	for (size_t row = 0; row < numData; ++row) {
+		inputRows[row] = inputs + row * numInput;
+		outputRows[row] = outputs + row * numOutput;
+	}
+	fann_init_error_data((struct fann_error *)data);
+	data->num_data = numData;
+	data->num_input = numInput;
+	data->num_output = numOutput;
+	data->input = inputRows;
+	data->output = outputRows;
+	return data;
+}
+
+// Copies numRows rows of width values from rows[0 ..] into dest, one memcpy() per run of adjacent rows
+static void copyRows(fann_type *dest, fann_type * const *rows, unsigned int numRows, unsigned int width) {
+	unsigned int runStart = 0;
+	for (unsigned int row = 1; row <= numRows; ++row) {
+		if (row == numRows || rows[row] != rows[row - 1] + width) {
+			size_t numValues = (size_t)(row - runStart) * width;
+			memcpy(dest, rows[runStart], numValues * sizeof(fann_type));
+			dest += numValues;
+			runStart = row;
+		}
+	}
+}
+
+// Allocates blocks for numData rows and builds the structure around them
+static struct fann_train_data *allocTrainData(unsigned int numData, unsigned int numInput, unsigned int numOutput) {
+	fann_type *inputs = allocTrainBlock((size_t)numData * numInput);
+	fann_type *outputs = allocTrainBlock((size_t)numData * numOutput);
+	struct fann_train_data *data = (inputs && outputs) ? createTrainDataFromBlocks(numData, numInput, numOutput, inputs, outputs) : NULL;
+	if (!data) {
+		free(inputs);
+		free(outputs);
+	}
+	return data;
+}
+
+struct fann_train_data *createTrainDataFromValues(
+	unsigned int numData,
+	unsigned int numInput,
+	const fann_type *inputs,
+	unsigned int numOutput,
+	const fann_type *outputs
+) {
+	struct fann_train_data *data = allocTrainData(numData, numInput, numOutput);
+	if (!data) return NULL;
+	memcpy(data->input[0], inputs, (size_t)numData * numInput * sizeof(fann_type));
+	memcpy(data->output[0], outputs, (size_t)numData * numOutput * sizeof(fann_type));
+	return data;
+}
+
+struct fann_train_data *copyTrainData(const struct fann_train_data *data, unsigned int pos, unsigned int length) {
+	struct fann_train_data *copy = allocTrainData(length, data->num_input, data->num_output);
+	if (!copy) return NULL;
+	copyRows(copy->input[0], data->input + pos, length, data->num_input);
+	copyRows(copy->output[0], data->output + pos, length, data->num_output);
+	return copy;
+}
+
+struct fann_train_data *mergeTrainData(const struct fann_train_data *data1, const struct fann_train_data *data2) {
+	unsigned int numData = data1->num_data + data2->num_data;
+	struct fann_train_data *merged = allocTrainData(numData, data1->num_input, data1->num_output);
+	if (!merged) return NULL;
+	if (data1->num_data) {
+		copyRows(merged->input[0], data1->input, data1->num_data, data1->num_input);
+		copyRows(merged->output[0], data1->output, data1->num_data, data1->num_output);
+	}
+	if (data2->num_data) {
+		copyRows(merged->input[data1->num_data], data2->input, data2->num_data, data2->num_input);
+		copyRows(merged->output[data1->num_data], data2->output, data2->num_data, data2->num_output);
+	}
+	return merged;
+}
+
+struct fann_train_data *shuffleTrainData(const struct fann_train_data *data, Rng &rng) {
+	std::vector<fann_type *> inputRows(data->input, data->input + data->num_data);
+	std::vector<fann_type *> outputRows(data->output, data->output + data->num_data);
+	for (unsigned int row = data->num_data - 1; row > 0; --row) {
+		unsigned int other = rng.below(row + 1);
+		std::swap(inputRows[row], inputRows[other]);
+		std::swap(outputRows[row], outputRows[other]);
+	}
+	// A structure that only borrows the permuted pointers, to copy from
+	struct fann_train_data permuted = *data;
+	permuted.input = &inputRows[0];
+	permuted.output = &outputRows[0];
+	return copyTrainData(&permuted, 0, data->num_data);
+}
+
+}
@@ -0,0 +1,64 @@
+#ifndef FANNY_TRAIN_DATA_BLOCKS_H
+#define FANNY_TRAIN_DATA_BLOCKS_H
+
+#include "fann-includes.h"
+#include "rng.h"
+#include <stddef.h>
+
+namespace fanny {
+
+// Training data is kept in FANN's own layout: one contiguous block of inputs and one of outputs, with the
+// row pointers in fann_train_data::input/output pointing into them.  The functions here allocate the
+// blocks aligned to a cache line, and move rows between them with memcpy().
+
+// Alignment of training data blocks, in bytes
+const size_t TRAIN_BLOCK_ALIGNMENT = 64;
+
+// Allocates a block of numValues values aligned to TRAIN_BLOCK_ALIGNMENT.  The block is freed with free(),
+// as fann_destroy_train() does.  Returns NULL if memory couldn't be allocated.
+fann_type *allocTrainBlock(size_t numValues);
+
+// Moves a block to a new allocation of newValues values, keeping the first keepValues.  The old block is
+// freed on success and kept on failure (returning NULL).
+fann_type *reallocTrainBlock(fann_type *block, size_t keepValues, size_t newValues);
+
+// Builds the structure fann_create_train() would, around contiguous blocks of numData rows of inputs and
+// outputs.  numData must be positive, since fann_destroy_train() always frees input[0] and output[0].
+// The structure takes ownership of the blocks: fann_destroy_train() frees them.  Returns NULL
+// (leaving the blocks to the caller) if memory couldn't be allocated.
+struct fann_train_data *createTrainDataFromBlocks(
+	unsigned int numData,
+	unsigned int numInput,
+	unsigned int numOutput,
+	fann_type *inputs,
+	fann_type *outputs
+);
+
+// Copies numData rows of inputs and outputs, each laid end to end, into new training data.  numData must be
+// positive.  Returns NULL if memory couldn't be allocated.
+struct fann_train_data *createTrainDataFromValues(
+	unsigned int numData,
+	unsigned int numInput,
+	const fann_type *inputs,
+	unsigned int numOutput,
+	const fann_type *outputs
+);
+
+// Copies rows pos .. pos + length of a data set into new training data.  length must be positive and the
+// rows must exist.  Rows that are adjacent in the
+// source are copied together, so data in a single block is copied with one memcpy() per side.  Returns
+// NULL if memory couldn't be allocated.
+struct fann_train_data *copyTrainData(const struct fann_train_data *data, unsigned int pos, unsigned int length);
+
+// Concatenates two non-empty data sets with the same number of inputs and outputs.  Returns NULL if memory couldn't
+// be allocated.
+struct fann_train_data *mergeTrainData(const struct fann_train_data *data1, const struct fann_train_data *data2);
+
+// Shuffles the rows of a data set into new training data.  The permutation is applied to copies of the
+// row pointer arrays, and the rows are then gathered with one memcpy() each, so no values are swapped and
+// the result is contiguous.  The data set must be non-empty.  Returns NULL if memory couldn't be allocated.
+struct fann_train_data *shuffleTrainData(const struct fann_train_data *data, Rng &rng);
+
+}
+
+#endif
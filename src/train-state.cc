@@ -0,0 +1,390 @@
+#include "train-state.h"
+#include "fann-internals.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace fanny {
+
+static const char trainStateMagic[8] = { 'F', 'A', 'N', 'N', 'Y', 'T', 'S', '2' };
+
+#if defined(FANNY_FIXED)
+static const uint32_t trainStateDatatype = 2;
+#elif defined(FANNY_DOUBLE)
+static const uint32_t trainStateDatatype = 1;
+#else
+static const uint32_t trainStateDatatype = 0;
+#endif
+
+// Bits in the header's array flags
+enum {
+	TRAIN_STATE_TRAIN_SLOPES = 1,
+	TRAIN_STATE_PREV_STEPS = 2,
+	TRAIN_STATE_PREV_TRAIN_SLOPES = 4,
+	TRAIN_STATE_PREV_WEIGHTS_DELTAS = 8
+};
+
+struct TrainStateHeader {
+	char magic[8];
+	uint32_t datatype;
+	uint32_t fannTypeSize;
+	uint32_t epochs;
+	float mse;
+	uint32_t totalConnections;
+	uint32_t arrayFlags;
+	uint32_t trainingAlgorithm;
+	uint32_t reserved;
+	uint64_t weightsHash;
+};
+
+static void captureArray(std::vector<fann_type> &dest, const fann_type *src, unsigned int length) {
+	if (src) {
+		dest.assign(src, src + length);
+	} else {
+		dest.clear();
+	}
+}
+
+// Allocates the array if the network doesn't have it yet.  The array is only stored by applyArray().
+static bool allocArray(fann_type *dest, fann_type **allocated, const std::vector<fann_type> &src, struct fann *ann) {
+	*allocated = NULL;
+	if (src.empty() || dest) return true;
+	*allocated = (fann_type *)calloc(ann->total_connections_allocated, sizeof(fann_type));
+	return *allocated != NULL;
+}
+
+static void applyArray(fann_type **dest, fann_type *allocated, const std::vector<fann_type> &src) {
+	if (src.empty()) {
+		if (*dest) free(*dest);
+		*dest = NULL;
+		return;
+	}
+	if (allocated) *dest = allocated;
+	memcpy(*dest, &src[0], src.size() * sizeof(fann_type));
+}
+
+TrainState::TrainState() : epochs(0), mse(0), totalConnections(0), trainingAlgorithm(0), weightsHash(0) {}
+
+void TrainState::capture(struct fann *ann) {
+	totalConnections = ann->total_connections;
+	trainingAlgorithm = (unsigned int)ann->training_algorithm;
+	weightsHash = hashWeights(ann);
+	captureArray(trainSlopes, ann->train_slopes, totalConnections);
+	captureArray(prevSteps, ann->prev_steps, totalConnections);
+	captureArray(prevTrainSlopes, ann->prev_train_slopes, totalConnections);
+	captureArray(prevWeightsDeltas, ann->prev_weights_deltas, totalConnections);
+}
+
+bool TrainState::apply(struct fann *ann, std::string &errorMessage) const {
+	if (totalConnections != ann->total_connections) {
+		errorMessage = "Training state does not match the number of connections in the network";
+		return false;
+	}
+	if (trainingAlgorithm != (unsigned int)ann->training_algorithm) {
+		errorMessage = "Training state was captured with a different training algorithm";
+		return false;
+	}
+	// Allocate everything first, so the network is left untouched on failure
+	fann_type **dests[] = { &ann->train_slopes, &ann->prev_steps, &ann->prev_train_slopes, &ann->prev_weights_deltas };
+	const std::vector<fann_type> *arrays[] = { &trainSlopes, &prevSteps, &prevTrainSlopes, &prevWeightsDeltas };
+	fann_type *allocated[4];
+	for (int idx = 0; idx < 4; ++idx) {
+		if (!allocArray(*dests[idx], &allocated[idx], *arrays[idx], ann)) {
+			for (int freeIdx = 0; freeIdx < idx; ++freeIdx) free(allocated[freeIdx]);
+			errorMessage = "Could not allocate training state";
+			return false;
+		}
+	}
+	for (int idx = 0; idx < 4; ++idx) {
+		applyArray(dests[idx], allocated[idx], *arrays[idx]);
+	}
+	return true;
+}
+
+bool TrainState::matches(struct fann *ann) const {
+	return totalConnections == ann->total_connections && weightsHash == hashWeights(ann);
+}
+
+uint64_t TrainState::hashWeights(struct fann *ann) {
+	// 64-bit FNV-1a over the raw weight bytes
+	uint64_t hash = 14695981039346656037ULL;
+	const unsigned char *bytes = (const unsigned char *)ann->weights;
+	size_t length = (size_t)ann->total_connections * sizeof(fann_type);
+	for (size_t idx = 0; idx < length; ++idx) {
+		hash ^= bytes[idx];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+std::string TrainState::sidecarFilename(const std::string &networkFilename) {
+	return networkFilename + ".state";
+}
+
+void TrainState::serialize(std::vector<char> &buffer) const {
+	TrainStateHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, trainStateMagic, sizeof(trainStateMagic));
+	header.datatype = trainStateDatatype;
+	header.fannTypeSize = sizeof(fann_type);
+	header.epochs = epochs;
+	header.mse = mse;
+	header.totalConnections = totalConnections;
+	header.trainingAlgorithm = trainingAlgorithm;
+	header.weightsHash = weightsHash;
+	const std::vector<fann_type> *arrays[] = { &trainSlopes, &prevSteps, &prevTrainSlopes, &prevWeightsDeltas };
+	size_t arrayBytes = (size_t)totalConnections * sizeof(fann_type);
+	size_t numArrays = 0;
+	for (int idx = 0; idx < 4; ++idx) {
+		if (!arrays[idx]->empty()) {
+			header.arrayFlags |= (1 << idx);
+			++numArrays;
+		}
+	}
+	buffer.resize(sizeof(header) + numArrays * arrayBytes);
+	memcpy(&buffer[0], &header, sizeof(header));
+	size_t offset = sizeof(header);
+	for (int idx = 0; idx < 4; ++idx) {
+		if (!arrays[idx]->empty()) {
+			memcpy(&buffer[offset], &(*arrays[idx])[0], arrayBytes);
+			offset += arrayBytes;
+		}
+	}
+}
+
+bool TrainState::deserialize(const char *data, size_t length, std::string &errorMessage) {
+	TrainStateHeader header;
+	if (length < sizeof(header)) {
+		errorMessage = "Training state is truncated";
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, trainStateMagic, sizeof(trainStateMagic))) {
+		errorMessage = "Not a training state";
+		return false;
+	}
+	if (header.datatype != trainStateDatatype || header.fannTypeSize != sizeof(fann_type)) {
+		errorMessage = "Training state was saved with a different datatype";
+		return false;
+	}
+	std::vector<fann_type> *arrays[] = { &trainSlopes, &prevSteps, &prevTrainSlopes, &prevWeightsDeltas };
+	size_t arrayBytes = (size_t)header.totalConnections * sizeof(fann_type);
+	size_t offset = sizeof(header);
+	for (int idx = 0; idx < 4; ++idx) {
+		if (header.arrayFlags & (1 << idx)) {
+			if (length - offset < arrayBytes) {
+				errorMessage = "Training state is truncated";
+				return false;
+			}
+			arrays[idx]->resize(header.totalConnections);
+			memcpy(&(*arrays[idx])[0], data + offset, arrayBytes);
+			offset += arrayBytes;
+		} else {
+			arrays[idx]->clear();
+		}
+	}
+	epochs = header.epochs;
+	mse = header.mse;
+	totalConnections = header.totalConnections;
+	trainingAlgorithm = header.trainingAlgorithm;
+	weightsHash = header.weightsHash;
+	return true;
+}
+
+bool TrainState::saveToFile(const std::string &filename, std::string &errorMessage) const {
+	std::vector<char> buffer;
+	serialize(buffer);
+	FILE *file = fopen(filename.c_str(), "wb");
+	if (!file) {
+		errorMessage = "Could not open training state file for writing";
+		return false;
+	}
+	bool ok = fwrite(&buffer[0], 1, buffer.size(), file) == buffer.size();
+	if (fclose(file) != 0) ok = false;
+	if (!ok) errorMessage = "Error writing training state file";
+	return ok;
+}
+
+bool TrainState::loadFromFile(const std::string &filename, std::string &errorMessage) {
+	FILE *file = fopen(filename.c_str(), "rb");
+	if (!file) {
+		errorMessage = "Could not open training state file";
+		return false;
+	}
+	std::vector<char> buffer;
+	char chunk[65536];
+	size_t numRead;
+	while ((numRead = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+		buffer.insert(buffer.end(), chunk, chunk + numRead);
+	}
+	bool readError = ferror(file) != 0;
+	fclose(file);
+	if (readError) {
+		errorMessage = "Error reading training state file";
+		return false;
+	}
+	if (buffer.empty()) {
+		errorMessage = "Training state is truncated";
+		return false;
+	}
+	return deserialize(&buffer[0], buffer.size(), errorMessage);
+}
+
+
+Checkpointer::Checkpoint::Checkpoint() : ann(NULL) {}
+
+Checkpointer::Checkpoint::~Checkpoint() {
+	if (ann) fann_destroy(ann);
+}
+
+Checkpointer::Checkpointer(unsigned int _everyEpochs, double _everySeconds, std::string _filename, unsigned int _ringSize) :
+	everyEpochs(_everyEpochs), everySeconds(_everySeconds), filename(_filename), ringSize(_ringSize),
+	lastEpochs(0), lastTime(std::chrono::steady_clock::now()), pending(NULL), writing(false), stopping(false)
+{
+	if (ringSize < 1) ringSize = 1;
+	if (!filename.empty()) {
+		writerThread = std::thread(&Checkpointer::writerMain, this);
+	}
+}
+
+Checkpointer::~Checkpointer() {
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		stopping = true;
+		cond.notify_all();
+	}
+	// The writer finishes the checkpoint in progress (and any pending one) before exiting
+	if (writerThread.joinable()) writerThread.join();
+	if (pending) delete pending;
+	for (size_t idx = 0; idx < ring.size(); ++idx) delete ring[idx];
+}
+
+void Checkpointer::start() {
+	lastEpochs = 0;
+	lastTime = std::chrono::steady_clock::now();
+}
+
+void Checkpointer::disable() {
+	everyEpochs = 0;
+	everySeconds = 0;
+}
+
+void Checkpointer::update(struct fann *ann, unsigned int epochs, float mse) {
+	bool due = false;
+	if (everyEpochs && epochs >= lastEpochs + everyEpochs) due = true;
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (everySeconds > 0 && std::chrono::duration<double>(now - lastTime).count() >= everySeconds) due = true;
+	if (!due) return;
+	lastEpochs = epochs;
+	lastTime = now;
+
+	// Copying the network is the only work done on the training thread
+	Checkpoint *checkpoint = new Checkpoint();
+	checkpoint->ann = fann_copy(ann);
+	if (!checkpoint->ann) {
+		delete checkpoint;
+		return;
+	}
+	// The copy must not share the C++ wrapper's callback context
+	fann_set_callback(checkpoint->ann, NULL);
+	fann_set_user_data(checkpoint->ann, NULL);
+	checkpoint->state.capture(ann);
+	checkpoint->state.epochs = epochs;
+	checkpoint->state.mse = mse;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	if (filename.empty()) {
+		ring.push_back(checkpoint);
+		while (ring.size() > ringSize) {
+			delete ring.front();
+			ring.pop_front();
+		}
+	} else {
+		// If the writer hasn't caught up yet, the older pending checkpoint is superseded
+		if (pending) delete pending;
+		pending = checkpoint;
+		cond.notify_all();
+	}
+}
+
+bool Checkpointer::flush(std::string &errorMessage) {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (pending || writing) cond.wait(lock);
+	if (!writeError.empty()) {
+		errorMessage = writeError;
+		writeError.clear();
+		return false;
+	}
+	return true;
+}
+
+void Checkpointer::writerMain() {
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		while (!pending && !stopping) cond.wait(lock);
+		if (!pending) break;
+		Checkpoint *checkpoint = pending;
+		pending = NULL;
+		writing = true;
+		lock.unlock();
+		std::string errorMessage;
+		bool ok = writeCheckpoint(checkpoint, errorMessage);
+		delete checkpoint;
+		lock.lock();
+		writing = false;
+		if (!ok) writeError = errorMessage;
+		cond.notify_all();
+	}
+}
+
+bool Checkpointer::writeCheckpoint(Checkpoint *checkpoint, std::string &errorMessage) {
+	// Write to temporary files and rename them over the previous checkpoint, so a crash mid-write
+	// never leaves a partial file behind.  The state is renamed last; if a crash happens between
+	// the two renames, the weights hash identifies the state file as stale.
+	std::string tmpFilename = filename + ".tmp";
+	if (fann_save(checkpoint->ann, tmpFilename.c_str()) != 0) {
+		errorMessage = "Error writing checkpoint file";
+		return false;
+	}
+	if (rename(tmpFilename.c_str(), filename.c_str()) != 0) {
+		errorMessage = "Error renaming checkpoint file";
+		return false;
+	}
+	std::string stateFilename = TrainState::sidecarFilename(filename);
+	std::string tmpStateFilename = stateFilename + ".tmp";
+	if (!checkpoint->state.saveToFile(tmpStateFilename, errorMessage)) return false;
+	if (rename(tmpStateFilename.c_str(), stateFilename.c_str()) != 0) {
+		errorMessage = "Error renaming checkpoint state file";
+		return false;
+	}
+	return true;
+}
+
+size_t Checkpointer::getNumCheckpoints() {
+	std::unique_lock<std::mutex> lock(mutex);
+	return ring.size();
+}
+
+bool Checkpointer::getCheckpointInfo(size_t idx, unsigned int &epochs, float &mse) {
+	std::unique_lock<std::mutex> lock(mutex);
+	if (idx >= ring.size()) return false;
+	epochs = ring[idx]->state.epochs;
+	mse = ring[idx]->state.mse;
+	return true;
+}
+
+FANN::neural_net *Checkpointer::restoreCheckpoint(size_t idx, std::string &errorMessage) {
+	std::unique_lock<std::mutex> lock(mutex);
+	if (idx >= ring.size()) {
+		errorMessage = "No such checkpoint";
+		return NULL;
+	}
+	FANN::neural_net *fann = new FANN::neural_net(ring[idx]->ann);
+	if (!ring[idx]->state.apply(getFannStruct(fann), errorMessage)) {
+		delete fann;
+		return NULL;
+	}
+	return fann;
+}
+
+}
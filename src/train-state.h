@@ -0,0 +1,119 @@
+#ifndef FANNY_TRAIN_STATE_H
+#define FANNY_TRAIN_STATE_H
+
+#include "fann-includes.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <stdint.h>
+
+namespace fanny {
+
+// Snapshot of the optimizer state FANN keeps next to the weights while training: the
+// RPROP step sizes, the accumulated and previous slopes, and the Quickprop/momentum deltas.
+// None of these are stored in a FANN network file, so they're captured and serialized here.
+class TrainState {
+public:
+	TrainState();
+
+	// Progress at the time of a checkpoint.  Only set for checkpoints, so state exported from a network
+	// round trips exactly.
+	unsigned int epochs;
+	float mse;
+	unsigned int totalConnections;
+	// The network's fann_train_enum, since the arrays mean different things to each algorithm
+	unsigned int trainingAlgorithm;
+	// Hash of the network weights at capture time, used to detect state that belongs to a different network
+	uint64_t weightsHash;
+	std::vector<fann_type> trainSlopes;
+	std::vector<fann_type> prevSteps;
+	std::vector<fann_type> prevTrainSlopes;
+	std::vector<fann_type> prevWeightsDeltas;
+
+	// Copies the training arrays out of the network.  Arrays FANN hasn't allocated yet are left empty.
+	void capture(struct fann *ann);
+
+	// Copies the training arrays into the network, allocating them as needed.  Empty arrays are
+	// released so FANN reinitializes them lazily.  Returns false, leaving the network unchanged, if the
+	// state doesn't fit the network's connections or training algorithm.
+	bool apply(struct fann *ann, std::string &errorMessage) const;
+
+	// Returns true if this state was captured from a network with exactly these weights
+	bool matches(struct fann *ann) const;
+
+	// Binary format (native byte order): header followed by each present array
+	void serialize(std::vector<char> &buffer) const;
+	bool deserialize(const char *data, size_t length, std::string &errorMessage);
+	bool saveToFile(const std::string &filename, std::string &errorMessage) const;
+	bool loadFromFile(const std::string &filename, std::string &errorMessage);
+
+	static uint64_t hashWeights(struct fann *ann);
+
+	// Name of the state file stored alongside a network file
+	static std::string sidecarFilename(const std::string &networkFilename);
+};
+
+// Periodically snapshots a network while it trains.  The snapshot (a copy of the network plus
+// its TrainState) is taken on the training thread between epochs, but writing it to disk happens
+// on a background thread so training isn't blocked on I/O.  Without a filename, snapshots are
+// instead kept in an in-memory ring holding the most recent ringSize checkpoints.
+class Checkpointer {
+public:
+	class Checkpoint {
+	public:
+		Checkpoint();
+		~Checkpoint();
+		struct fann *ann;
+		TrainState state;
+	};
+
+	Checkpointer(unsigned int _everyEpochs, double _everySeconds, std::string _filename, unsigned int _ringSize);
+	~Checkpointer();
+
+	// Called when a training run starts, to reset the interval counters
+	void start();
+
+	// Called from the FANN training callback; takes a checkpoint if an interval has elapsed
+	void update(struct fann *ann, unsigned int epochs, float mse);
+
+	// Waits until any pending checkpoint is written.  Returns false if a write failed since the last flush.
+	bool flush(std::string &errorMessage);
+
+	// Stops taking new checkpoints, keeping any that are in the ring
+	void disable();
+
+	// In-memory ring access.  These lock against the training thread and are safe to call while training.
+	size_t getNumCheckpoints();
+	bool getCheckpointInfo(size_t idx, unsigned int &epochs, float &mse);
+	// Returns a new network with the checkpoint's training state applied.  Returns NULL and sets
+	// errorMessage if idx is out of range or the state can't be applied.
+	FANN::neural_net *restoreCheckpoint(size_t idx, std::string &errorMessage);
+
+private:
+	void writerMain();
+	bool writeCheckpoint(Checkpoint *checkpoint, std::string &errorMessage);
+
+	unsigned int everyEpochs;
+	double everySeconds;
+	std::string filename;
+	unsigned int ringSize;
+	unsigned int lastEpochs;
+	std::chrono::steady_clock::time_point lastTime;
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::thread writerThread;
+	Checkpoint *pending;
+	bool writing;
+	bool stopping;
+	std::string writeError;
+	std::deque<Checkpoint *> ring;
+};
+
+}
+
+#endif
@@ -0,0 +1,143 @@
+#include "training-data-builder.h"
+#include "training-data.h"
+#include "fann-internals.h"
+#include "train-data-blocks.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <algorithm>
+
+namespace fanny {
+
+// Number of elements in an array or typed array, or -1 if it's neither
+static int64_t v8ArrayLength(v8::Local<v8::Value> value) {
+	if (value->IsTypedArray()) return (int64_t)value.As<v8::TypedArray>()->Length();
+	if (value->IsArray()) return value.As<v8::Array>()->Length();
+	return -1;
+}
+
+// Copies an array or typed array of length elements into dest
+static bool v8ToFannData(v8::Local<v8::Value> value, fann_type *dest, size_t length) {
+	if (value->IsTypedArray()) return typedArrayToFannData(value, dest, length);
+	std::vector<fann_type> data = v8ArrayToFannData(value);
+	if (data.size() != length) return false;
+	std::copy(data.begin(), data.end(), dest);
+	return true;
+}
+
+void TrainingDataBuilder::Init(v8::Local<v8::Object> target) {
+	v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(New);
+	tpl->SetClassName(Nan::New("TrainingDataBuilder").ToLocalChecked());
+	tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+	Nan::SetPrototypeMethod(tpl, "append", append);
+	Nan::SetPrototypeMethod(tpl, "length", length);
+	Nan::SetPrototypeMethod(tpl, "finish", finish);
+
+	constructorFunctionTpl.Reset(tpl);
+	Nan::Set(target, Nan::New("TrainingDataBuilder").ToLocalChecked(), Nan::GetFunction(tpl).ToLocalChecked());
+}
+
+thread_local Nan::Persistent<v8::FunctionTemplate> TrainingDataBuilder::constructorFunctionTpl;
+
+TrainingDataBuilder::TrainingDataBuilder(unsigned int _numInput, unsigned int _numOutput) :
+	numInput(_numInput), numOutput(_numOutput), numRows(0), capacity(0), inputs(NULL), outputs(NULL) {}
+
+TrainingDataBuilder::~TrainingDataBuilder() {
+	release();
+}
+
+void TrainingDataBuilder::release() {
+	free(inputs);
+	free(outputs);
+	inputs = NULL;
+	outputs = NULL;
+	numRows = 0;
+	capacity = 0;
+}
+
+bool TrainingDataBuilder::reserve(size_t wantRows) {
+	if (wantRows <= capacity) return true;
+	size_t newCapacity = std::max<size_t>(wantRows, std::max<size_t>(capacity * 2, 1024));
+	fann_type *newInputs = reallocTrainBlock(inputs, numRows * numInput, newCapacity * numInput);
+	if (!newInputs) return false;
+	inputs = newInputs;
+	fann_type *newOutputs = reallocTrainBlock(outputs, numRows * numOutput, newCapacity * numOutput);
+	if (!newOutputs) return false;
+	outputs = newOutputs;
+	capacity = newCapacity;
+	return true;
+}
+
+NAN_METHOD(TrainingDataBuilder::New) {
+	if (!info.IsConstructCall()) return Nan::ThrowError("Must be called as a constructor");
+	if (info.Length() != 2 || !info[0]->IsNumber() || !info[1]->IsNumber()) {
+		return Nan::ThrowTypeError("Takes numInput and numOutput");
+	}
+	unsigned int numInput = Nan::To<uint32_t>(info[0]).FromJust();
+	unsigned int numOutput = Nan::To<uint32_t>(info[1]).FromJust();
+	if (numInput == 0 || numOutput == 0) return Nan::ThrowError("numInput and numOutput must be positive");
+	TrainingDataBuilder *obj = new TrainingDataBuilder(numInput, numOutput);
+	obj->Wrap(info.This());
+	info.GetReturnValue().Set(info.This());
+}
+
+NAN_METHOD(TrainingDataBuilder::append) {
+	TrainingDataBuilder *self = Nan::ObjectWrap::Unwrap<TrainingDataBuilder>(info.Holder());
+	if (info.Length() != 2) return Nan::ThrowError("Takes inputs and outputs");
+	int64_t inputLength = v8ArrayLength(info[0]);
+	int64_t outputLength = v8ArrayLength(info[1]);
+	if (inputLength < 0 || outputLength < 0) return Nan::ThrowTypeError("inputs and outputs must be arrays or typed arrays");
+	if (inputLength % self->numInput != 0 || outputLength % self->numOutput != 0 ||
+		inputLength / self->numInput != outputLength / self->numOutput
+	) {
+		return Nan::ThrowError("inputs and outputs must contain the same number of whole rows");
+	}
+	size_t addRows = (size_t)(inputLength / self->numInput);
+	if (!self->reserve(self->numRows + addRows)) return Nan::ThrowError("Could not allocate training data");
+	if (
+		!v8ToFannData(info[0], self->inputs + self->numRows * self->numInput, (size_t)inputLength) ||
+		!v8ToFannData(info[1], self->outputs + self->numRows * self->numOutput, (size_t)outputLength)
+	) {
+		return Nan::ThrowTypeError("inputs and outputs must contain only numbers");
+	}
+	self->numRows += addRows;
+	info.GetReturnValue().Set((double)self->numRows);
+}
+
+NAN_METHOD(TrainingDataBuilder::length) {
+	TrainingDataBuilder *self = Nan::ObjectWrap::Unwrap<TrainingDataBuilder>(info.Holder());
+	info.GetReturnValue().Set((double)self->numRows);
+}
+
+NAN_METHOD(TrainingDataBuilder::finish) {
+	TrainingDataBuilder *self = Nan::ObjectWrap::Unwrap<TrainingDataBuilder>(info.Holder());
+	if (info.Length() != 1 || !info[0]->IsObject() || !Nan::New(TrainingData::constructorFunctionTpl)->HasInstance(info[0])) {
+		return Nan::ThrowTypeError("Argument must be TrainingData");
+	}
+	if (self->numRows == 0) return Nan::ThrowError("No rows have been appended");
+	TrainingData *trainingData = Nan::ObjectWrap::Unwrap<TrainingData>(info[0].As<v8::Object>());
+
+	// Trim the blocks to their final size, keeping the larger blocks if there's no memory for the copies
+	if (self->capacity > self->numRows) {
+		fann_type *trimmed = reallocTrainBlock(self->inputs, self->numRows * self->numInput, self->numRows * self->numInput);
+		if (trimmed) self->inputs = trimmed;
+		trimmed = reallocTrainBlock(self->outputs, self->numRows * self->numOutput, self->numRows * self->numOutput);
+		if (trimmed) self->outputs = trimmed;
+	}
+	struct fann_train_data *data = createTrainDataFromBlocks(
+		(unsigned int)self->numRows,
+		self->numInput,
+		self->numOutput,
+		self->inputs,
+		self->outputs
+	);
+	if (!data) return Nan::ThrowError("Could not allocate training data");
+	trainingData->setData(data);
+
+	// The blocks now belong to the training data
+	self->inputs = NULL;
+	self->outputs = NULL;
+	self->release();
+}
+
+}
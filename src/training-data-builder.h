@@ -0,0 +1,48 @@
+#ifndef FANNY_TRAINING_DATA_BUILDER_H
+#define FANNY_TRAINING_DATA_BUILDER_H
+
+#include <nan.h>
+#include "fann-includes.h"
+
+namespace fanny {
+
+// Accumulates training rows in batches, for building training data from a stream.  Inputs and outputs are
+// appended to two growable contiguous blocks in FANN's own layout, and finish() hands the blocks to a
+// TrainingData without copying them, so peak memory stays close to the size of the final data.
+class TrainingDataBuilder : public Nan::ObjectWrap {
+
+public:
+	static void Init(v8::Local<v8::Object> target);
+
+	static thread_local Nan::Persistent<v8::FunctionTemplate> constructorFunctionTpl;
+
+private:
+	// Javascript Constructor.  Takes numInput and numOutput.
+	static NAN_METHOD(New);
+
+	TrainingDataBuilder(unsigned int numInput, unsigned int numOutput);
+	~TrainingDataBuilder();
+
+	// Appends rows.  Takes inputs and outputs, each an array or typed array of rows laid end to end, with
+	// the same number of rows.
+	static NAN_METHOD(append);
+	// Number of rows appended so far
+	static NAN_METHOD(length);
+	// Moves the rows into a TrainingData (replacing its contents) and empties the builder
+	static NAN_METHOD(finish);
+
+	// Makes room for at least numRows rows.  Returns false if memory couldn't be allocated.
+	bool reserve(size_t numRows);
+	void release();
+
+	unsigned int numInput;
+	unsigned int numOutput;
+	size_t numRows;
+	size_t capacity;
+	fann_type *inputs;
+	fann_type *outputs;
+};
+
+}
+
+#endif
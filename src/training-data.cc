@@ -2,8 +2,13 @@
 #include <nan.h>
 #include "fann-includes.h"
 #include <iostream>
+#include <math.h>
 #include "utils.h"
 #include "training-data.h"
+#include "fann-internals.h"
+#include "text-data-parser.h"
+#include "train-data-blocks.h"
+#include "data-stats.h"
 
 namespace fanny {
 
@@ -14,6 +19,10 @@ public:
 	bool isSave;
 	bool isFixed;
 	unsigned int decimalPoint;
+	// Number of threads for reading with parseTrainFile(), or 0 to read with FANN
+	unsigned int numThreads;
+	// Data read by parseTrainFile(), swapped in on the main thread
+	struct fann_train_data *parsed;
 
 
 	TDIOWorker(
@@ -22,18 +31,25 @@ public:
 		std::string &_filename,
 		bool _isSave,
 		bool _isFixed,
-		unsigned int _decimalPoint
+		unsigned int _decimalPoint,
+		unsigned int _numThreads = 0
 	) : Nan::AsyncWorker(callback), filename(_filename),
 		isSave(_isSave), isFixed(_isFixed),
-		decimalPoint(_decimalPoint) {
+		decimalPoint(_decimalPoint), numThreads(_numThreads), parsed(NULL) {
 		SaveToPersistent("tdHolder", tdHolder);
 		trainingData = Nan::ObjectWrap::Unwrap<TrainingData>(tdHolder);
 	}
 
-	~TDIOWorker() {}
+	~TDIOWorker() {
+		if (parsed) fann_destroy_train(parsed);
+	}
 
 	void Execute() {
-		if (!isSave) {
+		if (!isSave && numThreads > 0) {
+			std::string error;
+			parsed = parseTrainFile(filename, numThreads, error);
+			if (!parsed) SetErrorMessage(error.c_str());
+		} else if (!isSave) {
 			if (!trainingData->trainingData->read_train_from_file(filename)) {
 				SetErrorMessage("Error reading training data file");
 			}
@@ -47,10 +63,19 @@ public:
 			}
 		}
 	}
+
+	void WorkComplete() {
+		trainingData->release(!isSave);
+		if (parsed) {
+			trainingData->setData(parsed);
+			parsed = NULL;
+		}
+		Nan::AsyncWorker::WorkComplete();
+	}
 };
 
 
-Nan::Persistent<v8::FunctionTemplate> TrainingData::constructorFunctionTpl;
+thread_local Nan::Persistent<v8::FunctionTemplate> TrainingData::constructorFunctionTpl;
 
 void TrainingData::Init(v8::Local<v8::Object> target) {
 	// Create new function template for this JS class constructor
@@ -71,6 +96,8 @@ void TrainingData::Init(v8::Local<v8::Object> target) {
 	Nan::SetPrototypeMethod(tpl, "scaleTrainData", scaleTrainData);
 	Nan::SetPrototypeMethod(tpl, "subsetTrainData", subsetTrainData);
 	Nan::SetPrototypeMethod(tpl, "shuffle", shuffle);
+	Nan::SetPrototypeMethod(tpl, "shuffleAsync", shuffleAsync);
+	Nan::SetPrototypeMethod(tpl, "setSeed", setSeed);
 	Nan::SetPrototypeMethod(tpl, "merge", merge);
 	Nan::SetPrototypeMethod(tpl, "length", length);
 	Nan::SetPrototypeMethod(tpl, "numInput", numInput);
@@ -84,26 +111,145 @@ void TrainingData::Init(v8::Local<v8::Object> target) {
 	Nan::SetPrototypeMethod(tpl, "getMaxInput", getMaxInput);
 	Nan::SetPrototypeMethod(tpl, "getMinOutput", getMinOutput);
 	Nan::SetPrototypeMethod(tpl, "getMaxOutput", getMaxOutput);
+	Nan::SetPrototypeMethod(tpl, "exportData", exportData);
+	Nan::SetPrototypeMethod(tpl, "importData", importData);
+	Nan::SetPrototypeMethod(tpl, "computeStats", computeStats);
+	Nan::SetPrototypeMethod(tpl, "normalizeColumns", normalizeColumns);
+	Nan::SetPrototypeMethod(tpl, "getInputBuffer", getInputBuffer);
+	Nan::SetPrototypeMethod(tpl, "getOutputBuffer", getOutputBuffer);
 
 	// Assign a property called 'TrainingData' to module.exports, pointing to our constructor
 	Nan::Set(target, Nan::New("TrainingData").ToLocalChecked(), Nan::GetFunction(tpl).ToLocalChecked());
 }
 
-TrainingData::TrainingData(FANN::training_data *_training_data) : trainingData(_training_data) {}
+TrainingData::TrainingData(FANN::training_data *_training_data) :
+	trainingData(_training_data), rng(Rng::randomSeed()), asyncHolds(0), heldExclusively(false) {}
 
 TrainingData::~TrainingData() {
+	// Views keep this object alive, so any left are unreachable
+	inputView.buffer.Reset();
+	outputView.buffer.Reset();
 	delete trainingData;
 }
 
+void TrainingData::setData(struct fann_train_data *data) {
+	detachViews();
+	setFannTrainDataStruct(trainingData, data);
+}
+
+void TrainingData::detachViews() {
+	detachBufferView(inputView);
+	detachBufferView(outputView);
+}
+
+bool TrainingData::hold(bool exclusive) {
+	if (heldExclusively || (exclusive && asyncHolds)) {
+		Nan::ThrowError("Training data is in use by an async operation");
+		return false;
+	}
+	++asyncHolds;
+	if (exclusive) heldExclusively = true;
+	return true;
+}
+
+void TrainingData::release(bool exclusive) {
+	--asyncHolds;
+	if (exclusive) heldExclusively = false;
+}
+
+bool TrainingData::checkNotHeld() {
+	if (asyncHolds) {
+		Nan::ThrowError("Training data is in use by an async operation");
+		return false;
+	}
+	return true;
+}
+
+v8::Local<v8::Value> TrainingData::getBufferView(BufferView &view, fann_type *data, size_t length, v8::Local<v8::Object> holder) {
+	Nan::EscapableHandleScope scope;
+	v8::Local<v8::ArrayBuffer> arrayBuffer;
+	if (!view.buffer.IsEmpty() && view.data == data && view.length == length) {
+		arrayBuffer = Nan::New(view.buffer);
+	} else {
+		detachBufferView(view);
+		v8::Isolate *isolate = v8::Isolate::GetCurrent();
+		#if V8_MAJOR_VERSION >= 8
+		// The training data owns the memory, so the backing store must not free it
+		std::unique_ptr<v8::BackingStore> backingStore = v8::ArrayBuffer::NewBackingStore(
+			data,
+			length * sizeof(fann_type),
+			[](void *data, size_t length, void *deleterData) {},
+			NULL
+		);
+		arrayBuffer = v8::ArrayBuffer::New(isolate, std::move(backingStore));
+		#else
+		arrayBuffer = v8::ArrayBuffer::New(isolate, data, length * sizeof(fann_type));
+		#endif
+		// Keep the training data alive for as long as the buffer is reachable
+		Nan::SetPrivate(arrayBuffer, Nan::New("fannyHolder").ToLocalChecked(), holder);
+		view.buffer.Reset(arrayBuffer);
+		view.buffer.SetWeak(&view, bufferViewWeakCallback, Nan::WeakCallbackType::kParameter);
+		view.data = data;
+		view.length = length;
+	}
+	return scope.Escape(FannTypedArray::New(arrayBuffer, 0, length));
+}
+
+void TrainingData::bufferViewWeakCallback(const Nan::WeakCallbackInfo<BufferView> &data) {
+	data.GetParameter()->buffer.Reset();
+}
+
+void TrainingData::detachBufferView(BufferView &view) {
+	if (view.buffer.IsEmpty()) return;
+	Nan::HandleScope scope;
+	v8::Local<v8::ArrayBuffer> arrayBuffer = Nan::New(view.buffer);
+	#if V8_MAJOR_VERSION > 11 || (V8_MAJOR_VERSION == 11 && V8_MINOR_VERSION >= 3)
+	arrayBuffer->Detach(v8::Local<v8::Value>()).Check();
+	#else
+	arrayBuffer->Detach();
+	#endif
+	view.buffer.Reset();
+	view.data = NULL;
+	view.length = 0;
+}
+
+// Whether rows of width values are laid end to end from rows[0]
+static bool rowsAreContiguous(fann_type **rows, unsigned int numRows, unsigned int width) {
+	for (unsigned int row = 1; row < numRows; ++row) {
+		if (rows[row] != rows[0] + (size_t)row * width) return false;
+	}
+	return true;
+}
+
+NAN_METHOD(TrainingData::getInputBuffer) {
+	TrainingData *self = Nan::ObjectWrap::Unwrap<TrainingData>(info.Holder());
+	struct fann_train_data *data = getFannTrainDataStruct(self->trainingData);
+	if (!data || !data->num_data) return Nan::ThrowError("Training data is empty");
+	if (!rowsAreContiguous(data->input, data->num_data, data->num_input)) return Nan::ThrowError("Training data rows are not contiguous");
+	info.GetReturnValue().Set(getBufferView(self->inputView, data->input[0], (size_t)data->num_data * data->num_input, info.Holder()));
+}
+
+NAN_METHOD(TrainingData::getOutputBuffer) {
+	TrainingData *self = Nan::ObjectWrap::Unwrap<TrainingData>(info.Holder());
+	struct fann_train_data *data = getFannTrainDataStruct(self->trainingData);
+	if (!data || !data->num_data) return Nan::ThrowError("Training data is empty");
+	if (!rowsAreContiguous(data->output, data->num_data, data->num_output)) return Nan::ThrowError("Training data rows are not contiguous");
+	info.GetReturnValue().Set(getBufferView(self->outputView, data->output[0], (size_t)data->num_data * data->num_output, info.Holder()));
+}
+
 NAN_METHOD(TrainingData::New) {
 	FANN::training_data *trainingData;
 	if (info.Length() == 1 && Nan::New(TrainingData::constructorFunctionTpl)->HasInstance(info[0])) {
 		TrainingData *other = Nan::ObjectWrap::Unwrap<TrainingData>(info[0].As<v8::Object>());
 		FANN::training_data *otherTrainingData = other->trainingData;
+		trainingData = new FANN::training_data();
 		if (otherTrainingData->length_train_data() > 0) {
-			trainingData = new FANN::training_data(*otherTrainingData);
-		} else {
-			trainingData = new FANN::training_data();
+			struct fann_train_data *copy = copyTrainData(getFannTrainDataStruct(otherTrainingData), 0, otherTrainingData->length_train_data());
+			if (!copy) {
+				delete trainingData;
+				return Nan::ThrowError("Could not allocate training data");
+			}
+			setFannTrainDataStruct(trainingData, copy);
 		}
 	} else {
 		trainingData = new FANN::training_data();
@@ -115,7 +261,66 @@ NAN_METHOD(TrainingData::New) {
 
 NAN_METHOD(TrainingData::shuffle) {
 	TrainingData *self = Nan::ObjectWrap::Unwrap<TrainingData>(info.Holder());
-	self->trainingData->shuffle_train_data();
+	struct fann_train_data *data = getFannTrainDataStruct(self->trainingData);
+	if (!self->checkNotHeld()) return;
+	if (!data || data->num_data < 2) return;
+	// Each shuffle takes its own stream, so shuffle() and shuffleAsync() give the same order
+	Rng shuffleRng = self->rng.fork();
+	struct fann_train_data *shuffled = shuffleTrainData(data, shuffleRng);
+	if (!shuffled) return Nan::ThrowError("Could not allocate training data");
+	self->setData(shuffled);
+}
+
+class ShuffleWorker : public Nan::AsyncWorker {
+public:
+	TrainingData *trainingData;
+	struct fann_train_data *data;
+	struct fann_train_data *shuffled;
+	Rng rng;
+
+	ShuffleWorker(Nan::Callback *callback, v8::Local<v8::Object> tdHolder, TrainingData *_trainingData) :
+		Nan::AsyncWorker(callback), trainingData(_trainingData), shuffled(NULL), rng(_trainingData->rng.fork())
+	{
+		SaveToPersistent("tdHolder", tdHolder);
+		data = getFannTrainDataStruct(trainingData->trainingData);
+	}
+
+	~ShuffleWorker() {
+		if (shuffled) fann_destroy_train(shuffled);
+	}
+
+	void Execute() {
+		if (!data || data->num_data < 2) return;
+		shuffled = shuffleTrainData(data, rng);
+		if (!shuffled) SetErrorMessage("Could not allocate training data");
+	}
+
+	void WorkComplete() {
+		// Release the data before calling back, so the callback can shuffle it again
+		trainingData->release(true);
+		if (shuffled) {
+			trainingData->setData(shuffled);
+			shuffled = NULL;
+		}
+		Nan::AsyncWorker::WorkComplete();
+	}
+};
+
+NAN_METHOD(TrainingData::shuffleAsync) {
+	if (info.Length() != 1 || !info[0]->IsFunction()) return Nan::ThrowError("Callback required");
+	TrainingData *self = Nan::ObjectWrap::Unwrap<TrainingData>(info.Holder());
+	// The worker reads the current blocks and replaces them when it completes
+	if (!self->hold(true)) return;
+	Nan::Callback *callback = new Nan::Callback(info[0].As<v8::Function>());
+	AsyncQueueWorker(new ShuffleWorker(callback, info.Holder(), self));
+}
+
+NAN_METHOD(TrainingData::setSeed) {
+	if (info.Length() != 1 || !info[0]->IsNumber()) return Nan::ThrowError("Seed must be a number");
+	double seed = Nan::To<double>(info[0]).FromJust();
+	if (!(seed >= 0) || seed != floor(seed) || seed > 9007199254740992.0) return Nan::ThrowError("Seed must be a non-negative integer");
+	TrainingData *self = Nan::ObjectWrap::Unwrap<TrainingData>(info.Holder());
+	self->rng.seed((uint64_t)seed);
 }
 
 NAN_METHOD(TrainingData::merge) {
@@ -127,7 +332,21 @@ NAN_METHOD(TrainingData::merge) {
 	}
 	TrainingData *other = Nan::ObjectWrap::Unwrap<TrainingData>(info[0].As<v8::Object>());
 	TrainingData *self = Nan::ObjectWrap::Unwrap<TrainingData>(info.Holder());
-	self->trainingData->merge_train_data(*other->trainingData);
+	if (!self->checkNotHeld()) return;
+	struct fann_train_data *data1 = getFannTrainDataStruct(self->trainingData);
+	struct fann_train_data *data2 = getFannTrainDataStruct(other->trainingData);
+	if (!data2 || !data2->num_data) return;
+	struct fann_train_data *merged;
+	if (!data1 || !data1->num_data) {
+		merged = copyTrainData(data2, 0, data2->num_data);
+	} else {
+		if (data1->num_input != data2->num_input || data1->num_output != data2->num_output) {
+			return Nan::ThrowError("Training data must have the same number of inputs and outputs");
+		}
+		merged = mergeTrainData(data1, data2);
+	}
+	if (!merged) return Nan::ThrowError("Could not allocate training data");
+	self->setData(merged);
 }
 
 NAN_METHOD(TrainingData::length) {
@@ -185,6 +404,8 @@ NAN_METHOD(TrainingData::setTrainData) {
 	unsigned int dataSetLength = inputs->Length();
 	if (outputs->Length() != dataSetLength) return Nan::ThrowError("Input and output dataset sizes must match");
 	if (!dataSetLength) return Nan::ThrowError("Dataset must be nonzero in size");
+	TrainingData *self = Nan::ObjectWrap::Unwrap<TrainingData>(info.Holder());
+	if (!self->checkNotHeld()) return;
 	std::vector<fann_type> inputVector, outputVector;
 	unsigned int numInputNodes = 0, numOutputNodes = 0;
 	for (unsigned int idx = 0; idx < dataSetLength; ++idx) {
@@ -200,8 +421,8 @@ NAN_METHOD(TrainingData::setTrainData) {
 			numInputNodes = inputArray->Length();
 			numOutputNodes = outputArray->Length();
 			if (!numInputNodes || !numOutputNodes) return Nan::ThrowError("Invalid data");
-			inputVector.reserve(dataSetLength * numInputNodes);
-			outputVector.reserve(dataSetLength * numOutputNodes);
+			inputVector.resize((size_t)dataSetLength * numInputNodes);
+			outputVector.resize((size_t)dataSetLength * numOutputNodes);
 		}
 		std::vector<fann_type> inputRow = v8ArrayToFannData(inputArray);
 		std::vector<fann_type> outputRow = v8ArrayToFannData(outputArray);
@@ -209,8 +430,9 @@ NAN_METHOD(TrainingData::setTrainData) {
 		memcpy(&inputVector[idx * numInputNodes], &inputRow[0], numInputNodes * sizeof(fann_type));
 		memcpy(&outputVector[idx * numOutputNodes], &outputRow[0], numOutputNodes * sizeof(fann_type));
 	}
-	TrainingData *self = Nan::ObjectWrap::Unwrap<TrainingData>(info.Holder());
-	self->trainingData->set_train_data(dataSetLength, numInputNodes, &inputVector[0], numOutputNodes, &outputVector[0]);
+	struct fann_train_data *data = createTrainDataFromValues(dataSetLength, numInputNodes, &inputVector[0], numOutputNodes, &outputVector[0]);
+	if (!data) return Nan::ThrowError("Could not allocate training data");
+	self->setData(data);
 }
 
 NAN_METHOD(TrainingData::getMinInput) {
@@ -251,14 +473,22 @@ NAN_METHOD(TrainingData::getMaxOutput) {
 
 NAN_METHOD(TrainingData::readTrainFromFile) {
 	if (info.Length() < 2 || !info[0]->IsString()) return Nan::ThrowError("Filename required");
+	if (!info[info.Length() - 1]->IsFunction()) return Nan::ThrowError("Callback required");
 	std::string filename = std::string(*Nan::Utf8String(info[0]));
-	Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
-	AsyncQueueWorker(new TDIOWorker(callback, info.Holder(), filename, false, false, 0));
+	unsigned int numThreads = 0;
+	if (info.Length() >= 3 && info[1]->IsNumber()) numThreads = info[1]->Uint32Value(Nan::GetCurrentContext()).FromJust();
+	TrainingData *self = Nan::ObjectWrap::Unwrap<TrainingData>(info.Holder());
+	// The worker replaces the data's blocks
+	if (!self->hold(true)) return;
+	self->detachViews();
+	Nan::Callback *callback = new Nan::Callback(info[info.Length() - 1].As<v8::Function>());
+	AsyncQueueWorker(new TDIOWorker(callback, info.Holder(), filename, false, false, 0, numThreads));
 }
 
 NAN_METHOD(TrainingData::saveTrain) {
 	if (info.Length() < 2 || !info[0]->IsString()) return Nan::ThrowError("Filename required");
 	std::string filename = std::string(*Nan::Utf8String(info[0]));
+	if (!Nan::ObjectWrap::Unwrap<TrainingData>(info.Holder())->hold(false)) return;
 	Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
 	AsyncQueueWorker(new TDIOWorker(callback, info.Holder(), filename, true, false, 0));
 }
@@ -267,6 +497,7 @@ NAN_METHOD(TrainingData::saveTrainToFixed) {
 	if (info.Length() < 3 || !info[0]->IsString() || !info[1]->IsNumber()) return Nan::ThrowError("Filename and decimalPoint required");
 	std::string filename = std::string(*Nan::Utf8String(info[0]));
 	unsigned int decimalPoint = info[1]->Uint32Value(Nan::GetCurrentContext()).FromJust();
+	if (!Nan::ObjectWrap::Unwrap<TrainingData>(info.Holder())->hold(false)) return;
 	Nan::Callback *callback = new Nan::Callback(info[1].As<v8::Function>());
 	AsyncQueueWorker(new TDIOWorker(callback, info.Holder(), filename, true, true, decimalPoint));
 }
@@ -304,6 +535,84 @@ NAN_METHOD(TrainingData::scaleTrainData) {
 	self->trainingData->scale_train_data(newMin, newMax);
 }
 
+// Header of the exportData() format, followed by all inputs then all outputs as doubles
+struct TrainingDataExportHeader {
+	uint32_t numData;
+	uint32_t numInput;
+	uint32_t numOutput;
+	uint32_t reserved;
+};
+
+NAN_METHOD(TrainingData::exportData) {
+	#ifndef FANNY_FIXED
+	TrainingData *self = Nan::ObjectWrap::Unwrap<TrainingData>(info.Holder());
+	TrainingDataExportHeader header;
+	header.numData = self->trainingData->length_train_data();
+	header.numInput = self->trainingData->num_input_train_data();
+	header.numOutput = self->trainingData->num_output_train_data();
+	header.reserved = 0;
+	size_t numValues = (size_t)header.numData * (header.numInput + header.numOutput);
+	size_t length = sizeof(header) + numValues * sizeof(double);
+	char *data = (char *)malloc(length);
+	if (!data) return Nan::ThrowError("Could not allocate buffer");
+	memcpy(data, &header, sizeof(header));
+	double *values = (double *)(data + sizeof(header));
+	fann_type **inputs = self->trainingData->get_input();
+	fann_type **outputs = self->trainingData->get_output();
+	for (uint32_t row = 0; row < header.numData; ++row) {
+		for (uint32_t idx = 0; idx < header.numInput; ++idx) *(values++) = inputs[row][idx];
+	}
+	for (uint32_t row = 0; row < header.numData; ++row) {
+		for (uint32_t idx = 0; idx < header.numOutput; ++idx) *(values++) = outputs[row][idx];
+	}
+	info.GetReturnValue().Set(Nan::NewBuffer(data, (uint32_t)length).ToLocalChecked());
+	#else
+	Nan::ThrowError("Not supported for fixed fann");
+	#endif
+}
+
+NAN_METHOD(TrainingData::importData) {
+	#ifndef FANNY_FIXED
+	if (info.Length() != 1 || !node::Buffer::HasInstance(info[0])) return Nan::ThrowTypeError("Takes a Buffer");
+	const char *data = node::Buffer::Data(info[0]);
+	size_t length = node::Buffer::Length(info[0]);
+	TrainingDataExportHeader header;
+	if (length < sizeof(header)) return Nan::ThrowError("Invalid training data buffer");
+	memcpy(&header, data, sizeof(header));
+	size_t numInputValues = (size_t)header.numData * header.numInput;
+	size_t numOutputValues = (size_t)header.numData * header.numOutput;
+	if (length != sizeof(header) + (numInputValues + numOutputValues) * sizeof(double)) return Nan::ThrowError("Invalid training data buffer");
+	if (!header.numData || !header.numInput || !header.numOutput) return Nan::ThrowError("Dataset must be nonzero in size");
+	TrainingData *self = Nan::ObjectWrap::Unwrap<TrainingData>(info.Holder());
+	if (!self->checkNotHeld()) return;
+	// Convert straight into the training data's blocks
+	fann_type *inputBlock = allocTrainBlock(numInputValues);
+	fann_type *outputBlock = allocTrainBlock(numOutputValues);
+	struct fann_train_data *trainData = (inputBlock && outputBlock) ?
+		createTrainDataFromBlocks(header.numData, header.numInput, header.numOutput, inputBlock, outputBlock) : NULL;
+	if (!trainData) {
+		free(inputBlock);
+		free(outputBlock);
+		return Nan::ThrowError("Could not allocate training data");
+	}
+	const char *values = data + sizeof(header);
+	for (size_t idx = 0; idx < numInputValues; ++idx) {
+		double value;
+		memcpy(&value, values + idx * sizeof(double), sizeof(double));
+		inputBlock[idx] = (fann_type)value;
+	}
+	values += numInputValues * sizeof(double);
+	for (size_t idx = 0; idx < numOutputValues; ++idx) {
+		double value;
+		memcpy(&value, values + idx * sizeof(double), sizeof(double));
+		outputBlock[idx] = (fann_type)value;
+	}
+	self->setData(trainData);
+	#else
+	Nan::ThrowError("Not supported for fixed fann");
+	#endif
+}
+
 NAN_METHOD(TrainingData::subsetTrainData) {
 	if (info.Length() != 2) return Nan::ThrowError("Must have 2 arguments: pos, legth");
 	if (!info[0]->IsNumber() || !info[1]->IsNumber()) return Nan::ThrowError("Arguments must be numbers");
@@ -312,7 +621,68 @@ NAN_METHOD(TrainingData::subsetTrainData) {
 	unsigned int length = info[1]->Uint32Value(Nan::GetCurrentContext()).FromJust();
 
 	TrainingData *self = Nan::ObjectWrap::Unwrap<TrainingData>(info.Holder());
-	self->trainingData->subset_train_data(pos, length);
+	if (!self->checkNotHeld()) return;
+	struct fann_train_data *data = getFannTrainDataStruct(self->trainingData);
+	if (!data || length == 0 || pos > data->num_data || length > data->num_data - pos) return Nan::ThrowError("Subset out of range");
+	struct fann_train_data *subset = copyTrainData(data, pos, length);
+	if (!subset) return Nan::ThrowError("Could not allocate training data");
+	self->setData(subset);
+}
+
+static v8::Local<v8::Value> doublesToFloat64Array(const std::vector<double> &values) {
+	Nan::EscapableHandleScope scope;
+	v8::Local<v8::ArrayBuffer> arrayBuffer = v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), values.size() * sizeof(double));
+	v8::Local<v8::Float64Array> typedArray = v8::Float64Array::New(arrayBuffer, 0, values.size());
+	if (!values.empty()) {
+		Nan::TypedArrayContents<double> contents(typedArray);
+		memcpy(*contents, &values[0], values.size() * sizeof(double));
+	}
+	return scope.Escape(typedArray);
+}
+
+NAN_METHOD(TrainingData::computeStats) {
+	if (info.Length() != 2 || !info[1]->IsNumber()) return Nan::ThrowError("Must have 2 arguments: isOutput, numThreads");
+	TrainingData *self = Nan::ObjectWrap::Unwrap<TrainingData>(info.Holder());
+	struct fann_train_data *data = getFannTrainDataStruct(self->trainingData);
+	if (!data || !data->num_data) return Nan::ThrowError("Training data is empty");
+	bool isOutput = Nan::To<bool>(info[0]).FromJust();
+	unsigned int numThreads = Nan::To<uint32_t>(info[1]).FromJust();
+	ColumnStats stats;
+	if (isOutput) {
+		computeColumnStats(data->output, data->num_data, data->num_output, numThreads, stats);
+	} else {
+		computeColumnStats(data->input, data->num_data, data->num_input, numThreads, stats);
+	}
+	v8::Local<v8::Object> result = Nan::New<v8::Object>();
+	Nan::Set(result, Nan::New("min").ToLocalChecked(), doublesToFloat64Array(stats.min));
+	Nan::Set(result, Nan::New("max").ToLocalChecked(), doublesToFloat64Array(stats.max));
+	Nan::Set(result, Nan::New("mean").ToLocalChecked(), doublesToFloat64Array(stats.mean));
+	Nan::Set(result, Nan::New("variance").ToLocalChecked(), doublesToFloat64Array(stats.variance));
+	Nan::Set(result, Nan::New("nanCount").ToLocalChecked(), doublesToFloat64Array(stats.nanCount));
+	info.GetReturnValue().Set(result);
+}
+
+NAN_METHOD(TrainingData::normalizeColumns) {
+	#ifndef FANNY_FIXED
+	if (info.Length() != 5 || !info[4]->IsNumber()) return Nan::ThrowError("Must have 5 arguments: isOutput, offset, scale, base, numThreads");
+	TrainingData *self = Nan::ObjectWrap::Unwrap<TrainingData>(info.Holder());
+	struct fann_train_data *data = getFannTrainDataStruct(self->trainingData);
+	if (!data || !data->num_data) return Nan::ThrowError("Training data is empty");
+	bool isOutput = Nan::To<bool>(info[0]).FromJust();
+	unsigned int width = isOutput ? data->num_output : data->num_input;
+	for (int argIdx = 1; argIdx <= 3; ++argIdx) {
+		if (!info[argIdx]->IsFloat64Array() || info[argIdx].As<v8::Float64Array>()->Length() != width) {
+			return Nan::ThrowTypeError("Offset, scale and base must be Float64Arrays with one entry per column");
+		}
+	}
+	Nan::TypedArrayContents<double> offset(info[1]);
+	Nan::TypedArrayContents<double> scale(info[2]);
+	Nan::TypedArrayContents<double> base(info[3]);
+	unsigned int numThreads = Nan::To<uint32_t>(info[4]).FromJust();
+	fanny::normalizeColumns(isOutput ? data->output : data->input, data->num_data, width, *offset, *scale, *base, numThreads);
+	#else
+	Nan::ThrowError("Not supported for fixed fann");
+	#endif
 }
 
 }
@@ -3,6 +3,7 @@
 
 #include <nan.h>
 #include "fann-includes.h"
+#include "rng.h"
 
 namespace fanny {
 
@@ -16,8 +17,28 @@ public:
 	// Encapsulated FANN training_data instance
 	FANN::training_data *trainingData;
 
+	// Random stream for shuffling.  Seeded from the system unless setSeed() is called.
+	Rng rng;
+
+	// Replaces the underlying structure (destroying the old one), detaching any buffer views first
+	void setData(struct fann_train_data *data);
+	// Detaches the buffer views.  Must be called before the data's blocks are freed or replaced.
+	void detachViews();
+
+	// Async workers reading the data hold it until they complete.  Workers that replace the data's blocks
+	// hold it exclusively.  Methods that replace the blocks throw while the data is held, and no worker
+	// can start while it's held exclusively.
+	unsigned int asyncHolds;
+	bool heldExclusively;
+	// Takes a hold for an async worker.  Throws a JS error and returns false if the data is in use.
+	bool hold(bool exclusive);
+	// Releases a hold taken with hold(), on the main thread before the worker calls back
+	void release(bool exclusive);
+	// Throws a JS error and returns false if any async worker holds the data
+	bool checkNotHeld();
+
 	// Reference to the javascript constructor FunctionTemplate
-	static Nan::Persistent<v8::FunctionTemplate> constructorFunctionTpl;
+	static thread_local Nan::Persistent<v8::FunctionTemplate> constructorFunctionTpl;
 
 private:
 
@@ -29,7 +50,12 @@ private:
 	~TrainingData();
 
 	// Methods
+	// Shuffles the rows with the instance's random stream, synchronously or on a worker thread (taking a
+	// callback).  shuffleAsync() holds the data exclusively until it calls back.
 	static NAN_METHOD(shuffle);
+	static NAN_METHOD(shuffleAsync);
+	// Reseeds the random stream.  Takes a non-negative integer.
+	static NAN_METHOD(setSeed);
 	static NAN_METHOD(merge);
 	static NAN_METHOD(length);
 	static NAN_METHOD(numInput);
@@ -51,6 +77,36 @@ private:
 	static NAN_METHOD(scaleTrainData);
 	static NAN_METHOD(subsetTrainData);
 
+	// Copy the data to and from a Buffer of doubles (prefixed by a header containing the length, number
+	// of inputs and number of outputs), for converting training data between datatypes
+	static NAN_METHOD(exportData);
+	static NAN_METHOD(importData);
+
+	// Per-column statistics of the inputs or outputs.  Takes isOutput and numThreads, and returns an object
+	// of Float64Arrays: min, max, mean, variance and nanCount.
+	static NAN_METHOD(computeStats);
+	// Normalizes each input or output column in place as (value - offset) * scale + base.  Takes isOutput,
+	// Float64Arrays of offset, scale and base with one entry per column, and numThreads.
+	static NAN_METHOD(normalizeColumns);
+
+	// Typed arrays backed directly by the input and output blocks, without copying
+	static NAN_METHOD(getInputBuffer);
+	static NAN_METHOD(getOutputBuffer);
+
+	// ArrayBuffer over one of the data's blocks handed out by getInputBuffer() or getOutputBuffer(),
+	// held weakly
+	struct BufferView {
+		BufferView() : data(NULL), length(0) {}
+		Nan::Persistent<v8::ArrayBuffer> buffer;
+		fann_type *data;
+		size_t length;
+	};
+	BufferView inputView;
+	BufferView outputView;
+	static v8::Local<v8::Value> getBufferView(BufferView &view, fann_type *data, size_t length, v8::Local<v8::Object> holder);
+	static void detachBufferView(BufferView &view);
+	static void bufferViewWeakCallback(const Nan::WeakCallbackInfo<BufferView> &data);
+
 };
 
 }
@@ -1,4 +1,5 @@
 #include "utils.h"
+#include <string.h>
 
 namespace fanny {
 
@@ -37,7 +38,7 @@ v8::Local<v8::Value> fannDataToV8Array(fann_type * data, unsigned int size) {
 // length is how many entries are in data, size is the number of fann_type values in each entry
 v8::Local<v8::Value> fannDataSetToV8Array(fann_type ** data, unsigned int length, unsigned int size) {
 	Nan::EscapableHandleScope scope;
-	v8::Local<v8::Array> v8Array = Nan::New<v8::Array>(size);
+	v8::Local<v8::Array> v8Array = Nan::New<v8::Array>(length);
 	for (uint32_t idx = 0; idx < length; ++idx) {
 		v8::Local<v8::Value> value = fannDataToV8Array(data[idx], size);
 		Nan::Set(v8Array, idx, value);
@@ -45,6 +46,40 @@ v8::Local<v8::Value> fannDataSetToV8Array(fann_type ** data, unsigned int length
 	return scope.Escape(v8Array);
 }
 
+v8::Local<v8::Value> fannDataToTypedArray(const fann_type *data, size_t length) {
+	Nan::EscapableHandleScope scope;
+	v8::Local<v8::ArrayBuffer> arrayBuffer = v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), length * sizeof(fann_type));
+	v8::Local<FannTypedArray> typedArray = FannTypedArray::New(arrayBuffer, 0, length);
+	if (length) {
+		Nan::TypedArrayContents<fann_type> contents(typedArray);
+		memcpy(*contents, data, length * sizeof(fann_type));
+	}
+	return scope.Escape(typedArray);
+}
+
+template<typename T> static void copyConvertTypedArray(v8::Local<v8::Value> value, fann_type *dest, size_t length) {
+	Nan::TypedArrayContents<T> contents(value);
+	const T *src = *contents;
+	for (size_t idx = 0; idx < length; ++idx) {
+		dest[idx] = (fann_type)src[idx];
+	}
+}
+
+bool typedArrayToFannData(v8::Local<v8::Value> value, fann_type *dest, size_t length) {
+	if (!value->IsTypedArray()) return false;
+	if (value.As<v8::TypedArray>()->Length() != length) return false;
+	if (value->IsFloat32Array()) {
+		copyConvertTypedArray<float>(value, dest, length);
+	} else if (value->IsFloat64Array()) {
+		copyConvertTypedArray<double>(value, dest, length);
+	} else if (value->IsInt32Array()) {
+		copyConvertTypedArray<int32_t>(value, dest, length);
+	} else {
+		return false;
+	}
+	return true;
+}
+
 v8::Local<v8::Value> trainingAlgorithmEnumToV8String(FANN::training_algorithm_enum value) {
 	Nan::EscapableHandleScope scope;
 	const char *str = NULL;
@@ -249,5 +284,60 @@ bool v8StringToActivationFunctionEnum(v8::Local<v8::Value> value, FANN::activati
 	return true;
 }
 
+v8::Local<v8::Value> runOutputsToV8(std::vector<fann_type> &outputs, unsigned int numRows, unsigned int numOutput, RunResultFormat format) {
+	Nan::EscapableHandleScope scope;
+	v8::Local<v8::Value> ret;
+	if (format == RUN_RESULT_TYPED) {
+		ret = fannDataToTypedArray(&outputs[0], outputs.size());
+	} else if (format == RUN_RESULT_ROWS) {
+		v8::Local<v8::Array> rows = Nan::New<v8::Array>(numRows);
+		for (unsigned int row = 0; row < numRows; ++row) {
+			Nan::Set(rows, row, fannDataToV8Array(&outputs[(size_t)row * numOutput], numOutput));
+		}
+		ret = rows;
+	} else {
+		ret = fannDataToV8Array(&outputs[0], numOutput);
+	}
+	return scope.Escape(ret);
+}
+
+bool v8ToInputRows(v8::Local<v8::Value> value, unsigned int numInput, std::vector<fann_type> &inputs, unsigned int &numRows, RunResultFormat &format) {
+	if (value->IsTypedArray()) {
+		size_t length = value.As<v8::TypedArray>()->Length();
+		if (length == 0 || length % numInput != 0) {
+			Nan::ThrowError("Typed array length must be a multiple of the number of inputs");
+			return false;
+		}
+		inputs.resize(length);
+		if (!typedArrayToFannData(value, &inputs[0], length)) {
+			Nan::ThrowTypeError("Inputs must be a Float32Array, Float64Array or Int32Array");
+			return false;
+		}
+		numRows = (unsigned int)(length / numInput);
+		format = RUN_RESULT_TYPED;
+		return true;
+	}
+	if (!value->IsArray()) {
+		Nan::ThrowTypeError("Inputs must be an array of arrays or a typed array");
+		return false;
+	}
+	v8::Local<v8::Array> rows = value.As<v8::Array>();
+	numRows = rows->Length();
+	if (numRows == 0) {
+		Nan::ThrowError("Batch must have at least one row");
+		return false;
+	}
+	inputs.reserve((size_t)numRows * numInput);
+	for (unsigned int row = 0; row < numRows; ++row) {
+		std::vector<fann_type> rowInputs = v8ArrayToFannData(Nan::Get(rows, row).ToLocalChecked());
+		if (rowInputs.size() != numInput) {
+			Nan::ThrowError("Wrong number of inputs");
+			return false;
+		}
+		inputs.insert(inputs.end(), rowInputs.begin(), rowInputs.end());
+	}
+	format = RUN_RESULT_ROWS;
+	return true;
+}
 
 }
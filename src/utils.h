@@ -10,6 +10,39 @@ v8::Local<v8::Value> fannDataToV8Array(fann_type * data, unsigned int size);
 
 v8::Local<v8::Value> fannDataSetToV8Array(fann_type ** data, unsigned int length, unsigned int size);
 
+// Typed array class whose element type matches fann_type
+#if defined(FANNY_FIXED)
+typedef v8::Int32Array FannTypedArray;
+#elif defined(FANNY_DOUBLE)
+typedef v8::Float64Array FannTypedArray;
+#else
+typedef v8::Float32Array FannTypedArray;
+#endif
+
+// Copies data into a new typed array of the fann_type element type
+v8::Local<v8::Value> fannDataToTypedArray(const fann_type *data, size_t length);
+
+// Copies a Float32Array, Float64Array or Int32Array of exactly length elements into dest, converting
+// the element type if needed.  Returns false if the value is not one of those or has a different length.
+bool typedArrayToFannData(v8::Local<v8::Value> value, fann_type *dest, size_t length);
+
+// How run results are returned to Javascript
+enum RunResultFormat {
+	// A single array of outputs
+	RUN_RESULT_ARRAY,
+	// An array with an array of outputs per row
+	RUN_RESULT_ROWS,
+	// A typed array with the output rows laid end to end
+	RUN_RESULT_TYPED
+};
+
+// Converts numRows rows of outputs to the given format
+v8::Local<v8::Value> runOutputsToV8(std::vector<fann_type> &outputs, unsigned int numRows, unsigned int numOutput, RunResultFormat format);
+
+// Reads a batch of input rows from an array of arrays, or from a typed array with the rows laid end
+// to end.  Throws a JS error and returns false if the batch is malformed.
+bool v8ToInputRows(v8::Local<v8::Value> value, unsigned int numInput, std::vector<fann_type> &inputs, unsigned int &numRows, RunResultFormat &format);
+
 // Number converter
 inline fann_type v8NumberToFannType(v8::Local<v8::Value> number) {
 	fann_type fannNumber = 0;
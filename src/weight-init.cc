@@ -0,0 +1,55 @@
+#include "weight-init.h"
+#include "fann-internals.h"
+#include <math.h>
+
+namespace fanny {
+
+// As fann_rand()
+static inline float randomBetween(Rng &rng, float minValue, float maxValue) {
+	return minValue + (maxValue - minValue) * (float)rng.uniform();
+}
+
+void randomizeWeights(struct fann *ann, fann_type minWeight, fann_type maxWeight, Rng &rng) {
+	fann_type *weights = ann->weights;
+	for (unsigned int con = 0; con < ann->total_connections; ++con) {
+		weights[con] = (fann_type)randomBetween(rng, (float)minWeight, (float)maxWeight);
+	}
+	#ifndef FANNY_FIXED
+	if (ann->prev_train_slopes != NULL) fann_clear_train_arrays(ann);
+	#endif
+}
+
+void initWeights(struct fann *ann, struct fann_train_data *data, Rng &rng) {
+	#ifndef FANNY_FIXED
+	fann_type smallestInput = data->input[0][0];
+	fann_type largestInput = data->input[0][0];
+	for (unsigned int row = 0; row < data->num_data; ++row) {
+		for (unsigned int idx = 0; idx < data->num_input; ++idx) {
+			fann_type value = data->input[row][idx];
+			if (value < smallestInput) smallestInput = value;
+			if (value > largestInput) largestInput = value;
+		}
+	}
+	unsigned int numHiddenNeurons = (unsigned int)(ann->total_neurons - (ann->num_input + ann->num_output + (ann->last_layer - ann->first_layer)));
+	float scaleFactor = (float)(pow((double)(0.7f * (double)numHiddenNeurons), (double)(1.0f / (double)ann->num_input)) / (double)(largestInput - smallestInput));
+
+	struct fann_neuron *biasNeuron = ann->first_layer->last_neuron - 1;
+	for (struct fann_layer *layer = ann->first_layer + 1; layer != ann->last_layer; ++layer) {
+		if (ann->network_type == FANN_NETTYPE_LAYER) biasNeuron = (layer - 1)->last_neuron - 1;
+		for (struct fann_neuron *neuron = layer->first_neuron; neuron != layer->last_neuron; ++neuron) {
+			for (unsigned int con = neuron->first_con; con < neuron->last_con; ++con) {
+				if (ann->connections[con] == biasNeuron) {
+					ann->weights[con] = (fann_type)randomBetween(rng, -scaleFactor, scaleFactor);
+				} else {
+					ann->weights[con] = (fann_type)randomBetween(rng, 0, scaleFactor);
+				}
+			}
+		}
+	}
+	if (ann->prev_train_slopes != NULL) fann_clear_train_arrays(ann);
+	#else
+	fann_init_weights(ann, data);
+	#endif
+}
+
+}
@@ -0,0 +1,21 @@
+#ifndef FANNY_WEIGHT_INIT_H
+#define FANNY_WEIGHT_INIT_H
+
+#include "fann-includes.h"
+#include "rng.h"
+
+namespace fanny {
+
+// Versions of fann_randomize_weights() and fann_init_weights() that draw from a given random stream instead
+// of the C library's rand(), so that networks can be initialized reproducibly and concurrently.  The
+// distributions and the clearing of training arrays match FANN's.
+
+void randomizeWeights(struct fann *ann, fann_type minWeight, fann_type maxWeight, Rng &rng);
+
+// Nguyen-Widrow initialization from the range of the data's inputs.  Fixed point networks use FANN's own
+// version (and so rand()), since it also rescales to the network's decimal point.
+void initWeights(struct fann *ann, struct fann_train_data *data, Rng &rng);
+
+}
+
+#endif
@@ -58,6 +58,89 @@ describe('Tests', function() {
 	});
 
 
+	it('parallel cascade test', function() {
+		var ann = createANN({
+			layers: [ 2, 5 ],
+			type: 'shortcut'
+		}, {
+			bitFailLimit: 0.1
+		});
+		var cascadeFunctions = ann.getOption('cascadeActivationFunctions');
+		var trainOptions = {
+			desiredError: 0,
+			stopFunction: 'BIT',
+			cascade: true,
+			cascadeThreads: 4,
+			maxNeurons: 50
+		};
+		return ann.train(booleanTrainingData, trainOptions)
+			.then(function() {
+				expect(booleanThreshold(ann.run([ 1, 1 ]))).to.deep.equal([ 1, 1, 0, 0, 0 ]);
+				expect(booleanThreshold(ann.run([ 1, 0 ]))).to.deep.equal([ 0, 1, 1, 0, 1 ]);
+				expect(ann.getOption('cascadeActivationFunctions')).to.deep.equal(cascadeFunctions);
+			});
+	});
+
+	it('sparse network test', function() {
+		var ann = createANN({ layers: [ 2, 20, 20, 5 ], type: 'sparse', connectionRate: 0.7 });
+		return ann.train(booleanTrainingData, { desiredError: 0, stopFunction: 'BIT', maxEpochs: 20000 })
+			.then(function() {
+				expect(booleanThreshold(ann.run([ 1, 1 ]))).to.deep.equal([ 1, 1, 0, 0, 0 ]);
+				expect(booleanThreshold(ann.run([ 1, 0 ]))).to.deep.equal([ 0, 1, 1, 0, 1 ]);
+				expect(ann.runBatch([ [ 1, 1 ] ])[0]).to.deep.equal(ann.run([ 1, 1 ]));
+				return ann.testData(createTrainingData(booleanTrainingData));
+			})
+			.then(function(mse) {
+				expect(mse).to.be.a('number');
+				expect(ann.getBitFail()).to.equal(0);
+			});
+	});
+
+	describe('Forward Engines', function() {
+		// Runs a network in Javascript from its connection array, with every non-input neuron using
+		// SIGMOID and the default steepness of 0.5.  Neurons without connections are bias neurons.
+		function referenceRun(ann, inputs, numOutput) {
+			var connections = ann.getConnectionArray();
+			var incoming = [];
+			var numNeurons = 0;
+			connections.forEach(function(con) {
+				if (!incoming[con.toNeuron]) incoming[con.toNeuron] = [];
+				incoming[con.toNeuron].push(con);
+				numNeurons = Math.max(numNeurons, con.fromNeuron + 1, con.toNeuron + 1);
+			});
+			var values = [];
+			for (var neuron = 0; neuron < numNeurons; neuron++) {
+				if (neuron < inputs.length) {
+					values.push(inputs[neuron]);
+				} else if (!incoming[neuron]) {
+					values.push(1);
+				} else {
+					var sum = 0;
+					incoming[neuron].forEach(function(con) {
+						sum += con.weight * values[con.fromNeuron];
+					});
+					values.push(1 / (1 + Math.exp(-2 * 0.5 * sum)));
+				}
+			}
+			return values.slice(numNeurons - numOutput);
+		}
+
+		[ { type: 'shortcut' }, { type: 'sparse', connectionRate: 0.6 } ].forEach(function(config) {
+			it('should run ' + config.type + ' networks like FANN', function() {
+				var ann = createANN({
+					layers: [ 3, 6, 4, 2 ],
+					type: config.type,
+					connectionRate: config.connectionRate,
+					activationFunctions: { hidden: 'SIGMOID', output: 'SIGMOID' }
+				});
+				var inputs = [ 0.25, -1, 0.5 ];
+				var expected = referenceRun(ann, inputs, 2);
+				var outputs = ann.run(inputs);
+				for (var i = 0; i < 2; i++) expect(outputs[i]).to.be.closeTo(expected[i], 0.0001);
+			});
+		});
+	});
+
 	it('user data', function() {
 		var ann = createANN({ layers: [ 2, 5, 2 ] });
 		ann.userData.foo = 'bar';
@@ -190,6 +273,32 @@ describe('Tests', function() {
 				expect(updatedConnections[i]).to.have.property('weight').that.is.not.equal(initalConnections[i].weight);
 			}
 		});
+		it('initializes weights reproducibly from a seed', function() {
+			var weights = function(ann) { return ann.getConnectionArray().map((connection) => connection.weight); };
+			var ann1 = createANN({ layers: [ 2, 3, 5 ], seed: 7 });
+			var ann2 = createANN({ layers: [ 2, 3, 5 ], seed: 7 });
+			expect(weights(ann1)).to.deep.equal(weights(ann2));
+			expect(weights(ann1).every((weight) => weight >= -0.1 && weight <= 0.1)).to.equal(true);
+			ann1.setSeed(3);
+			ann2.setSeed(3);
+			ann1.initWeights(createTrainingData(booleanTrainingData));
+			return ann2.initWeightsAsync(createTrainingData(booleanTrainingData)).then(() => {
+				expect(weights(ann1)).to.deep.equal(weights(ann2));
+				ann1.randomizeWeights(-1, 1);
+				expect(weights(ann1)).to.not.deep.equal(weights(ann2));
+			});
+		});
+		it('creates the same seeded network asynchronously', function() {
+			var weights = function(ann) { return ann.getConnectionArray().map((connection) => connection.weight); };
+			var ann1 = createANN({ layers: [ 2, 3, 5 ], seed: 11 });
+			return fanny.createANNAsync({ layers: [ 2, 3, 5 ], seed: 11 }).then((ann2) => {
+				expect(weights(ann2)).to.deep.equal(weights(ann1));
+				// The network's stream continues from the seed
+				ann1.randomizeWeights(-1, 1);
+				ann2.randomizeWeights(-1, 1);
+				expect(weights(ann2)).to.deep.equal(weights(ann1));
+			});
+		});
 		it('can set a single weight', function() {
 			var data = createTrainingData(booleanTrainingData);
 			var ann = createANN({ layers: [ 2, 1, 5 ] });
@@ -219,6 +328,32 @@ describe('Tests', function() {
 			var updatedConnections = ann.getConnectionArray();
 			expect(updatedConnections).to.deep.equal(updatedConnections);
 		});
+		it('can get and set weights as a typed array', function() {
+			var ann = createANN({ layers: [ 2, 3, 5 ] });
+			var connections = ann.getConnectionArray();
+			var weights = ann.getWeights();
+			expect(weights).to.be.an.instanceof(Float32Array);
+			expect(weights).to.have.lengthOf(connections.length);
+			for (var i = 0; i < weights.length; i++) {
+				expect(weights[i]).to.be.closeTo(connections[i].weight, 0.0001);
+				weights[i] = i / 100;
+			}
+			ann.setWeights(weights);
+			var updatedConnections = ann.getConnectionArray();
+			for (var j = 0; j < updatedConnections.length; j++) {
+				expect(updatedConnections[j].weight).to.be.closeTo(j / 100, 0.0001);
+			}
+			expect(function() { ann.setWeights(new Float32Array(1)); }).to.throw(XError);
+		});
+		it('can view weights without copying', function() {
+			var ann = createANN({ layers: [ 2, 3, 5 ] });
+			var view = ann.getWeightsView();
+			expect(view).to.have.lengthOf(ann.info.totalConnections);
+			view[0] = 0.5;
+			expect(ann.getConnectionArray()[0].weight).to.equal(0.5);
+			ann.setWeight(ann.getConnectionArray()[1].fromNeuron, ann.getConnectionArray()[1].toNeuron, 0.25);
+			expect(view[1]).to.equal(0.25);
+		});
 	});
 
 	describe('Print Commands', function() {
@@ -523,6 +658,144 @@ describe('Tests', function() {
 			}).to.not.throw();
 		});
 	});
+	describe('#runBatch', function() {
+		it('should run arrays and typed arrays of rows', function() {
+			var ann = createANN({ layers: [ 2, 3, 5 ] });
+			var expected = [ ann.run([ 1, 0 ]), ann.run([ 0, 1 ]) ];
+			var rows = ann.runBatch([ [ 1, 0 ], [ 0, 1 ] ]);
+			expect(rows).to.deep.equal(expected);
+			var flat = ann.runBatch(new Float32Array([ 1, 0, 0, 1 ]));
+			expect(flat).to.have.lengthOf(10);
+			for (var i = 0; i < 10; i++) expect(flat[i]).to.be.closeTo(expected[Math.floor(i / 5)][i % 5], 0.0001);
+			expect(function() { ann.runBatch(new Float32Array(3)); }).to.throw(XError);
+			return ann.runBatchAsync([ [ 1, 0 ], [ 0, 1 ] ])
+				.then(function(asyncRows) {
+					expect(asyncRows).to.deep.equal(expected);
+				});
+		});
+		it('should apply scaling params natively', function() {
+			var data = createTrainingData(booleanTrainingData);
+			var ann = createANN({ layers: [ 2, 3, 5 ] });
+			ann.setScalingParams(data, -1, 1, -1, 1);
+			var expected = ann.descaleOutput(ann.run(ann.scaleInput([ 1, 0 ])));
+			var outputs = ann.run([ 1, 0 ], { scale: true });
+			for (var i = 0; i < 5; i++) expect(outputs[i]).to.be.closeTo(expected[i], 0.0001);
+			var rows = ann.runBatch([ [ 1, 0 ] ], { scale: true });
+			for (var j = 0; j < 5; j++) expect(rows[0][j]).to.be.closeTo(expected[j], 0.0001);
+			return ann.runAsync([ 1, 0 ], { scale: true })
+				.then(function(asyncOutputs) {
+					for (var k = 0; k < 5; k++) expect(asyncOutputs[k]).to.be.closeTo(expected[k], 0.0001);
+				});
+		});
+	});
+	describe('#setRunCoalescing', function() {
+		it('should batch concurrent runAsync calls', function() {
+			var ann = createANN({ layers: [ 2, 3, 5 ] });
+			var rows = [ [ 0, 0 ], [ 0, 1 ], [ 1, 0 ], [ 1, 1 ], [ 0.5, 0.5 ] ];
+			var expected = rows.map((row) => ann.run(row));
+			ann.setRunCoalescing({ windowMs: 5, maxBatch: 3 });
+			return Promise.all(rows.map((row) => ann.runAsync(row)))
+				.then(function(outputs) {
+					for (var i = 0; i < rows.length; i++) {
+						for (var j = 0; j < 5; j++) expect(outputs[i][j]).to.be.closeTo(expected[i][j], 0.0001);
+					}
+					var before = ann.runAsync([ 1, 1 ]);
+					var randomized = ann.randomizeWeightsAsync(-1, 1);
+					var after = ann.runAsync([ 1, 1 ]);
+					return Promise.all([ before, randomized, after ]);
+				})
+				.then(function(results) {
+					expect(results[0]).to.deep.equal(expected[3]);
+					expect(results[2]).to.not.deep.equal(expected[3]);
+				});
+		});
+	});
+	describe('#run during runAsync', function() {
+		it('should run alongside queued runs but not training', function() {
+			var ann = createANN({ layers: [ 2, 3, 5 ] });
+			var expected = ann.run([ 1, 0 ]);
+			var queued = ann.runBatchAsync([ [ 0, 1 ], [ 1, 1 ] ]);
+			var outputs = ann.run([ 1, 0 ]);
+			for (var j = 0; j < 5; j++) expect(outputs[j]).to.be.closeTo(expected[j], 0.0001);
+			var trained = ann.train(booleanTrainingData, { maxEpochs: 1 });
+			expect(() => ann.run([ 1, 0 ])).to.throw();
+			return Promise.all([ queued, trained ]);
+		});
+		it('should report missing scaling parameters without touching the queued run', function() {
+			var ann = createANN({ layers: [ 2, 3, 5 ] });
+			var expected = ann.run([ 1, 0 ]);
+			var queued = ann.runBatchAsync([ [ 1, 0 ], [ 1, 0 ] ]);
+			expect(() => ann.run([ 1, 0 ], { scale: true })).to.throw(XError);
+			return queued.then(function(outputs) {
+				for (var j = 0; j < 5; j++) expect(outputs[1][j]).to.be.closeTo(expected[j], 0.0001);
+			});
+		});
+	});
+	describe('#createScoringStream', function() {
+		it('should emit outputs in order', function() {
+			var ann = createANN({ layers: [ 2, 3, 5 ] });
+			var rows = [];
+			for (var i = 0; i < 23; i++) rows.push([ i % 2, (i >> 1) % 2 ]);
+			var expected = rows.map((row) => ann.run(row));
+			var scoring = ann.createScoringStream({ batchSize: 4, concurrency: 2 });
+			var outputs = [];
+			return new Promise(function(resolve, reject) {
+				scoring.on('data', (output) => outputs.push(output));
+				scoring.on('error', reject);
+				scoring.on('end', resolve);
+				rows.forEach((row) => scoring.write(row));
+				scoring.end();
+			}).then(function() {
+				expect(outputs).to.have.lengthOf(rows.length);
+				for (var i = 0; i < rows.length; i++) {
+					for (var j = 0; j < 5; j++) expect(outputs[i][j]).to.be.closeTo(expected[i][j], 0.0001);
+				}
+			});
+		});
+	});
+	describe('Sparse Inputs', function() {
+		it('should match dense runs', function() {
+			var ann = createANN({ layers: [ 6, 4, 3 ] });
+			var expected = ann.run([ 0, 1, 0, 0, 0.5, 0 ]);
+			var outputs = ann.run({ indices: [ 1, 4 ], values: [ 1, 0.5 ] });
+			for (var i = 0; i < 3; i++) expect(outputs[i]).to.be.closeTo(expected[i], 0.0001);
+			var expectedEmpty = ann.run([ 0, 0, 0, 0, 0, 0 ]);
+			var rows = ann.runBatch({ rowOffsets: [ 0, 2, 2 ], indices: new Uint32Array([ 1, 4 ]), values: [ 1, 0.5 ] });
+			expect(rows).to.have.lengthOf(6);
+			for (var j = 0; j < 3; j++) {
+				expect(rows[j]).to.be.closeTo(expected[j], 0.0001);
+				expect(rows[j + 3]).to.be.closeTo(expectedEmpty[j], 0.0001);
+			}
+			expect(function() { ann.run({ indices: [ 6 ], values: [ 1 ] }); }).to.throw(XError);
+			return ann.runAsync({ indices: [ 1, 4 ], values: [ 1, 0.5 ] })
+				.then(function(asyncOutputs) {
+					for (var k = 0; k < 3; k++) expect(asyncOutputs[k]).to.be.closeTo(expected[k], 0.0001);
+				});
+		});
+		it('should train on sparse training data', function() {
+			var ann = createANN({ layers: [ 8, 4, 1 ] });
+			ann.setOption('learningRate', 0.7);
+			var data = fanny.createSparseTrainingData([
+				{ input: { indices: [ 0, 5 ], values: [ 1, 1 ] }, output: [ 1 ] },
+				{ input: { indices: [ 2 ], values: [ 1 ] }, output: [ 0 ] },
+				{ input: { indices: [ 5, 7 ], values: [ 1, 1 ] }, output: [ 1 ] },
+				{ input: { indices: [ 3 ], values: [ 1 ] }, output: [ 0 ] }
+			], 8);
+			expect(data.getLength()).to.equal(4);
+			expect(data.getNumInputs()).to.equal(8);
+			var firstMSE;
+			return ann.train(data, { maxEpochs: 1 })
+				.then(function(mse) {
+					firstMSE = mse;
+					return ann.train(data, { maxEpochs: 500 });
+				})
+				.then(function(mse) {
+					expect(mse).to.be.below(firstMSE);
+					expect(ann.run({ indices: [ 0, 5 ], values: [ 1, 1 ] })[0]).to.be.above(0.5);
+					expect(ann.run({ indices: [ 2 ], values: [ 1 ] })[0]).to.be.below(0.5);
+				});
+		});
+	});
 	describe('Activation Steepness', function() {
 		it('can get activation steepness', function() {
 			var ann = createANN({ layers: [ 2, 3, 5 ] });
@@ -583,5 +856,334 @@ describe('Tests', function() {
 		});
 	});
 
+	describe('Training State', function() {
+		it('can save and load training state', function() {
+			var ann = createANN({ layers: [ 2, 10, 5 ] });
+			return ann.train(booleanTrainingData, { maxEpochs: 20, desiredError: 0 })
+				.then(function() { return ann.save('/tmp/fanny_test_train_state', { trainState: true }); })
+				.then(function() { return loadANN('/tmp/fanny_test_train_state', 'float', { trainState: true }); })
+				.then(function(loaded) {
+					expect(loaded.getTrainState().equals(ann.getTrainState())).to.equal(true);
+				});
+		});
+
+		it('can export and import training state', function() {
+			var ann = createANN({ layers: [ 2, 10, 5 ] });
+			return ann.train(booleanTrainingData, { maxEpochs: 20, desiredError: 0 })
+				.then(function() {
+					var state = ann.getTrainState();
+					expect(Buffer.isBuffer(state)).to.equal(true);
+					expect(ann.clone().getTrainState().equals(state)).to.equal(true);
+					var other = createANN({ layers: [ 2, 10, 5 ] });
+					other.setWeightArray(ann.getConnectionArray());
+					other.setTrainState(state);
+					expect(function() { createANN({ layers: [ 2, 3, 5 ] }).setTrainState(state); }).to.throw(XError);
+					other.setOptions({ trainingAlgorithm: 'QUICKPROP' });
+					expect(function() { other.setTrainState(state); }).to.throw(XError);
+				});
+		});
+	});
+
+	describe('Async Construction', function() {
+		it('can create an ANN asynchronously', function() {
+			return fanny.createANNAsync({ layers: [ 2, 20, 5 ], activationFunctions: { output: 'SIGMOID' } })
+				.then(function(ann) {
+					expect(ann.info.numInput).to.equal(2);
+					expect(ann.info.numOutput).to.equal(5);
+					expect(ann.getActivationFunction(2, 0)).to.equal('SIGMOID');
+					return ann.train(booleanTrainingData, { desiredError: 0, stopFunction: 'BIT' });
+				});
+		});
+
+		it('can clone and initialize weights asynchronously', function() {
+			var ann = createANN({ layers: [ 2, 10, 5 ] });
+			var clone;
+			return ann.randomizeWeightsAsync(-0.5, 0.5)
+				.then(function() { return ann.cloneAsync(); })
+				.then(function(_clone) {
+					clone = _clone;
+					expect(clone.run([ 1, 0 ])).to.deep.equal(ann.run([ 1, 0 ]));
+					return clone.initWeightsAsync(createTrainingData(booleanTrainingData));
+				})
+				.then(function() {
+					expect(clone.run([ 1, 0 ])).to.not.deep.equal(ann.run([ 1, 0 ]));
+				});
+		});
+	});
+
+	describe('Datatype Conversion', function() {
+		it('can convert a double ANN to float', function() {
+			var ann = createANN({ layers: [ 2, 10, 5 ], datatype: 'double' });
+			ann.userData.foo = 'bar';
+			return ann.train(createTrainingData(booleanTrainingData, 'double'), { maxEpochs: 20, desiredError: 0 })
+				.then(function() { return ann.toDatatype('float'); })
+				.then(function(floatANN) {
+					expect(floatANN._datatype).to.equal('float');
+					expect(floatANN.userData).to.deep.equal({ foo: 'bar' });
+					var expected = ann.run([ 1, 0 ]);
+					var actual = floatANN.run([ 1, 0 ]);
+					for (var i = 0; i < expected.length; ++i) {
+						expect(actual[i]).to.be.closeTo(expected[i], 0.0001);
+					}
+				});
+		});
+
+		it('can round trip an ANN through a buffer', function() {
+			var ann = createANN({ layers: [ 2, 3, 1 ] });
+			return ann.toBuffer()
+				.then(function(buffer) { return fanny.loadANNFromBuffer(buffer); })
+				.then(function(loaded) {
+					expect(loaded.run([ 1, 1 ])).to.deep.equal(ann.run([ 1, 1 ]));
+				});
+		});
+	});
+
+	describe('Model Files', function() {
+		it('can save and load a memory-mapped model file', function() {
+			var ann = createANN({ layers: [ 2, 10, 5 ] });
+			ann.userData.foo = 'bar';
+			return ann.save('/tmp/fanny_test_model', { mmap: true })
+				.then(function() { return loadANN('/tmp/fanny_test_model', 'float', { mmap: true }); })
+				.then(function(loaded) {
+					expect(loaded.userData).to.deep.equal({ foo: 'bar' });
+					expect(loaded.getConnectionArray()).to.deep.equal(ann.getConnectionArray());
+					expect(loaded.run([ 1, 0 ])).to.deep.equal(ann.run([ 1, 0 ]));
+					return loaded.train(booleanTrainingData, { maxEpochs: 20, desiredError: 0 })
+						.then(function() { return loadANN('/tmp/fanny_test_model', 'float', { mmap: true }); })
+						.then(function(reloaded) {
+							// Training copied the pages it wrote, leaving the file unchanged
+							expect(reloaded.run([ 1, 0 ])).to.deep.equal(ann.run([ 1, 0 ]));
+							expect(loaded.run([ 1, 0 ])).to.not.deep.equal(ann.run([ 1, 0 ]));
+						});
+				});
+		});
+
+		it('keeps running on a mapped model file that is saved over', function() {
+			var ann = createANN({ layers: [ 2, 10, 5 ] });
+			var replacement = createANN({ layers: [ 2, 10, 5 ] });
+			var mapped;
+			return ann.save('/tmp/fanny_test_model_overwrite', { mmap: true })
+				.then(function() { return loadANN('/tmp/fanny_test_model_overwrite', 'float', { mmap: true }); })
+				.then(function(loaded) {
+					mapped = loaded;
+					return replacement.save('/tmp/fanny_test_model_overwrite', { mmap: true });
+				})
+				.then(function() {
+					expect(mapped.run([ 1, 0 ])).to.deep.equal(ann.run([ 1, 0 ]));
+					expect(mapped.getConnectionArray()).to.deep.equal(ann.getConnectionArray());
+					return loadANN('/tmp/fanny_test_model_overwrite', 'float', { mmap: true });
+				})
+				.then(function(reloaded) {
+					expect(reloaded.run([ 1, 0 ])).to.deep.equal(replacement.run([ 1, 0 ]));
+				});
+		});
+
+		it('can reload a network while it is running', function() {
+			var ann = createANN({ layers: [ 2, 10, 5 ] });
+			var replacement = createANN({ layers: [ 2, 4, 5 ] });
+			var oldOutputs = ann.run([ 1, 0 ]);
+			var newOutputs = replacement.run([ 1, 0 ]);
+			var expectOutputs = function(outputs, expected) {
+				for (var i = 0; i < 5; i++) expect(outputs[i]).to.be.closeTo(expected[i], 0.0001);
+			};
+			var release, before, reloading, after;
+			return replacement.save('/tmp/fanny_test_reload')
+				.then(function() {
+					// Hold the queue, so the run and the swap queue up behind it
+					ann._holdOpQueue(function() {}, new Promise(function(resolve) { release = resolve; }));
+					before = ann.runAsync([ 1, 0 ]);
+					reloading = ann.reloadFrom('/tmp/fanny_test_reload');
+					// Wait for the new network to load, and its swap to be queued behind the run
+					return new Promise(function(resolve) {
+						(function poll() {
+							if (ann._opQueue.length === 2) return resolve();
+							setTimeout(poll, 5);
+						})();
+					});
+				})
+				.then(function() {
+					after = ann.runAsync([ 1, 0 ]);
+					release();
+				})
+				.then(function() {
+					// The first run is in progress, with the swap and the second run still queued
+					expect(ann._opQueue.length).to.equal(2);
+					expectOutputs(ann.run([ 1, 0 ]), oldOutputs);
+					return Promise.all([ before, reloading, after ]);
+				})
+				.then(function(results) {
+					expectOutputs(results[0], oldOutputs);
+					expectOutputs(results[2], newOutputs);
+					expect(ann.info.totalNeurons).to.equal(replacement.info.totalNeurons);
+					expectOutputs(ann.run([ 1, 0 ]), newOutputs);
+					return createANN({ layers: [ 3, 4, 5 ] }).toBuffer();
+				})
+				.then(function(buffer) { return ann.reloadFrom(buffer); })
+				.then(function() {
+					throw new Error('Should have failed');
+				}, function(err) {
+					expect(err).to.be.instanceof(XError);
+					expectOutputs(ann.run([ 1, 0 ]), newOutputs);
+				});
+		});
+
+		it('reports training progress for a reloaded network', function() {
+			var ann = createANN({ layers: [ 2, 10, 5 ] });
+			var replacement = createANN({ layers: [ 2, 4, 5 ] });
+			var calls = 0;
+			return ann.train(booleanTrainingData, { maxEpochs: 2, desiredError: 0 }, function() {})
+				.then(function() { return replacement.save('/tmp/fanny_test_reload_progress'); })
+				.then(function() { return ann.reloadFrom('/tmp/fanny_test_reload_progress'); })
+				.then(function() {
+					return ann.train(booleanTrainingData, { maxEpochs: 3, desiredError: 0 }, function(info) {
+						calls++;
+						expect(info.neurons).to.equal(replacement.info.totalNeurons);
+					});
+				})
+				.then(function() {
+					expect(calls).to.equal(3);
+				});
+		});
+	});
+
+	describe('Ensemble', function() {
+		it('should average the outputs of its members', function() {
+			var anns = [ 1, 2, 3 ].map(function() { return createANN({ layers: [ 2, 4, 5 ] }); });
+			var ensemble = fanny.createEnsemble(anns);
+			expect(ensemble.info.numMembers).to.equal(3);
+			var outputs = ensemble.run([ 1, 0 ]);
+			var memberOutputs = anns.map(function(ann) { return ann.run([ 1, 0 ]); });
+			for (var i = 0; i < 5; i++) {
+				var mean = (memberOutputs[0][i] + memberOutputs[1][i] + memberOutputs[2][i]) / 3;
+				expect(outputs[i]).to.be.closeTo(mean, 0.0001);
+			}
+			return ensemble.runAsync(new Float32Array([ 1, 0 ]))
+				.then(function(asyncOutputs) {
+					for (var i = 0; i < 5; i++) expect(asyncOutputs[i]).to.be.closeTo(outputs[i], 0.0001);
+				});
+		});
+		it('should support weighted means and votes', function() {
+			var anns = [ 1, 2 ].map(function() { return createANN({ layers: [ 2, 4, 5 ] }); });
+			var weighted = fanny.createEnsemble(anns, { mode: 'weighted', weights: [ 1, 0 ] });
+			var expected = anns[0].run([ 0, 1 ]);
+			var outputs = weighted.run([ 0, 1 ]);
+			for (var i = 0; i < 5; i++) expect(outputs[i]).to.be.closeTo(expected[i], 0.0001);
+			var votes = fanny.createEnsemble(anns, { mode: 'vote' }).run([ 0, 1 ]);
+			expect(votes.reduce(function(a, b) { return a + b; })).to.be.closeTo(1, 0.0001);
+			expect(function() { fanny.createEnsemble(anns, { mode: 'weighted' }); }).to.throw(XError);
+			expect(function() { fanny.createEnsemble(anns, { weights: [ 1, 0 ] }); }).to.throw(XError.INVALID_ARGUMENT);
+			expect(function() { fanny.createEnsemble(anns, { mode: 'mean', weights: [ 1, 0 ] }); }).to.throw(XError.INVALID_ARGUMENT);
+			expect(function() {
+				fanny.createEnsemble([ anns[0], createANN({ layers: [ 3, 5 ] }) ]);
+			}).to.throw(XError);
+		});
+		it('should run a member listed more than once only once', function() {
+			var anns = [ 1, 2 ].map(function() { return createANN({ layers: [ 2, 4, 5 ] }); });
+			var ensemble = fanny.createEnsemble([ anns[0], anns[0], anns[1] ]);
+			var first = anns[0].run([ 1, 0 ]);
+			var second = anns[1].run([ 1, 0 ]);
+			return ensemble.runAsync([ 1, 0 ])
+				.then(function(outputs) {
+					for (var i = 0; i < 5; i++) expect(outputs[i]).to.be.closeTo((2 * first[i] + second[i]) / 3, 0.0001);
+				});
+		});
+	});
+
+	describe('Quantization', function() {
+		it('can quantize to 8 bits', function() {
+			var ann = createANN({ layers: [ 2, 20, 5 ] });
+			var data = createTrainingData(booleanTrainingData);
+			return ann.train(data, { desiredError: 0, stopFunction: 'BIT' })
+				.then(function() { return ann.quantize(data); })
+				.then(function(quantized) {
+					expect(quantized.info.bits).to.equal(8);
+					expect(quantized.report.quantizedBytes).to.be.below(quantized.report.floatBytes);
+					expect(quantized.report.maxAbsDiff).to.be.below(0.1);
+					expect(booleanThreshold(quantized.run([ 1, 1 ]))).to.deep.equal([ 1, 1, 0, 0, 0 ]);
+					expect(booleanThreshold(quantized.run([ 1, 0 ]))).to.deep.equal([ 0, 1, 1, 0, 1 ]);
+				});
+		});
+
+		it('can quantize shortcut networks to 16 bits', function() {
+			var ann = createANN({ layers: [ 2, 5, 5 ], type: 'shortcut' });
+			return ann.quantize(booleanTrainingData, { bits: 16 })
+				.then(function(quantized) {
+					expect(quantized.info.bits).to.equal(16);
+					expect(quantized.report.maxAbsDiff).to.be.below(0.01);
+				});
+		});
+
+		it('can serialize and load a quantized network', function() {
+			var ann = createANN({ layers: [ 2, 10, 5 ] });
+			return ann.quantize(booleanTrainingData)
+				.then(function(quantized) {
+					var loaded = fanny.loadQuantizedANN(quantized.toBuffer());
+					expect(loaded.info).to.deep.equal(quantized.info);
+					expect(loaded.run([ 1, 0 ])).to.deep.equal(quantized.run([ 1, 0 ]));
+					expect(function() { fanny.loadQuantizedANN(quantized.toBuffer().slice(0, 20)); }).to.throw(XError);
+				});
+		});
+	});
+
+	describe('Shared networks', function() {
+		it('can run a shared network in a worker thread', function() {
+			var Worker = require('worker_threads').Worker;
+			var ann = createANN({ layers: [ 2, 5, 5 ] });
+			var expected = ann.run([ 1, 0 ]);
+			var shared = ann.share();
+			expect(shared.handle.buffer.byteLength).to.equal(1);
+			ann.randomizeWeights(-1, 1);
+			var outputs = new fanny.SharedANN(shared.handle).run([ 1, 0 ]);
+			for (var i = 0; i < 5; i++) expect(outputs[i]).to.be.closeTo(expected[i], 0.0001);
+			var worker = new Worker(
+				'var workerThreads = require("worker_threads");' +
+				'var shared = new (require(' + JSON.stringify(__dirname + '/../lib') + ').SharedANN)(workerThreads.workerData);' +
+				'workerThreads.parentPort.postMessage(shared.run([ 1, 0 ]));',
+				{ eval: true, workerData: shared.handle }
+			);
+			return new Promise(function(resolve, reject) {
+				worker.on('message', resolve);
+				worker.on('error', reject);
+			}).then(function(workerOutputs) {
+				for (var i = 0; i < 5; i++) expect(workerOutputs[i]).to.be.closeTo(expected[i], 0.0001);
+			});
+		});
+	});
+
+	describe('Checkpoints', function() {
+		it('can write checkpoints to a file and resume from them', function() {
+			var ann = createANN({ layers: [ 2, 10, 5 ] });
+			var trainOptions = {
+				maxEpochs: 50,
+				desiredError: 0,
+				checkpoint: { epochs: 10, filename: '/tmp/fanny_test_checkpoint' }
+			};
+			return ann.train(booleanTrainingData, trainOptions)
+				.then(function() { return fanny.loadCheckpoint('/tmp/fanny_test_checkpoint'); })
+				.then(function(checkpointANN) {
+					expect(checkpointANN.checkpoint.epochs).to.equal(50);
+					expect(checkpointANN.run([ 1, 0 ])).to.deep.equal(ann.run([ 1, 0 ]));
+					return checkpointANN.train(booleanTrainingData, { maxEpochs: 10, desiredError: 0 });
+				});
+		});
+
+		it('can keep checkpoints in memory', function() {
+			var ann = createANN({ layers: [ 2, 10, 5 ] });
+			var trainOptions = {
+				maxEpochs: 50,
+				desiredError: 0,
+				checkpoint: { epochs: 10, ringSize: 3 }
+			};
+			return ann.train(booleanTrainingData, trainOptions)
+				.then(function() {
+					var checkpoints = ann.getCheckpoints();
+					expect(checkpoints.map(function(c) { return c.epochs; })).to.deep.equal([ 30, 40, 50 ]);
+					var restored = ann.getCheckpoint();
+					expect(restored.run([ 1, 1 ])).to.deep.equal(ann.run([ 1, 1 ]));
+					expect(function() { ann.getCheckpoint(3); }).to.throw(XError);
+				});
+		});
+	});
+
 
 });
@@ -52,6 +52,61 @@ describe('Training Data', function() {
 				expect(td._datatype).to.equal('float');
 			});
 	});
+	it('#loadTrainingData threads', function() {
+		return Promise.all([
+			loadTrainingData('test/resources/training-data.txt', 'float', { threads: 4 }),
+			loadTrainingData('test/resources/training-data.txt', 'float', { threads: 0 })
+		]).then(([ parsed, fannRead ]) => {
+			expect(parsed.getLength()).to.equal(fannRead.getLength());
+			expect(parsed.getInputData()).to.deep.equal(fannRead.getInputData());
+			expect(parsed.getOutputData()).to.deep.equal(fannRead.getOutputData());
+		});
+	});
+	it('#loadTrainingData threads with values after the last row', function() {
+		fs.writeFileSync('/tmp/fanny_test_trailing.txt', '2 1 1\n1 2\n3 4\n5 6\n');
+		return Promise.all([
+			loadTrainingData('/tmp/fanny_test_trailing.txt', 'float', { threads: 2 }),
+			loadTrainingData('/tmp/fanny_test_trailing.txt', 'float')
+		]).then(([ parsed, fannRead ]) => {
+			expect(parsed.getInputData()).to.deep.equal([ [ 1 ], [ 3 ] ]);
+			expect(parsed.getOutputData()).to.deep.equal(fannRead.getOutputData());
+		});
+	});
+	it('#loadTrainingData threads with a malformed header', function() {
+		var headers = [ '1 4294967295 1', '4294967295 4294967295 4294967295', '2 1' ];
+		return Promise.all(headers.map((header, idx) => {
+			var filename = '/tmp/fanny_test_header_' + idx + '.txt';
+			fs.writeFileSync(filename, header + '\n1 2\n');
+			return loadTrainingData(filename, 'float', { threads: 2 }).then(() => {
+				throw new Error('Should have failed');
+			}, (err) => {
+				expect(err).to.be.instanceof(XError);
+			});
+		}));
+	});
+	it('#loadTrainingDataFromStream', function() {
+		var chunks = [
+			{ inputs: new Float32Array([ 1, 0, 0, 1 ]), outputs: new Float32Array([ 0, 1, 1, 0, 1, 0, 1, 1, 0, 1 ]) },
+			booleanTrainingData[2],
+			{ input: [ 1, 1 ], output: [ 1, 1, 0, 0, 0 ] }
+		];
+		return fanny.loadTrainingDataFromStream(zstreams.fromArray(chunks), 2, 5)
+			.then((td) => {
+				expect(td.getLength()).to.equal(4);
+				expect(td.getInputData()).to.deep.equal(booleanInputData);
+				expect(td.getOutputData()).to.deep.equal(booleanOutputData);
+			});
+	});
+	it('TrainingDataWriter rejects partial rows', function() {
+		var writer = fanny.createTrainingDataWriter(2, 5);
+		return new Promise(function(resolve) {
+			writer.on('error', resolve);
+			writer.write({ inputs: [ 1, 0, 1 ], outputs: [ 0, 1, 1, 0, 1 ] });
+		})
+			.then((err) => {
+				expect(err).to.be.an.instanceof(XError);
+			});
+	});
 	describe('prototype functions', function() {
 		it('#getLength', function() {
 			var td = createTrainingData(booleanTrainingData, 'float');
@@ -74,6 +129,17 @@ describe('Training Data', function() {
 			var td = createTrainingData(booleanTrainingData, 'float');
 			expect(td.getOutputData()).to.deep.equal(booleanOutputData);
 		});
+		it('#getInputBuffer', function() {
+			var td = createTrainingData(booleanTrainingData, 'float');
+			var inputs = td.getInputBuffer();
+			expect(inputs).to.be.an.instanceof(Float32Array);
+			expect(Array.from(inputs)).to.deep.equal([].concat.apply([], booleanInputData));
+			expect(Array.from(td.getOutputBuffer())).to.deep.equal([].concat.apply([], booleanOutputData));
+			inputs[0] = 0.5;
+			expect(td.getOneInputData(0)[0]).to.equal(0.5);
+			td.subset(0, 1);
+			expect(inputs).to.have.lengthOf(0);
+		});
 		it('#getOneInputData', function() {
 			var td = createTrainingData(booleanTrainingData, 'float');
 			expect(td.getOneInputData(3)).to.deep.equal(booleanInputData[3]);
@@ -169,6 +235,31 @@ describe('Training Data', function() {
 				return td.scale(1, '-1');
 			}).to.throw(XError.INVALID_ARGUMENT);
 		});
+		it('#computeStats', function() {
+			var td = createTrainingData([ [ [ 1, 10 ], [ 0 ] ], [ [ 3, 10 ], [ 1 ] ], [ [ 5, NaN ], [ 1 ] ] ], 'double');
+			var stats = td.computeStats({ threads: 2 });
+			expect(Array.from(stats.input.min)).to.deep.equal([ 1, 10 ]);
+			expect(Array.from(stats.input.max)).to.deep.equal([ 5, 10 ]);
+			expect(Array.from(stats.input.mean)).to.deep.equal([ 3, 10 ]);
+			expect(stats.input.variance[0]).to.be.closeTo(8 / 3, 1e-9);
+			expect(Array.from(stats.input.nanCount)).to.deep.equal([ 0, 1 ]);
+			expect(stats.output.mean[0]).to.be.closeTo(2 / 3, 1e-9);
+			expect(Array.from(td.computeStats({ threads: 1e9 }).input.mean)).to.deep.equal([ 3, 10 ]);
+			[ 0, -1, NaN, 1.5, '2' ].forEach((threads) => {
+				expect(() => td.computeStats({ threads: threads })).to.throw(XError.INVALID_ARGUMENT);
+				expect(() => td.normalize({ threads: threads })).to.throw(XError.INVALID_ARGUMENT);
+			});
+		});
+		it('#normalize', function() {
+			var td = createTrainingData([ [ [ 1, 4 ], [ 0 ] ], [ [ 3, 8 ], [ 1 ] ] ], 'double');
+			var stats = td.normalize({ method: 'minmax', min: -1, max: 1 });
+			expect(td.getInputData()).to.deep.equal([ [ -1, -1 ], [ 1, 1 ] ]);
+			var td2 = createTrainingData([ [ [ 2, 6 ], [ 0 ] ] ], 'double');
+			td2.normalize({ method: 'minmax', min: -1, max: 1, stats: stats });
+			expect(td2.getInputData()).to.deep.equal([ [ 0, 0 ] ]);
+			td.normalize();
+			expect(Array.from(td.computeStats().input.mean)).to.deep.equal([ 0, 0 ]);
+		});
 		it('#subset', function() {
 			var td = createTrainingData(booleanTrainingData, 'float');
 			td.subset(1, 3);
@@ -185,6 +276,11 @@ describe('Training Data', function() {
 				var td = createTrainingData(booleanTrainingData, 'float');
 				return td.subset(1, '1');
 			}).to.throw(XError.INVALID_ARGUMENT);
+
+			expect(function() {
+				var td = createTrainingData(booleanTrainingData, 'float');
+				return td.subset(1, booleanTrainingData.length);
+			}).to.throw();
 		});
 		it('#merge', function() {
 			var td = createTrainingData(booleanTrainingData, 'float');
@@ -196,6 +292,14 @@ describe('Training Data', function() {
 			td.merge(td2);
 			expect(td.getLength()).to.equal(data.length + booleanTrainingData.length);
 		});
+		it('#merge copies rows in order', function() {
+			var td = createTrainingData(booleanTrainingData, 'float');
+			var td2 = createTrainingData(booleanTrainingData, 'float');
+			td2.subset(1, 2);
+			td.merge(td2);
+			expect(td.getInputData()).to.deep.equal(booleanInputData.concat(booleanInputData.slice(1, 3)));
+			expect(td.getOutputData()).to.deep.equal(booleanOutputData.concat(booleanOutputData.slice(1, 3)));
+		});
 		it('#merge Error', function() {
 			expect(function() {
 				var td = createTrainingData(booleanTrainingData, 'float');
@@ -208,12 +312,64 @@ describe('Training Data', function() {
 			expect(td.getOneInputData(0)).to.exist;
 			expect(td.getOneOutputData(0)).to.exist;
 		});
+		it('#shuffle with a seed', function() {
+			var rows = [];
+			for (var i = 0; i < 50; i++) rows.push([ [ i, -i ], [ i * 2 ] ]);
+			var td1 = createTrainingData(rows, 'float');
+			var td2 = createTrainingData(rows, 'float');
+			td1.setSeed(42);
+			td2.setSeed(42);
+			td1.shuffle();
+			return td2.shuffleAsync().then(() => {
+				expect(td2.getInputData()).to.deep.equal(td1.getInputData());
+				expect(td2.getOutputData()).to.deep.equal(td1.getOutputData());
+				var inputs = td1.getInputData();
+				expect(inputs.map((row) => row[0])).to.not.deep.equal(rows.map((row) => row[0][0]));
+				inputs.forEach((row, idx) => {
+					expect(row[1]).to.equal(-row[0]);
+					expect(td1.getOneOutputData(idx)[0]).to.equal(row[0] * 2);
+				});
+			});
+		});
+		it('#shuffleAsync while the data is in use', function() {
+			var rows = [];
+			for (var i = 0; i < 50; i++) rows.push([ [ i, -i ], [ i * 2 ] ]);
+			var td = createTrainingData(rows, 'float');
+			var first = td.shuffleAsync();
+			var second = td.shuffleAsync();
+			expect(() => td.shuffle()).to.throw(XError);
+			expect(() => td.setData([ [ 0, 1 ] ], [ [ 1 ] ])).to.throw(XError);
+			return second
+				.then(() => {
+					throw new Error('Should have failed');
+				}, (err) => {
+					expect(err).to.be.instanceof(XError);
+					return first;
+				})
+				.then(() => td.shuffleAsync())
+				.then(() => {
+					var inputs = td.getInputData();
+					expect(inputs.map((row) => row[0]).sort((a, b) => a - b)).to.deep.equal(rows.map((row) => row[0][0]));
+					inputs.forEach((row, idx) => {
+						expect(row[1]).to.equal(-row[0]);
+						expect(td.getOneOutputData(idx)[0]).to.equal(row[0] * 2);
+					});
+				});
+		});
 		it('#clone', function() {
 			var td = createTrainingData(booleanTrainingData, 'float');
 			var tdClone = td.clone();
 			expect(tdClone.getInputData()).to.deep.equal(td.getInputData());
 			expect(tdClone.getOutputData()).to.deep.equal(td.getOutputData());
 		});
+		it('#toDatatype', function() {
+			var td = createTrainingData(booleanTrainingData, 'float');
+			var tdDouble = td.toDatatype('double');
+			expect(tdDouble._datatype).to.equal('double');
+			expect(tdDouble.getInputData()).to.deep.equal(booleanInputData);
+			expect(tdDouble.getOutputData()).to.deep.equal(booleanOutputData);
+			expect(() => td.toDatatype('fixed')).to.throw(XError);
+		});
 		it('#setData', function() {
 			var inputData = [ [ 0, 1 ] ];
 			var outputData = [ [ 1, 0, 1, 0, 0 ] ];